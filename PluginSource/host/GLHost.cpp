@@ -0,0 +1,328 @@
+// Headless OpenGL host for RenderingPlugin: like PluginHost, but the plugin runs its
+// real OpenGL core backend (RenderAPI_OpenGLCoreES.cpp) in a HeadlessGLContext. With
+// Mesa's llvmpipe this needs neither a display nor a GPU:
+//
+//   LIBGL_ALWAYS_SOFTWARE=1 ./GLHost --frames 300 --quiet
+//
+// Every frame ends with glFinish, standing in for the swap, so the "frame" stage is the
+// end-to-end time including the GL work. Afterwards the individual GL stages are timed
+// through a second RenderAPI instance on the same context (--stage-frames N, 0 to skip):
+// the glTexSubImage2D upload of the texture, DrawSimpleTriangles and the vertex buffer
+// update, each followed by glFinish so that the driver's deferred work is counted.
+//
+// The checksums printed with --checksum match the ones of PluginHost for the same options.
+
+#include "HeadlessGLContext.h"
+#include "HostCommon.h"
+#include "MockUnityInterfaces.h"
+#include "PluginExports.h"
+#include "PluginKernels.h"
+#include "RenderAPI.h"
+#include "RenderAPI_Null.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+struct GLFrameState
+{
+	HeadlessGLContext* context;
+	GLuint texture;
+	int textureWidth;
+	int textureHeight;
+	PluginTextureFormat textureFormat;
+	GLuint vertexBuffer;
+	int vertexBufferSize;
+	std::vector<GLuint> extraTextures;		// registered with AddTextureFromUnity
+	int extraTextureSize;
+	std::vector<GLuint> extraVertexBuffers;	// registered with AddMeshFromUnity
+	int extraVertexBufferSize;
+	bool printChecksums;
+};
+
+
+// Texture storage and pixel transfer format of each PluginTextureFormat
+static GLenum GetGLInternalFormat(PluginTextureFormat format)
+{
+	switch (format)
+	{
+	case kPluginTextureFormat_R8: return GL_R8;
+	case kPluginTextureFormat_RG8: return GL_RG8;
+	default: return GL_RGBA8;
+	}
+}
+
+static GLenum GetGLFormat(PluginTextureFormat format)
+{
+	switch (format)
+	{
+	case kPluginTextureFormat_R8: return GL_RED;
+	case kPluginTextureFormat_RG8: return GL_RG;
+	case kPluginTextureFormat_BGRA8: return GL_BGRA;
+	default: return GL_RGBA;
+	}
+}
+
+
+static GLuint CreateGLTexture(int width, int height, PluginTextureFormat format)
+{
+	GLuint texture = 0;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GetGLInternalFormat(format), width, height, 0, GetGLFormat(format), GL_UNSIGNED_BYTE, NULL);
+	return texture;
+}
+
+static GLuint CreateGLVertexBuffer(int size)
+{
+	GLuint buffer = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return buffer;
+}
+
+// Continues 'checksum' with the contents of the buffer
+static unsigned int ChecksumGLBuffer(GLuint buffer, int size, unsigned int checksum)
+{
+	std::vector<unsigned char> data(size);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, size, &data[0]);
+	return NullChecksum(&data[0], data.size(), checksum);
+}
+
+// Continues 'checksum' with the contents of the texture
+static unsigned int ChecksumGLTexture(GLuint texture, int width, int height, PluginTextureFormat format, unsigned int checksum)
+{
+	std::vector<unsigned char> pixels(size_t(width) * height * GetPluginTextureFormatBytesPerPixel(format));
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GetGLFormat(format), GL_UNSIGNED_BYTE, &pixels[0]);
+	return NullChecksum(&pixels[0], pixels.size(), checksum);
+}
+
+
+static void BeginFrame(int, void* userData)
+{
+	((GLFrameState*)userData)->context->BindFramebuffer();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+
+static void EndFrame(int, void*)
+{
+	glFinish();
+}
+
+
+static void PrintChecksums(int frame, void* userData)
+{
+	GLFrameState& state = *(GLFrameState*)userData;
+	if (!state.printChecksums)
+		return;
+
+	unsigned int textureChecksum = 0;
+	if (state.texture)
+		textureChecksum = ChecksumGLTexture(state.texture, state.textureWidth, state.textureHeight, state.textureFormat, kNullChecksumSeed);
+	unsigned int vertexChecksum = 0;
+	if (state.vertexBuffer)
+		vertexChecksum = ChecksumGLBuffer(state.vertexBuffer, state.vertexBufferSize, kNullChecksumSeed);
+
+	printf("frame %5d: texture checksum %08x, vertex buffer checksum %08x", frame, textureChecksum, vertexChecksum);
+	if (!state.extraTextures.empty())
+	{
+		unsigned int checksum = kNullChecksumSeed;
+		for (size_t i = 0; i < state.extraTextures.size(); ++i)
+			checksum = ChecksumGLTexture(state.extraTextures[i], state.extraTextureSize, state.extraTextureSize, state.textureFormat, checksum);
+		printf(", %d more textures checksum %08x", int(state.extraTextures.size()), checksum);
+	}
+	if (!state.extraVertexBuffers.empty())
+	{
+		unsigned int checksum = kNullChecksumSeed;
+		for (size_t i = 0; i < state.extraVertexBuffers.size(); ++i)
+			checksum = ChecksumGLBuffer(state.extraVertexBuffers[i], state.extraVertexBufferSize, checksum);
+		printf(", %d more meshes checksum %08x", int(state.extraVertexBuffers.size()), checksum);
+	}
+	printf("\n");
+}
+
+
+// Times the GL work of the render event stage by stage, on a RenderAPI instance of the host's own.
+static void TimeGLStages(const HostOptions& options, GLFrameState& state, const HostMesh& mesh, int frameCount)
+{
+	RenderAPI* api = CreateRenderAPI(kUnityGfxRendererOpenGLCore);
+	if (!api)
+		return;
+	api->ProcessDeviceEvent(kUnityGfxDeviceEventInitialize, NULL);
+
+	MeshVertexStreams source;
+	if (state.vertexBuffer && options.vertexArray)
+		ReferenceMeshSource(source, mesh.vertexCount, (const MeshSourceVertex*)mesh.interleaved.data());
+	else if (state.vertexBuffer)
+		CopyMeshSource(source, mesh.vertexCount, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+
+	StageTimings fill("plasma fill");
+	StageTimings upload("glTexSubImage2D");
+	StageTimings draw("DrawSimpleTriangles");
+	StageTimings vertices("vertex update");
+	void* textureHandle = (void*)(size_t)state.texture;
+	void* bufferHandle = (void*)(size_t)state.vertexBuffer;
+	float time = 0.0f;
+	for (int frame = 0; frame < frameCount; ++frame, time += options.timeStep)
+	{
+		state.context->BindFramebuffer();
+		HostClock::time_point t0 = HostClock::now();
+		DrawColoredTriangle(api, time);
+		glFinish();
+		HostClock::time_point t1 = HostClock::now();
+		draw.Add(ElapsedMicroseconds(t0, t1));
+
+		if (state.texture)
+		{
+			int rowPitch = 0;
+			unsigned char* pixels = (unsigned char*)api->BeginModifyTexture(textureHandle, state.textureWidth, state.textureHeight, state.textureFormat, &rowPitch);
+			if (pixels)
+			{
+				t0 = HostClock::now();
+				FillPlasmaPixels(pixels, state.textureWidth, state.textureHeight, rowPitch, GetPluginTextureFormatBytesPerPixel(state.textureFormat), time);
+				t1 = HostClock::now();
+				fill.Add(ElapsedMicroseconds(t0, t1));
+
+				api->EndModifyTexture(textureHandle, state.textureWidth, state.textureHeight, state.textureFormat, rowPitch, pixels);
+				glFinish();
+				upload.Add(ElapsedMicroseconds(t1, HostClock::now()));
+			}
+		}
+
+		if (state.vertexBuffer)
+		{
+			t0 = HostClock::now();
+			ModifyVertexBuffer(api, bufferHandle, source, time);
+			glFinish();
+			vertices.Add(ElapsedMicroseconds(t0, HostClock::now()));
+		}
+	}
+
+	printf("\nGL stages over %d frames (microseconds, including glFinish):\n", frameCount);
+	draw.PrintSummary();
+	if (state.texture)
+	{
+		fill.PrintSummary();
+		upload.PrintSummary();
+	}
+	if (state.vertexBuffer)
+		vertices.PrintSummary();
+
+	api->ProcessDeviceEvent(kUnityGfxDeviceEventShutdown, NULL);
+	delete api;
+}
+
+
+static void PrintUsage(const char* exe)
+{
+	printf("usage: %s [options]\n", exe);
+	PrintHostOptionsUsage();
+	printf("  --checksum        read back the texture and vertex buffer after every frame and print their checksums\n");
+	printf("  --stage-frames N  frames to time the GL stages on their own afterwards (default 100, 0 to skip)\n");
+}
+
+
+int main(int argc, char** argv)
+{
+	HostOptions options;
+	InitHostOptions(options);
+	GLFrameState state = {};
+	int stageFrames = 100;
+	for (int i = 1; i < argc; ++i)
+	{
+		bool error = false;
+		if (strcmp(argv[i], "--checksum") == 0)
+			state.printChecksums = true;
+		else if (strcmp(argv[i], "--stage-frames") == 0 && i + 1 < argc)
+			stageFrames = atoi(argv[++i]);
+		else if (!ParseHostOption(argc, argv, i, options, error) || error)
+		{
+			if (strcmp(argv[i], "--help") != 0)
+				fprintf(stderr, "invalid argument: %s\n", argv[i]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// The plugin creates its GL resources from UnityPluginLoad, so the context has to be current first
+	HeadlessGLContext context;
+	if (!context.Create(3, 2, 256, 256))
+		return 1;
+	printf("OpenGL renderer: %s\n", context.GetRendererName().c_str());
+	state.context = &context;
+
+	MockUnityInterfaces unity(kUnityGfxRendererOpenGLCore);
+	if (!StartHostTrace(options))
+		return 1;
+	UnityPluginLoad(unity.GetInterfaces());
+
+	// Unity's native handles of GL textures and buffers are the object names
+	state.textureFormat = PluginTextureFormat(options.textureFormat);
+	if (options.textureWidth > 0 && options.textureHeight > 0)
+	{
+		state.textureWidth = options.textureWidth;
+		state.textureHeight = options.textureHeight;
+		state.texture = CreateGLTexture(options.textureWidth, options.textureHeight, state.textureFormat);
+		SetTextureFromUnityWithFormat((void*)(size_t)state.texture, options.textureWidth, options.textureHeight, options.textureFormat);
+	}
+
+	state.extraTextureSize = options.extraTextureSize;
+	for (int i = 0; i < options.extraTextureCount; ++i)
+	{
+		state.extraTextures.push_back(CreateGLTexture(state.extraTextureSize, state.extraTextureSize, state.textureFormat));
+		AddTextureFromUnity((void*)(size_t)state.extraTextures.back(), state.extraTextureSize, state.extraTextureSize, options.textureFormat);
+	}
+
+	HostMesh mesh;
+	if (options.vertexCount > 0)
+	{
+		CreateGridMesh(options.vertexCount, mesh);
+		state.vertexBufferSize = mesh.vertexCount * kMeshVertexSize;
+		state.vertexBuffer = CreateGLVertexBuffer(state.vertexBufferSize);
+		SendHostMeshToPlugin((void*)(size_t)state.vertexBuffer, mesh, options);
+	}
+
+	HostMesh extraMesh;
+	if (options.extraMeshCount > 0)
+	{
+		CreateGridMesh(options.extraMeshVertexCount, extraMesh);
+		state.extraVertexBufferSize = extraMesh.vertexCount * kMeshVertexSize;
+	}
+	for (int i = 0; i < options.extraMeshCount; ++i)
+	{
+		state.extraVertexBuffers.push_back(CreateGLVertexBuffer(state.extraVertexBufferSize));
+		AddHostMeshToPlugin((void*)(size_t)state.extraVertexBuffers.back(), extraMesh, i, options);
+	}
+
+	HostFrameHooks hooks = {};
+	hooks.beginFrame = BeginFrame;
+	hooks.endFrame = EndFrame;
+	hooks.afterFrame = PrintChecksums;
+	hooks.userData = &state;
+	RunPluginFrames(options, hooks);
+	PrintPluginFrameStats();
+
+	if (stageFrames > 0)
+		TimeGLStages(options, state, mesh, stageFrames);
+
+	unity.SendDeviceEvent(kUnityGfxDeviceEventShutdown);
+	UnityPluginUnload();
+	StopHostTrace(options);
+	glDeleteBuffers(1, &state.vertexBuffer);
+	glDeleteTextures(1, &state.texture);
+	if (!state.extraTextures.empty())
+		glDeleteTextures(GLsizei(state.extraTextures.size()), state.extraTextures.data());
+	if (!state.extraVertexBuffers.empty())
+		glDeleteBuffers(GLsizei(state.extraVertexBuffers.size()), state.extraVertexBuffers.data());
+	context.Destroy();
+	return 0;
+}
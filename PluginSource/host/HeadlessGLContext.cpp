@@ -0,0 +1,145 @@
+#include "HeadlessGLContext.h"
+
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <string.h>
+
+
+HeadlessGLContext::HeadlessGLContext()
+	: m_Display(EGL_NO_DISPLAY)
+	, m_Context(EGL_NO_CONTEXT)
+	, m_Framebuffer(0)
+	, m_ColorBuffer(0)
+	, m_DepthBuffer(0)
+	, m_Width(0)
+	, m_Height(0)
+{
+}
+
+
+HeadlessGLContext::~HeadlessGLContext()
+{
+	Destroy();
+}
+
+
+static bool HasExtension(const char* extensions, const char* name)
+{
+	const size_t length = strlen(name);
+	for (const char* p = extensions; p && (p = strstr(p, name)) != NULL; p += length)
+	{
+		if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+
+bool HeadlessGLContext::Create(int major, int minor, int width, int height)
+{
+	// Prefer the surfaceless platform, it works without any display server
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay && HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+		m_Display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if (m_Display == EGL_NO_DISPLAY)
+		m_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint eglMajor = 0, eglMinor = 0;
+	if (m_Display == EGL_NO_DISPLAY || !eglInitialize(m_Display, &eglMajor, &eglMinor))
+	{
+		fprintf(stderr, "failed to initialize EGL (0x%x)\n", eglGetError());
+		return false;
+	}
+	const char* displayExtensions = eglQueryString(m_Display, EGL_EXTENSIONS);
+	if (!HasExtension(displayExtensions, "EGL_KHR_surfaceless_context"))
+	{
+		fprintf(stderr, "EGL_KHR_surfaceless_context is not supported\n");
+		return false;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		fprintf(stderr, "desktop OpenGL is not supported by EGL\n");
+		return false;
+	}
+
+	// No surface, so any config will do; skip it entirely if the implementation allows
+	EGLConfig config = (EGLConfig)0;
+	if (!HasExtension(displayExtensions, "EGL_KHR_no_config_context"))
+	{
+		const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+		EGLint configCount = 0;
+		if (!eglChooseConfig(m_Display, configAttribs, &config, 1, &configCount) || configCount < 1)
+		{
+			fprintf(stderr, "no EGL config with OpenGL support\n");
+			return false;
+		}
+	}
+
+	const EGLint contextAttribs[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, major,
+		EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	m_Context = eglCreateContext(m_Display, config, EGL_NO_CONTEXT, contextAttribs);
+	if (m_Context == EGL_NO_CONTEXT || !eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_Context))
+	{
+		fprintf(stderr, "failed to create an OpenGL %d.%d core context (0x%x)\n", major, minor, eglGetError());
+		return false;
+	}
+
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	const char* version = (const char*)glGetString(GL_VERSION);
+	m_RendererName = std::string(renderer ? renderer : "?") + ", " + (version ? version : "?");
+
+	m_Width = width;
+	m_Height = height;
+	glGenRenderbuffers(1, &m_ColorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_ColorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glGenRenderbuffers(1, &m_DepthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_DepthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glGenFramebuffers(1, &m_Framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		fprintf(stderr, "offscreen framebuffer is incomplete\n");
+		return false;
+	}
+	BindFramebuffer();
+	return true;
+}
+
+
+void HeadlessGLContext::Destroy()
+{
+	if (m_Context != EGL_NO_CONTEXT)
+	{
+		glDeleteFramebuffers(1, &m_Framebuffer);
+		glDeleteRenderbuffers(1, &m_ColorBuffer);
+		glDeleteRenderbuffers(1, &m_DepthBuffer);
+		eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_Display, m_Context);
+	}
+	if (m_Display != EGL_NO_DISPLAY)
+		eglTerminate(m_Display);
+
+	m_Display = EGL_NO_DISPLAY;
+	m_Context = EGL_NO_CONTEXT;
+	m_Framebuffer = 0;
+	m_ColorBuffer = 0;
+	m_DepthBuffer = 0;
+}
+
+
+void HeadlessGLContext::BindFramebuffer()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
+	glViewport(0, 0, m_Width, m_Height);
+	glClearColor(0.0f, 0.0f, 0.25f, 1.0f);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// OpenGL core profile context without a window, for running the plugin's GL backend
+// (RenderAPI_OpenGLCoreES.cpp) on machines without a display or GPU. Uses an EGL
+// surfaceless context, which Mesa provides with its llvmpipe software rasterizer
+// (select it with LIBGL_ALWAYS_SOFTWARE=1 if there is a GPU driver as well).
+//
+// Since there is no window surface, rendering goes to an offscreen framebuffer
+// object that stands in for Unity's back buffer.
+
+#include <EGL/egl.h>
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+
+#include <string>
+
+
+class HeadlessGLContext
+{
+public:
+	HeadlessGLContext();
+	~HeadlessGLContext();
+
+	// Creates a GL 'major.minor' core profile context, makes it current and binds
+	// a width x height color + depth framebuffer. Prints the reason and returns false on failure.
+	bool Create(int major, int minor, int width, int height);
+	void Destroy();
+
+	const std::string& GetRendererName() const { return m_RendererName; }
+
+	// Rebinds the offscreen framebuffer and viewport, like Unity does before a plugin event.
+	void BindFramebuffer();
+
+private:
+	EGLDisplay m_Display;
+	EGLContext m_Context;
+	GLuint m_Framebuffer;
+	GLuint m_ColorBuffer;
+	GLuint m_DepthBuffer;
+	int m_Width;
+	int m_Height;
+	std::string m_RendererName;
+};
@@ -0,0 +1,497 @@
+#include "HostCommon.h"
+#include "PluginExports.h"
+#include "PluginKernels.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+void InitHostOptions(HostOptions& options)
+{
+	options.frameCount = 100;
+	options.eventIDs.clear();
+	options.eventIDs.push_back(1);
+	options.textureWidth = 256;
+	options.textureHeight = 256;
+	options.vertexCount = 4096;
+	options.timeStep = 0.016f;
+	options.printFrames = true;
+	options.tracePath.clear();
+	options.plasmaKernel = -1;
+	options.vertexKernel = -1;
+	options.threadCount = 0;
+	options.vertexParallelThreshold = 0;
+	options.textureFormat = kPluginTextureFormat_RGBA8;
+	options.dirtyRects.clear();
+	options.tileSize = 0;
+	options.tileBytesPerFrame = 0;
+	options.tileMillisecondsPerFrame = 0.0f;
+	options.mathPrecision = kPluginMathPrecision_Exact;
+	options.pipelined = false;
+	options.vertexArray = false;
+	options.extraTextureCount = 0;
+	options.extraTextureSize = 64;
+	options.extraMeshCount = 0;
+	options.extraMeshVertexCount = 256;
+}
+
+
+static bool ParseEventList(const char* text, std::vector<int>& eventIDs)
+{
+	eventIDs.clear();
+	while (*text)
+	{
+		char* end = NULL;
+		long id = strtol(text, &end, 10);
+		if (end == text)
+			return false;
+		eventIDs.push_back(int(id));
+		text = end;
+		if (*text == ',')
+			++text;
+		else if (*text)
+			return false;
+	}
+	return !eventIDs.empty();
+}
+
+
+static bool ParseRectList(const char* text, std::vector<int>& rects)
+{
+	rects.clear();
+	while (*text)
+	{
+		char* end = NULL;
+		long value = strtol(text, &end, 10);
+		if (end == text)
+			return false;
+		rects.push_back(int(value));
+		text = end;
+		if (*text == ',')
+			++text;
+		else if (*text)
+			return false;
+	}
+	return !rects.empty() && rects.size() % 4 == 0;
+}
+
+
+// size[,bytes[,milliseconds]]
+static bool ParseTileUpdate(const char* text, HostOptions& options)
+{
+	options.tileBytesPerFrame = 0;
+	options.tileMillisecondsPerFrame = 0.0f;
+	int fields = sscanf(text, "%d,%d,%f", &options.tileSize, &options.tileBytesPerFrame, &options.tileMillisecondsPerFrame);
+	return fields >= 1 && options.tileSize >= 0 && options.tileBytesPerFrame >= 0 && options.tileMillisecondsPerFrame >= 0.0f;
+}
+
+
+// count[,size]
+static bool ParseExtraTextures(const char* text, HostOptions& options)
+{
+	options.extraTextureSize = 64;
+	int fields = sscanf(text, "%d,%d", &options.extraTextureCount, &options.extraTextureSize);
+	return fields >= 1 && options.extraTextureCount >= 0 && options.extraTextureSize > 0;
+}
+
+
+// count[,vertices]
+static bool ParseExtraMeshes(const char* text, HostOptions& options)
+{
+	options.extraMeshVertexCount = 256;
+	int fields = sscanf(text, "%d,%d", &options.extraMeshCount, &options.extraMeshVertexCount);
+	return fields >= 1 && options.extraMeshCount >= 0 && options.extraMeshVertexCount > 0;
+}
+
+
+static bool ParsePlasmaKernel(const char* text, int& kernel)
+{
+	for (int i = 0; i < kPlasmaKernelCount; ++i)
+	{
+		if (strcmp(text, GetPlasmaKernelName(PlasmaKernel(i))) != 0)
+			continue;
+		if (!IsPlasmaKernelSupported(PlasmaKernel(i)))
+		{
+			fprintf(stderr, "plasma kernel '%s' is not supported on this CPU\n", text);
+			return false;
+		}
+		kernel = i;
+		return true;
+	}
+	return false;
+}
+
+
+static bool ParseVertexKernel(const char* text, int& kernel)
+{
+	for (int i = 0; i < kVertexKernelCount; ++i)
+	{
+		if (strcmp(text, GetVertexKernelName(VertexKernel(i))) != 0)
+			continue;
+		if (!IsVertexKernelSupported(VertexKernel(i)))
+		{
+			fprintf(stderr, "vertex kernel '%s' is not supported on this CPU\n", text);
+			return false;
+		}
+		kernel = i;
+		return true;
+	}
+	return false;
+}
+
+
+static const char* const kTextureFormatNames[kPluginTextureFormatCount] = { "rgba8", "bgra8", "r8", "rg8" };
+
+static bool ParseTextureFormat(const char* text, int& format)
+{
+	for (int i = 0; i < kPluginTextureFormatCount; ++i)
+	{
+		if (strcmp(text, kTextureFormatNames[i]) == 0)
+		{
+			format = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+static bool ParseMathPrecision(const char* text, int& precision)
+{
+	if (strcmp(text, "exact") == 0)
+		precision = kPluginMathPrecision_Exact;
+	else if (strcmp(text, "fast") == 0)
+		precision = kPluginMathPrecision_Fast;
+	else
+		return false;
+	return true;
+}
+
+
+bool ParseHostOption(int argc, char** argv, int& i, HostOptions& options, bool& error)
+{
+	const char* arg = argv[i];
+	const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+	error = false;
+
+	if (strcmp(arg, "--quiet") == 0)
+	{
+		options.printFrames = false;
+		return true;
+	}
+	if (strcmp(arg, "--pipelined") == 0)
+	{
+		options.pipelined = true;
+		return true;
+	}
+	if (strcmp(arg, "--vertex-array") == 0)
+	{
+		options.vertexArray = true;
+		return true;
+	}
+
+	if (strcmp(arg, "--frames") != 0 && strcmp(arg, "--events") != 0 && strcmp(arg, "--texture") != 0 &&
+		strcmp(arg, "--vertices") != 0 && strcmp(arg, "--timestep") != 0 && strcmp(arg, "--trace") != 0 &&
+		strcmp(arg, "--plasma") != 0 && strcmp(arg, "--deform") != 0 && strcmp(arg, "--threads") != 0 &&
+		strcmp(arg, "--parallel-vertices") != 0 && strcmp(arg, "--format") != 0 &&
+		strcmp(arg, "--rects") != 0 && strcmp(arg, "--tiles") != 0 &&
+		strcmp(arg, "--math") != 0 && strcmp(arg, "--textures") != 0 && strcmp(arg, "--meshes") != 0)
+		return false;
+
+	if (!value)
+	{
+		error = true;
+		return true;
+	}
+	++i;
+
+	if (strcmp(arg, "--frames") == 0)
+		error = (options.frameCount = atoi(value)) <= 0;
+	else if (strcmp(arg, "--events") == 0)
+		error = !ParseEventList(value, options.eventIDs);
+	else if (strcmp(arg, "--texture") == 0)
+		error = sscanf(value, "%dx%d", &options.textureWidth, &options.textureHeight) != 2 || options.textureWidth < 0 || options.textureHeight < 0;
+	else if (strcmp(arg, "--vertices") == 0)
+		error = (options.vertexCount = atoi(value)) < 0;
+	else if (strcmp(arg, "--timestep") == 0)
+		options.timeStep = float(atof(value));
+	else if (strcmp(arg, "--trace") == 0)
+		options.tracePath = value;
+	else if (strcmp(arg, "--plasma") == 0)
+		error = !ParsePlasmaKernel(value, options.plasmaKernel);
+	else if (strcmp(arg, "--deform") == 0)
+		error = !ParseVertexKernel(value, options.vertexKernel);
+	else if (strcmp(arg, "--threads") == 0)
+		error = (options.threadCount = atoi(value)) < 0;
+	else if (strcmp(arg, "--parallel-vertices") == 0)
+		error = (options.vertexParallelThreshold = atoi(value)) < 0;
+	else if (strcmp(arg, "--format") == 0)
+		error = !ParseTextureFormat(value, options.textureFormat);
+	else if (strcmp(arg, "--rects") == 0)
+		error = !ParseRectList(value, options.dirtyRects);
+	else if (strcmp(arg, "--tiles") == 0)
+		error = !ParseTileUpdate(value, options);
+	else if (strcmp(arg, "--math") == 0)
+		error = !ParseMathPrecision(value, options.mathPrecision);
+	else if (strcmp(arg, "--textures") == 0)
+		error = !ParseExtraTextures(value, options);
+	else if (strcmp(arg, "--meshes") == 0)
+		error = !ParseExtraMeshes(value, options);
+	return true;
+}
+
+
+void PrintHostOptionsUsage()
+{
+	printf("  --frames N        number of frames to run (default 100)\n");
+	printf("  --events A,B,...  render event IDs issued each frame, in order (default 1)\n");
+	printf("  --texture WxH     size of the texture handed to the plugin, 0x0 for none (default 256x256)\n");
+	printf("  --vertices N      vertex count of the mesh handed to the plugin, 0 for none (default 4096)\n");
+	printf("  --timestep S      time passed to SetTimeFromUnity advances by S each frame (default 0.016)\n");
+	printf("  --quiet           only print the summary, not every frame\n");
+	printf("  --trace FILE      record a Chrome trace of the plugin's work into FILE (chrome://tracing, ui.perfetto.dev)\n");
+	printf("  --plasma NAME     texture fill kernel: scalar, sse2, avx2 or tables (default: best the CPU supports)\n");
+	printf("  --deform NAME     vertex deformation kernel: scalar, sse2, avx2 or tables (default: best the CPU supports)\n");
+	printf("  --threads N       threads the texture fill and vertex deformation are spread over, 1 for the render thread only (default: one per core, at most 8)\n");
+	printf("  --parallel-vertices N  deform meshes of at least N vertices on the worker threads (default 32768)\n");
+	printf("  --format NAME     pixel format of the texture: rgba8, bgra8, r8 or rg8 (default rgba8)\n");
+	printf("  --rects X,Y,W,H,...  only update these rects of the texture each frame (default: all of it)\n");
+	printf("  --tiles S[,B[,MS]]  update the texture in SxS tiles, as many per frame as fit into B bytes and MS milliseconds (0: no limit)\n");
+	printf("  --math NAME       precision of the sines in the texture and vertex kernels: exact or fast (default exact)\n");
+	printf("  --textures N[,S]  also register N SxS textures with AddTextureFromUnity, updated in the same batch (default size 64)\n");
+	printf("  --meshes N[,V]    also register N meshes of V vertices with AddMeshFromUnity, deformed in the same batch (default 256 vertices)\n");
+	printf("  --pipelined       generate the texture and vertices of each frame on a background thread from SetTimeFromUnity on\n");
+	printf("  --vertex-array    pass the mesh as one interleaved array the plugin only references (SetMeshVertexArrayFromUnity)\n");
+}
+
+
+void CreateGridMesh(int vertexCount, HostMesh& mesh)
+{
+	int side = int(sqrtf(float(vertexCount)));
+	if (side < 1)
+		side = 1;
+	int rows = (vertexCount + side - 1) / side;
+
+	mesh.vertexCount = vertexCount;
+	mesh.vertices.resize(vertexCount * 3);
+	mesh.normals.resize(vertexCount * 3);
+	mesh.uvs.resize(vertexCount * 2);
+	mesh.interleaved.resize(vertexCount * 8);
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		float u = side > 1 ? float(i % side) / float(side - 1) : 0.0f;
+		float v = rows > 1 ? float(i / side) / float(rows - 1) : 0.0f;
+		mesh.vertices[i * 3 + 0] = (u - 0.5f) * 10.0f;
+		mesh.vertices[i * 3 + 1] = 0.0f;
+		mesh.vertices[i * 3 + 2] = (v - 0.5f) * 10.0f;
+		mesh.normals[i * 3 + 0] = 0.0f;
+		mesh.normals[i * 3 + 1] = 1.0f;
+		mesh.normals[i * 3 + 2] = 0.0f;
+		mesh.uvs[i * 2 + 0] = u;
+		mesh.uvs[i * 2 + 1] = v;
+		memcpy(&mesh.interleaved[i * 8 + 0], &mesh.vertices[i * 3], 3 * sizeof(float));
+		memcpy(&mesh.interleaved[i * 8 + 3], &mesh.normals[i * 3], 3 * sizeof(float));
+		memcpy(&mesh.interleaved[i * 8 + 6], &mesh.uvs[i * 2], 2 * sizeof(float));
+	}
+}
+
+
+void SendHostMeshToPlugin(void* vertexBufferHandle, const HostMesh& mesh, const HostOptions& options)
+{
+	if (options.vertexArray)
+		SetMeshVertexArrayFromUnity(vertexBufferHandle, mesh.vertexCount, (void*)mesh.interleaved.data());
+	else
+		SetMeshBuffersFromUnity(vertexBufferHandle, mesh.vertexCount, (float*)mesh.vertices.data(), (float*)mesh.normals.data(), (float*)mesh.uvs.data());
+}
+
+
+int AddHostMeshToPlugin(void* vertexBufferHandle, const HostMesh& mesh, int index, const HostOptions& options)
+{
+	int id;
+	if (options.vertexArray)
+		id = AddMeshVertexArrayFromUnity(vertexBufferHandle, mesh.vertexCount, (void*)mesh.interleaved.data());
+	else
+		id = AddMeshFromUnity(vertexBufferHandle, mesh.vertexCount, (float*)mesh.vertices.data(), (float*)mesh.normals.data(), (float*)mesh.uvs.data());
+	SetMeshDeformationFromUnity(id, 1.0f, 0.25f * index);
+	return id;
+}
+
+
+void StageTimings::PrintSummary() const
+{
+	if (m_Samples.empty())
+		return;
+
+	std::vector<double> sorted = m_Samples;
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < sorted.size(); ++i)
+		sum += sorted[i];
+
+	const size_t count = sorted.size();
+	printf("%-16s min %10.2f  avg %10.2f  p50 %10.2f  p99 %10.2f  max %10.2f us\n",
+		m_Name.c_str(), sorted[0], sum / count, sorted[count / 2], sorted[std::min(count - 1, count * 99 / 100)], sorted[count - 1]);
+}
+
+
+void RunPluginFrames(const HostOptions& options, HostFrameCallback frameCallback, void* userData)
+{
+	HostFrameHooks hooks = {};
+	hooks.afterFrame = frameCallback;
+	hooks.userData = userData;
+	RunPluginFrames(options, hooks);
+}
+
+
+void RunPluginFrames(const HostOptions& options, const HostFrameHooks& hooks)
+{
+	UnityRenderingEvent renderEvent = GetRenderEventFunc();
+
+	if (options.plasmaKernel >= 0)
+		SetPlasmaKernel(PlasmaKernel(options.plasmaKernel));
+	if (options.vertexKernel >= 0)
+		SetVertexKernel(VertexKernel(options.vertexKernel));
+	SetPluginWorkerThreadCount(options.threadCount);
+	SetPluginVertexParallelThreshold(options.vertexParallelThreshold);
+	SetTextureDirtyRectsFromUnity(options.dirtyRects.data(), int(options.dirtyRects.size() / 4));
+	SetTextureTileUpdateFromUnity(options.tileSize, options.tileBytesPerFrame, options.tileMillisecondsPerFrame);
+	SetPluginPipelinedGeneration(options.pipelined ? 1 : 0);
+	SetPluginMathPrecision(options.mathPrecision);
+	if (options.printFrames)
+		printf("plasma kernel: %s, vertex kernel: %s, %d thread(s)\n", GetPlasmaKernelName(GetPlasmaKernel()),
+			GetVertexKernelName(GetVertexKernel()), GetPluginWorkerThreadCount());
+
+	StageTimings beginFrame("begin frame");
+	StageTimings setTime("SetTimeFromUnity");
+	StageTimings endFrame("end frame");
+	StageTimings frameTotal("frame");
+	std::vector<StageTimings> events;
+	for (size_t i = 0; i < options.eventIDs.size(); ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "event %d", options.eventIDs[i]);
+		events.push_back(StageTimings(name));
+	}
+
+	for (int frame = 0; frame < options.frameCount; ++frame)
+	{
+		HostClock::time_point frameStart = HostClock::now();
+		HostClock::time_point stageEnd = frameStart;
+		if (hooks.beginFrame)
+		{
+			hooks.beginFrame(frame, hooks.userData);
+			stageEnd = HostClock::now();
+			beginFrame.Add(ElapsedMicroseconds(frameStart, stageEnd));
+		}
+
+		HostClock::time_point stageStart = stageEnd;
+		SetTimeFromUnity(float(frame + 1) * options.timeStep);
+		stageEnd = HostClock::now();
+		setTime.Add(ElapsedMicroseconds(stageStart, stageEnd));
+
+		for (size_t i = 0; i < options.eventIDs.size(); ++i)
+		{
+			if (hooks.beforeEvent)
+				hooks.beforeEvent(options.eventIDs[i], hooks.userData);
+			stageStart = stageEnd;
+			renderEvent(options.eventIDs[i]);
+			stageEnd = HostClock::now();
+			events[i].Add(ElapsedMicroseconds(stageStart, stageEnd));
+		}
+
+		if (hooks.endFrame)
+		{
+			stageStart = stageEnd;
+			hooks.endFrame(frame, hooks.userData);
+			stageEnd = HostClock::now();
+			endFrame.Add(ElapsedMicroseconds(stageStart, stageEnd));
+		}
+		frameTotal.Add(ElapsedMicroseconds(frameStart, stageEnd));
+
+		if (options.printFrames)
+		{
+			printf("frame %5d:", frame);
+			if (hooks.beginFrame)
+				printf(" %s %.2f us,", beginFrame.GetName().c_str(), beginFrame.GetLast());
+			printf(" %s %.2f us", setTime.GetName().c_str(), setTime.GetLast());
+			for (size_t i = 0; i < events.size(); ++i)
+				printf(", %s %.2f us", events[i].GetName().c_str(), events[i].GetLast());
+			if (hooks.endFrame)
+				printf(", %s %.2f us", endFrame.GetName().c_str(), endFrame.GetLast());
+			printf(", total %.2f us\n", frameTotal.GetLast());
+		}
+
+		if (hooks.afterFrame)
+			hooks.afterFrame(frame, hooks.userData);
+	}
+
+	printf("-- %d frames --\n", options.frameCount);
+	if (hooks.beginFrame)
+		beginFrame.PrintSummary();
+	setTime.PrintSummary();
+	for (size_t i = 0; i < events.size(); ++i)
+		events[i].PrintSummary();
+	if (hooks.endFrame)
+		endFrame.PrintSummary();
+	frameTotal.PrintSummary();
+}
+
+
+bool StartHostTrace(const HostOptions& options)
+{
+	if (options.tracePath.empty())
+		return true;
+	if (!StartPluginTrace(options.tracePath.c_str()))
+	{
+		fprintf(stderr, "failed to start a trace into %s\n", options.tracePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+void StopHostTrace(const HostOptions& options)
+{
+	if (options.tracePath.empty())
+		return;
+	StopPluginTrace();
+	printf("trace written to %s\n", options.tracePath.c_str());
+}
+
+
+void PrintPluginFrameStats()
+{
+	PluginStageStats stats[kPluginStageCount];
+	const int stageCount = GetPluginStageCount();
+	const int frameCount = GetPluginFrameStats(stats, kPluginStageCount);
+	if (frameCount == 0)
+		return;
+
+	printf("-- plugin frame stats, last %d frames --\n", frameCount);
+	for (int i = 0; i < stageCount && i < kPluginStageCount; ++i)
+	{
+		if (stats[i].frameCount == 0)
+			continue;
+		printf("%-24s min %10.2f  avg %10.2f  p99 %10.2f  max %10.2f us  (%d frames)\n", GetPluginStageName(i),
+			stats[i].minMicroseconds, stats[i].avgMicroseconds, stats[i].p99Microseconds, stats[i].maxMicroseconds, stats[i].frameCount);
+	}
+}
+
+
+void PrintPluginMemoryStats(const char* title)
+{
+	PluginMemoryStats stats[kPluginMemoryCategoryCount];
+	const int categoryCount = GetPluginMemoryStats(stats, kPluginMemoryCategoryCount);
+
+	printf("-- plugin memory, %s --\n", title);
+	for (int i = 0; i < categoryCount; ++i)
+	{
+		if (stats[i].allocationCount == 0)
+			continue;
+		printf("%-16s live %10llu B in %4llu  peak %10llu B  pending deletion %10llu B  (%llu allocations)\n", GetPluginMemoryCategoryName(i),
+			stats[i].liveBytes, stats[i].liveAllocationCount, stats[i].peakBytes, stats[i].pendingDeletionBytes, stats[i].allocationCount);
+	}
+}
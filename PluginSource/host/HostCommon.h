@@ -0,0 +1,131 @@
+#pragma once
+
+// Shared pieces of the host tools: command line options, a procedural source
+// mesh and the frame loop that pumps the plugin's render event and reports
+// how long each stage took.
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+struct HostOptions
+{
+	int frameCount;					// --frames N
+	std::vector<int> eventIDs;		// --events 1,2
+	int textureWidth;				// --texture WxH
+	int textureHeight;
+	int vertexCount;				// --vertices N
+	float timeStep;					// --timestep seconds
+	bool printFrames;				// --quiet turns per-frame output off
+	std::string tracePath;			// --trace file.json
+	int plasmaKernel;				// --plasma name, -1 picks the best the CPU supports
+	int vertexKernel;				// --deform name, likewise
+	int threadCount;				// --threads N, 0 for the plugin's default
+	int vertexParallelThreshold;	// --parallel-vertices N, 0 for the plugin's default
+	int textureFormat;				// --format name, a PluginTextureFormat
+	std::vector<int> dirtyRects;	// --rects x,y,w,h,..., as SetTextureDirtyRectsFromUnity takes them
+	int tileSize;					// --tiles size[,bytes[,ms]], as SetTextureTileUpdateFromUnity takes them
+	int tileBytesPerFrame;
+	float tileMillisecondsPerFrame;
+	int mathPrecision;				// --math exact|fast, a PluginMathPrecision
+	bool pipelined;					// --pipelined: generate each frame's data ahead, see SetPluginPipelinedGeneration
+	bool vertexArray;				// --vertex-array: hand the mesh over as one array with SetMeshVertexArrayFromUnity
+	int extraTextureCount;			// --textures N[,size]: more textures for the hosts to register with AddTextureFromUnity,
+	int extraTextureSize;			// size x size each, in the --format
+	int extraMeshCount;				// --meshes N[,vertices]: more meshes for the hosts to register with AddMeshFromUnity
+	int extraMeshVertexCount;		// (AddMeshVertexArrayFromUnity with --vertex-array), of that many vertices each
+};
+
+// Size of MeshVertex in RenderingPlugin.cpp: float3 pos, float3 normal, float4 color, float2 uv
+const int kMeshVertexSize = 12 * sizeof(float);
+
+void InitHostOptions(HostOptions& options);
+
+// Tries to consume argv[i] (and its value) as one of the shared options.
+// Returns false if the argument is not a shared option; sets 'error' if it is, but malformed.
+bool ParseHostOption(int argc, char** argv, int& i, HostOptions& options, bool& error);
+
+void PrintHostOptionsUsage();
+
+
+// Source mesh data in the layout SetMeshBuffersFromUnity expects: separate
+// float3 position, float3 normal and float2 uv arrays; and the same interleaved,
+// as SetMeshVertexArrayFromUnity expects it.
+struct HostMesh
+{
+	int vertexCount;
+	std::vector<float> vertices;
+	std::vector<float> normals;
+	std::vector<float> uvs;
+	std::vector<float> interleaved;		// position, normal, uv of vertex 0, then of vertex 1, ...
+};
+
+// Builds a flat grid in the XZ plane with roughly 'vertexCount' vertices.
+void CreateGridMesh(int vertexCount, HostMesh& mesh);
+
+// Hands the mesh to the plugin like the script does, with SetMeshBuffersFromUnity or, with
+// --vertex-array, SetMeshVertexArrayFromUnity; the mesh has to stay alive from then on.
+void SendHostMeshToPlugin(void* vertexBufferHandle, const HostMesh& mesh, const HostOptions& options);
+
+// Registers the mesh with AddMeshFromUnity or, with --vertex-array, AddMeshVertexArrayFromUnity,
+// deformed a quarter of a second ahead of the mesh with the index before it, so that the extra
+// meshes all differ. Returns the plugin's id; the mesh has to stay alive from then on.
+int AddHostMeshToPlugin(void* vertexBufferHandle, const HostMesh& mesh, int index, const HostOptions& options);
+
+
+typedef std::chrono::steady_clock HostClock;
+
+inline double ElapsedMicroseconds(HostClock::time_point start, HostClock::time_point end)
+{
+	return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Collects duration samples of one stage and prints min/avg/p50/p99/max.
+class StageTimings
+{
+public:
+	explicit StageTimings(const std::string& name) : m_Name(name) { }
+
+	void Add(double microseconds) { m_Samples.push_back(microseconds); }
+	const std::string& GetName() const { return m_Name; }
+	double GetLast() const { return m_Samples.empty() ? 0.0 : m_Samples.back(); }
+	void PrintSummary() const;
+
+private:
+	std::string m_Name;
+	std::vector<double> m_Samples;
+};
+
+
+// Called after every frame, outside of the timed region.
+typedef void (*HostFrameCallback)(int frame, void* userData);
+
+// Optional per-frame hooks for hosts that emulate more of the engine's frame, e.g.
+// recording and submitting a command buffer around the render events. beginFrame and
+// endFrame are timed as their own stages; any of them may be NULL.
+struct HostFrameHooks
+{
+	HostFrameCallback beginFrame;
+	void (*beforeEvent)(int eventID, void* userData);
+	HostFrameCallback endFrame;
+	HostFrameCallback afterFrame;		// outside of the timed region
+	void* userData;
+};
+
+// Pumps 'options.frameCount' frames: SetTimeFromUnity followed by the render event
+// function for every configured event ID. Texture and mesh must already be set.
+void RunPluginFrames(const HostOptions& options, const HostFrameHooks& hooks);
+void RunPluginFrames(const HostOptions& options, HostFrameCallback frameCallback = NULL, void* userData = NULL);
+
+// Starts/stops the plugin's Chrome trace recording if --trace was given. Start prints
+// an error and returns false if the trace file can't be written.
+bool StartHostTrace(const HostOptions& options);
+void StopHostTrace(const HostOptions& options);
+
+// Prints what the plugin's own stage timers (GetPluginFrameStats) recorded; nothing if they are compiled out.
+void PrintPluginFrameStats();
+
+// Prints the plugin's device memory counters (GetPluginMemoryStats) under 'title', for the
+// categories that saw any allocation.
+void PrintPluginMemoryStats(const char* title);
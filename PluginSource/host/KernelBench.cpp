@@ -0,0 +1,1044 @@
+// Microbenchmarks for the per-frame CPU work of RenderingPlugin: the plasma
+// texture fill, the vertex wave deformation (also against the interleaved loop it
+// replaced, from a referenced vertex array, and for many meshes in one batch), the rotating
+// triangle and the source mesh copy done by SetMeshBuffersFromUnity. Every stage runs against the null RenderAPI (host
+// memory), over a sweep of texture sizes and vertex counts.
+// Kernels with SIMD variants are run once per variant the CPU supports, after checking
+// that they match the scalar reference, and so are the sine and cosine forms of
+// PluginMath.h, after checking them against libm. Results are printed as a table and
+// optionally written as JSON.
+
+#include "HostCommon.h"
+#include "PluginExports.h"
+#include "PluginKernels.h"
+#include "PluginMath_SIMD.h"
+#include "RenderAPI.h"
+#include "RenderAPI_Null.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct BenchOptions
+{
+	double minSeconds;			// --min-time: keep repeating a case for at least this long
+	int minIterations;
+	bool quick;					// --quick: skip the largest sizes
+	std::string filter;			// --filter: only run benchmarks whose name contains this
+	std::string jsonPath;		// --json: also write results here
+	int maxThreads;				// --threads: the texture fill and vertex update are timed with 1, 2, 4, ... up to this many threads
+};
+
+
+struct BenchResult
+{
+	std::string name;
+	std::string variant;
+	std::string size;
+	const char* unit;			// what one element is: "pixel", "vertex", ...
+	long long elements;			// elements processed per iteration
+	double bytesWritten;		// bytes stored per iteration
+	int iterations;
+	double avgNs;				// per iteration
+	double minNs;
+};
+
+
+static std::vector<BenchResult> s_Results;
+
+
+template<typename Func>
+static void RunBench(const BenchOptions& options, const char* name, const char* variant, const std::string& size,
+	const char* unit, long long elements, double bytesWritten, Func func)
+{
+	if (!options.filter.empty() && strstr(name, options.filter.c_str()) == NULL)
+		return;
+
+	func(); // warm up caches, page in memory
+
+	BenchResult result;
+	result.name = name;
+	result.variant = variant;
+	result.size = size;
+	result.unit = unit;
+	result.elements = elements;
+	result.bytesWritten = bytesWritten;
+	result.iterations = 0;
+	result.minNs = 1e30;
+
+	double totalNs = 0.0;
+	while (result.iterations < options.minIterations || totalNs < options.minSeconds * 1e9)
+	{
+		HostClock::time_point start = HostClock::now();
+		func();
+		double ns = ElapsedMicroseconds(start, HostClock::now()) * 1000.0;
+		totalNs += ns;
+		if (ns < result.minNs)
+			result.minNs = ns;
+		++result.iterations;
+	}
+	result.avgNs = totalNs / result.iterations;
+
+	printf("%-28s %-14s %-11s %8d it  %12.1f us/it  %8.3f ns/%-6s %8.3f %s/ns  %7.2f GB/s\n",
+		name, variant, size.c_str(), result.iterations, result.avgNs / 1000.0,
+		result.avgNs / double(elements), unit, double(elements) / result.avgNs, unit, bytesWritten / result.avgNs);
+	fflush(stdout);
+
+	s_Results.push_back(result);
+}
+
+
+static bool WriteJson(const char* path)
+{
+	FILE* f = fopen(path, "w");
+	if (!f)
+		return false;
+
+	fprintf(f, "{\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < s_Results.size(); ++i)
+	{
+		const BenchResult& r = s_Results[i];
+		fprintf(f, "    {\"name\": \"%s\", \"variant\": \"%s\", \"size\": \"%s\", \"unit\": \"%s\", \"elements\": %lld, "
+			"\"iterations\": %d, \"avg_ns\": %.1f, \"min_ns\": %.1f, \"ns_per_%s\": %.4f, \"%ss_per_ns\": %.4f, \"bytes_written\": %.0f, \"gb_per_s\": %.4f}%s\n",
+			r.name.c_str(), r.variant.c_str(), r.size.c_str(), r.unit, r.elements,
+			r.iterations, r.avgNs, r.minNs, r.unit, r.avgNs / double(r.elements), r.unit, double(r.elements) / r.avgNs, r.bytesWritten, r.bytesWritten / r.avgNs,
+			i + 1 < s_Results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	return fclose(f) == 0;
+}
+
+
+static std::string TextureSizeLabel(int size)
+{
+	char label[32];
+	snprintf(label, sizeof(label), "%dx%d", size, size);
+	return label;
+}
+
+
+static std::string VertexCountLabel(int count)
+{
+	char label[32];
+	if (count >= 1024 * 1024)
+		snprintf(label, sizeof(label), "%dM", count / (1024 * 1024));
+	else
+		snprintf(label, sizeof(label), "%dk", count / 1024);
+	return label;
+}
+
+
+// --------------------------------------------------------------------------
+// The sine and cosine forms of PluginMath.h, each over an array: x to out, 'count' values
+
+typedef void (*MathArrayFunc)(const float* x, float* out, int count);
+
+struct MathForm
+{
+	const char* name;
+	MathArrayFunc func;
+	bool cosine;
+	float maxError;				// 0: libm itself
+};
+
+static void Sinf_Array(const float* x, float* out, int count) { for (int i = 0; i < count; ++i) out[i] = sinf(x[i]); }
+static void Cosf_Array(const float* x, float* out, int count) { for (int i = 0; i < count; ++i) out[i] = cosf(x[i]); }
+
+template<PluginMathPrecision Precision>
+static void SinApprox_Array(const float* x, float* out, int count) { for (int i = 0; i < count; ++i) out[i] = PluginSinApprox<Precision>(x[i]); }
+template<PluginMathPrecision Precision>
+static void CosApprox_Array(const float* x, float* out, int count) { for (int i = 0; i < count; ++i) out[i] = PluginCosApprox<Precision>(x[i]); }
+
+#if PLUGIN_KERNELS_X86
+// 'count' is a multiple of 8
+template<PluginMathPrecision Precision, bool Cosine>
+PLUGIN_TARGET_SSE2 static void Math_SSE2_Array(const float* x, float* out, int count)
+{
+	for (int i = 0; i < count; i += 4)
+	{
+		const __m128 v = _mm_loadu_ps(x + i);
+		_mm_storeu_ps(out + i, Cosine ? PluginCos_SSE2<Precision>(v) : PluginSin_SSE2<Precision>(v));
+	}
+}
+
+template<PluginMathPrecision Precision, bool Cosine>
+PLUGIN_TARGET_AVX2 static void Math_AVX2_Array(const float* x, float* out, int count)
+{
+	for (int i = 0; i < count; i += 8)
+	{
+		const __m256 v = _mm256_loadu_ps(x + i);
+		_mm256_storeu_ps(out + i, Cosine ? PluginCos_AVX2<Precision>(v) : PluginSin_AVX2<Precision>(v));
+	}
+}
+#endif
+
+static const MathForm kMathForms[] =
+{
+	{ "sinf", Sinf_Array, false, 0.0f },
+	{ "cosf", Cosf_Array, true, 0.0f },
+	{ "sin/exact", SinApprox_Array<kPluginMathPrecision_Exact>, false, kPluginMathExactMaxError },
+	{ "cos/exact", CosApprox_Array<kPluginMathPrecision_Exact>, true, kPluginMathExactMaxError },
+	{ "sin/fast", SinApprox_Array<kPluginMathPrecision_Fast>, false, kPluginMathFastMaxError },
+	{ "cos/fast", CosApprox_Array<kPluginMathPrecision_Fast>, true, kPluginMathFastMaxError },
+#if PLUGIN_KERNELS_X86
+	{ "sse2 sin/exact", Math_SSE2_Array<kPluginMathPrecision_Exact, false>, false, kPluginMathExactMaxError },
+	{ "sse2 cos/exact", Math_SSE2_Array<kPluginMathPrecision_Exact, true>, true, kPluginMathExactMaxError },
+	{ "sse2 sin/fast", Math_SSE2_Array<kPluginMathPrecision_Fast, false>, false, kPluginMathFastMaxError },
+	{ "sse2 cos/fast", Math_SSE2_Array<kPluginMathPrecision_Fast, true>, true, kPluginMathFastMaxError },
+	{ "avx2 sin/exact", Math_AVX2_Array<kPluginMathPrecision_Exact, false>, false, kPluginMathExactMaxError },
+	{ "avx2 cos/exact", Math_AVX2_Array<kPluginMathPrecision_Exact, true>, true, kPluginMathExactMaxError },
+	{ "avx2 sin/fast", Math_AVX2_Array<kPluginMathPrecision_Fast, false>, false, kPluginMathFastMaxError },
+	{ "avx2 cos/fast", Math_AVX2_Array<kPluginMathPrecision_Fast, true>, true, kPluginMathFastMaxError },
+#endif
+};
+
+static bool IsMathFormSupported(const MathForm& form)
+{
+#if PLUGIN_KERNELS_X86
+	if (strncmp(form.name, "sse2", 4) == 0)
+		return CpuSupportsSSE2();
+	if (strncmp(form.name, "avx2", 4) == 0)
+		return CpuSupportsAVX2();
+#endif
+	return true;
+}
+
+
+// Checks every polynomial form against libm (in double precision) over the whole argument
+// range PluginMath.h documents: densely around 0 and in steps of about 1e-3 out to
+// kPluginMathMaxArgument. Returns false if any is off by more than its documented bound.
+static bool CheckMathFunctions()
+{
+	std::vector<float> x;
+	for (float v = -8.0f; v < 8.0f; v += 1.0f / 4096.0f)
+		x.push_back(v);
+	const int wideCount = 32 * 1024 * 1024;
+	for (int i = 0; i < wideCount; ++i)
+		x.push_back(-kPluginMathMaxArgument + 2.0f * kPluginMathMaxArgument * (float(i) / float(wideCount)));
+	x.push_back(kPluginMathMaxArgument);
+	x.push_back(-kPluginMathMaxArgument);
+	while (x.size() % 8)
+		x.push_back(0.0f);
+	std::vector<float> out(x.size());
+
+	bool ok = true;
+	for (size_t f = 0; f < sizeof(kMathForms) / sizeof(kMathForms[0]); ++f)
+	{
+		const MathForm& form = kMathForms[f];
+		if (!IsMathFormSupported(form))
+			continue;
+		form.func(x.data(), out.data(), int(x.size()));
+		double maxError = 0.0;
+		float worstX = 0.0f;
+		for (size_t i = 0; i < x.size(); ++i)
+		{
+			const double expected = form.cosine ? cos(double(x[i])) : sin(double(x[i]));
+			const double error = fabs(double(out[i]) - expected);
+			if (error > maxError)
+			{
+				maxError = error;
+				worstX = x[i];
+			}
+		}
+		const bool formOk = form.maxError <= 0.0f || maxError <= form.maxError;
+		printf("math %-15s max error to libm %.3g (at %g), bound %.3g%s\n", form.name, maxError, worstX, form.maxError, formOk ? "" : "  FAILED");
+		ok = ok && formOk;
+	}
+	return ok;
+}
+
+
+// Compares every supported plasma kernel against the scalar reference, on sizes that
+// leave pixels over at the row ends and on times far enough out to stress the sine
+// range reduction. Returns false if any differs by more than kPlasmaKernelTolerance,
+// if its streaming store path (run on rows that start off a cache line) doesn't write
+// exactly the same pixels as its regular one, if its R8 and RG8 output isn't the
+// first channel(s) of its RGBA8 output, or if filling a rect of the image on its own
+// doesn't give the same pixels as the whole image fill.
+static bool CheckPlasmaKernels()
+{
+	const int sizes[][2] = { { 256, 256 }, { 333, 97 }, { 4096, 16 } };
+	const float times[] = { 0.0f, 0.37f, 16.5f, 1000.25f };
+	const int smallFormatBytes[] = { 1, 2 };
+
+	bool ok = true;
+	for (int run = 0; run < 2 * kPlasmaKernelCount; ++run)
+	{
+		// Every kernel with exact and with fast sines, against the exact scalar one
+		const int kernel = run % kPlasmaKernelCount;
+		const PluginMathPrecision precision = run < kPlasmaKernelCount ? kPluginMathPrecision_Exact : kPluginMathPrecision_Fast;
+		if ((kernel == kPlasmaKernel_Scalar && precision == kPluginMathPrecision_Exact) || !IsPlasmaKernelSupported(PlasmaKernel(kernel)))
+			continue;
+		if (kernel == kPlasmaKernel_Tables && precision == kPluginMathPrecision_Fast)
+			continue;
+		SetKernelMathPrecision(precision);
+		int maxDiff = 0;
+		long long diffPixels = 0, pixels = 0;
+		bool streamingMatches = true, formatsMatch = true, rectsMatch = true;
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+		{
+			const int width = sizes[s][0], height = sizes[s][1];
+			PlasmaTarget target = { NULL, 0, 0, width, height, width * 4, width, height, 4, false, kPluginMathPrecision_Exact };
+			std::vector<unsigned char> reference(size_t(width) * height * 4), result(reference.size()), small(reference.size());
+			// 4 bytes past a cache line, and the odd widths keep later rows off it as well
+			std::vector<unsigned char> streamed(reference.size() + 68);
+			unsigned char* streamedPixels = (unsigned char*)(((size_t)streamed.data() + 63) & ~(size_t)63) + 4;
+			for (size_t t = 0; t < sizeof(times) / sizeof(times[0]); ++t)
+			{
+				target.pixels = reference.data();
+				FillPlasmaPixels_Scalar(target, times[t], 0, height);
+				SetPlasmaKernel(PlasmaKernel(kernel));
+				FillPlasmaPixels(result.data(), width, height, width * 4, 4, times[t]);
+				FillPlasmaPixels(streamedPixels, width, height, width * 4, 4, times[t], true);
+				streamingMatches = streamingMatches && memcmp(result.data(), streamedPixels, result.size()) == 0;
+				for (size_t i = 0; i < result.size(); i += 4)
+				{
+					const int diff = abs(int(result[i]) - int(reference[i]));
+					maxDiff = diff > maxDiff ? diff : maxDiff;
+					diffPixels += diff != 0;
+				}
+				pixels += (long long)width * height;
+
+				for (size_t f = 0; f < sizeof(smallFormatBytes) / sizeof(smallFormatBytes[0]); ++f)
+				{
+					const int bytesPerPixel = smallFormatBytes[f];
+					const size_t smallSize = size_t(width) * height * bytesPerPixel;
+					FillPlasmaPixels(small.data(), width, height, width * bytesPerPixel, bytesPerPixel, times[t]);
+					FillPlasmaPixels(streamedPixels, width, height, width * bytesPerPixel, bytesPerPixel, times[t], true);
+					streamingMatches = streamingMatches && memcmp(small.data(), streamedPixels, smallSize) == 0;
+					for (size_t i = 0; i < smallSize; ++i)
+						formatsMatch = formatsMatch && small[i] == result[i / bytesPerPixel * 4 + i % bytesPerPixel];
+				}
+
+				// A rect off the image origin, with odd position and size
+				const int rectX = width / 3 + 1, rectY = height / 5 + 1, rectWidth = width / 2 + 3, rectHeight = height / 3 + 1;
+				FillPlasmaRect(small.data(), rectX, rectY, rectWidth, rectHeight, width, height, rectWidth * 4, 4, times[t]);
+				for (int y = 0; y < rectHeight; ++y)
+				{
+					const unsigned char* expected = result.data() + (size_t(rectY + y) * width + rectX) * 4;
+					rectsMatch = rectsMatch && memcmp(small.data() + size_t(y) * rectWidth * 4, expected, size_t(rectWidth) * 4) == 0;
+				}
+			}
+		}
+		const bool kernelOk = maxDiff <= kPlasmaKernelTolerance && streamingMatches && formatsMatch && rectsMatch;
+		char name[32];
+		snprintf(name, sizeof(name), "%s%s", GetPlasmaKernelName(PlasmaKernel(kernel)), precision == kPluginMathPrecision_Fast ? "/fast" : "");
+		printf("plasma kernel %-11s max difference to scalar %d (%lld of %lld pixels differ)%s%s%s%s\n", name,
+			maxDiff, diffPixels, pixels, streamingMatches ? "" : ", streaming stores differ", formatsMatch ? "" : ", R8/RG8 output differs",
+			rectsMatch ? "" : ", rect fill differs", kernelOk ? "" : "  FAILED");
+		ok = ok && kernelOk;
+	}
+	SetKernelMathPrecision(kPluginMathPrecision_Exact);
+	return ok;
+}
+
+
+static void DeformVertexRange(VertexKernel kernel, const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst,
+	float time, PluginMathPrecision precision)
+{
+	switch (kernel)
+	{
+#if PLUGIN_KERNELS_X86
+	case kVertexKernel_SSE2: DeformMeshVertices_SSE2(src, vertexBegin, vertexEnd, dst, sizeof(MeshVertex), time, precision); break;
+	case kVertexKernel_AVX2: DeformMeshVertices_AVX2(src, vertexBegin, vertexEnd, dst, sizeof(MeshVertex), time, precision); break;
+#endif
+	case kVertexKernel_Tables: DeformMeshVertices_Tables(src, vertexBegin, vertexEnd, dst, sizeof(MeshVertex), time, precision); break;
+	default: DeformMeshVertices_Scalar(src, vertexBegin, vertexEnd, dst, sizeof(MeshVertex), time, precision); break;
+	}
+}
+
+
+// Compares every supported vertex kernel against the scalar one of the same precision, and
+// the table kernel against the wave formula evaluated in double, on a vertex count that
+// leaves vertices over after the last full SIMD iteration and on times far enough out to
+// stress the sine range reduction. Returns false if any position is off by more than
+// kVertexKernelTolerance, if the normals and uvs aren't copied exactly, if the colors are
+// touched, or if deforming a sub-range gives other vertices or writes anything outside of it.
+static bool CheckVertexKernels()
+{
+	const int count = 1027;
+	const float times[] = { 0.0f, 0.37f, 16.5f, 1000.25f };
+	HostMesh mesh;
+	CreateGridMesh(count, mesh);
+	MeshVertexStreams source;
+	CopyMeshSource(source, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+	const VertexKernel defaultKernel = GetVertexKernel();
+
+	bool ok = true;
+	for (int run = 0; run < 2 * kVertexKernelCount; ++run)
+	{
+		const int kernel = run % kVertexKernelCount;
+		const PluginMathPrecision precision = run < kVertexKernelCount ? kPluginMathPrecision_Exact : kPluginMathPrecision_Fast;
+		if (kernel == kVertexKernel_Scalar || !IsVertexKernelSupported(VertexKernel(kernel)))
+			continue;
+		if (kernel == kVertexKernel_Tables && precision == kPluginMathPrecision_Fast)
+			continue;
+		SetKernelMathPrecision(precision);
+		SetVertexKernel(VertexKernel(kernel));
+		float maxDiff = 0.0f, maxExactDiff = 0.0f;
+		bool copiesMatch = true, rangeMatches = true;
+		std::vector<MeshVertex> reference(count), result(count), range(count);
+		for (size_t t = 0; t < sizeof(times) / sizeof(times[0]); ++t)
+		{
+			// The colors must come through as they were
+			memset(reference.data(), 0x5a, count * sizeof(MeshVertex));
+			memset(result.data(), 0x5a, count * sizeof(MeshVertex));
+			DeformMeshVertices_Scalar(source, 0, count, reference.data(), sizeof(MeshVertex), times[t], precision);
+			DeformMeshVertices(source, result.data(), sizeof(MeshVertex), times[t]);
+			const double waveTime = double(times[t] * 3.0f);
+			for (int i = 0; i < count; ++i)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					const float diff = fabsf(result[i].pos[c] - reference[i].pos[c]);
+					maxDiff = diff > maxDiff ? diff : maxDiff;
+				}
+				const double exactY = source.posY[i] + sin(double(source.posX[i] * 1.1f) + waveTime) * 0.4 + sin(double(source.posZ[i] * 0.9f) - waveTime) * 0.3;
+				const float exactDiff = float(fabs(result[i].pos[1] - exactY));
+				maxExactDiff = exactDiff > maxExactDiff ? exactDiff : maxExactDiff;
+				// normal, color and uv follow each other
+				copiesMatch = copiesMatch && result[i].pos[0] == reference[i].pos[0] && result[i].pos[2] == reference[i].pos[2] &&
+					memcmp(result[i].normal, reference[i].normal, sizeof(result[i].normal) + sizeof(result[i].color) + sizeof(result[i].uv)) == 0;
+			}
+
+			// An odd range in the middle; the rest keeps its old contents
+			const int rangeBegin = 5, rangeEnd = count - 3;
+			memset(range.data(), 0x5a, count * sizeof(MeshVertex));
+			DeformVertexRange(VertexKernel(kernel), source, rangeBegin, rangeEnd, range.data(), times[t], precision);
+			rangeMatches = rangeMatches && memcmp(range.data() + rangeBegin, result.data() + rangeBegin, (rangeEnd - rangeBegin) * sizeof(MeshVertex)) == 0;
+			for (int i = 0; i < count; ++i)
+			{
+				if (i >= rangeBegin && i < rangeEnd)
+					continue;
+				const unsigned char* bytes = (const unsigned char*)&range[i];
+				for (size_t b = 0; b < sizeof(MeshVertex); ++b)
+					rangeMatches = rangeMatches && bytes[b] == 0x5a;
+			}
+		}
+		const bool tables = kernel == kVertexKernel_Tables;
+		const bool kernelOk = (tables ? maxExactDiff : maxDiff) <= kVertexKernelTolerance && copiesMatch && rangeMatches;
+		char name[32];
+		snprintf(name, sizeof(name), "%s%s", GetVertexKernelName(VertexKernel(kernel)), precision == kPluginMathPrecision_Fast ? "/fast" : "");
+		printf("vertex kernel %-11s max difference to scalar %.2g, to the exact formula %.2g%s%s%s\n", name, maxDiff, maxExactDiff,
+			copiesMatch ? "" : ", copied fields differ", rangeMatches ? "" : ", range deformation differs", kernelOk ? "" : "  FAILED");
+		ok = ok && kernelOk;
+	}
+	SetKernelMathPrecision(kPluginMathPrecision_Exact);
+	SetVertexKernel(defaultKernel);
+	return ok;
+}
+
+
+// Deforms a mesh of a few chunks with the parallel path, into a buffer that doesn't start on
+// a cache line, on 1 and on 4 threads for every kernel; returns false unless both give
+// the same vertices.
+static bool CheckParallelDeformation()
+{
+	const int count = 5 * kVertexChunkSize + 37;
+	HostMesh mesh;
+	CreateGridMesh(count, mesh);
+	MeshVertexStreams source;
+	CopyMeshSource(source, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+	const VertexKernel defaultKernel = GetVertexKernel();
+	const int defaultThreshold = GetVertexParallelThreshold();
+	SetVertexParallelThreshold(1);
+
+	// 16 bytes past a cache line
+	std::vector<unsigned char> serialBuffer(count * sizeof(MeshVertex) + 80), parallelBuffer(serialBuffer.size());
+	MeshVertex* serial = (MeshVertex*)((((size_t)serialBuffer.data() + 63) & ~(size_t)63) + 16);
+	MeshVertex* parallel = (MeshVertex*)((((size_t)parallelBuffer.data() + 63) & ~(size_t)63) + 16);
+	bool ok = true;
+	for (int kernel = 0; kernel < kVertexKernelCount; ++kernel)
+	{
+		if (!SetVertexKernel(VertexKernel(kernel)))
+			continue;
+		SetPluginWorkerThreadCount(1);
+		DeformMeshVertices(source, serial, sizeof(MeshVertex), 16.5f);
+		SetPluginWorkerThreadCount(4);
+		DeformMeshVertices(source, parallel, sizeof(MeshVertex), 16.5f);
+		const bool kernelOk = memcmp(serial, parallel, count * sizeof(MeshVertex)) == 0;
+		printf("vertex kernel %-11s on 4 threads%s\n", GetVertexKernelName(VertexKernel(kernel)), kernelOk ? " matches 1 thread" : " differs from 1 thread  FAILED");
+		ok = ok && kernelOk;
+	}
+	SetPluginWorkerThreadCount(0);
+	SetVertexParallelThreshold(defaultThreshold);
+	SetVertexKernel(defaultKernel);
+	return ok;
+}
+
+
+// The vertex array kernels against the stream kernels they stand in for, from the same
+// vertices as one interleaved array: both precisions, the whole mesh and an odd sub-range,
+// into buffers with the colors preset. Returns false unless the bytes are identical.
+static bool CheckVertexArrayKernels()
+{
+	const int count = 1027;
+	const int rangeBegin = 5, rangeEnd = count - 3;
+	HostMesh mesh;
+	CreateGridMesh(count, mesh);
+	MeshVertexStreams streams, array;
+	CopyMeshSource(streams, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+	ReferenceMeshSource(array, count, (const MeshSourceVertex*)mesh.interleaved.data());
+
+	typedef void (*DeformFunc)(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+		float time, PluginMathPrecision precision);
+	struct KernelPair { const char* name; DeformFunc streamKernel; DeformFunc arrayKernel; bool supported; };
+	const KernelPair kernels[] =
+	{
+		{ "scalar", DeformMeshVertices_Scalar, DeformVertexArray_Scalar, true },
+#if PLUGIN_KERNELS_X86
+		{ "sse2", DeformMeshVertices_SSE2, DeformVertexArray_SSE2, CpuSupportsSSE2() },
+#endif
+	};
+
+	bool ok = true;
+	std::vector<MeshVertex> reference(count), result(count);
+	for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+	{
+		if (!kernels[k].supported)
+			continue;
+		bool kernelOk = true;
+		for (int precision = 0; precision < kPluginMathPrecisionCount; ++precision)
+		{
+			for (int range = 0; range < 2; ++range)
+			{
+				const int begin = range ? rangeBegin : 0, end = range ? rangeEnd : count;
+				memset(reference.data(), 0x5a, count * sizeof(MeshVertex));
+				memset(result.data(), 0x5a, count * sizeof(MeshVertex));
+				kernels[k].streamKernel(streams, begin, end, reference.data(), sizeof(MeshVertex), 1000.25f, PluginMathPrecision(precision));
+				kernels[k].arrayKernel(array, begin, end, result.data(), sizeof(MeshVertex), 1000.25f, PluginMathPrecision(precision));
+				kernelOk = kernelOk && memcmp(reference.data(), result.data(), count * sizeof(MeshVertex)) == 0;
+			}
+		}
+		printf("vertex array kernel %-5s %s\n", kernels[k].name, kernelOk ? "matches the stream kernel" : "differs from the stream kernel  FAILED");
+		ok = ok && kernelOk;
+	}
+	return ok;
+}
+
+
+// The copy kernels of CopyMeshSource against the scalar one, on a vertex count that leaves
+// vertices over after the last group of four: positions, normals and uvs must come through
+// exactly and the phase sines within kPluginMathExactMaxError. Then a copy split into odd
+// ranges and the parallel copy of a few chunks on 4 threads, which must both give exactly
+// what one call on the whole mesh gives.
+static bool CheckMeshSourceCopy()
+{
+	const int count = 5 * kVertexChunkSize + 37;
+	HostMesh mesh;
+	CreateGridMesh(count, mesh);
+	// Positions far enough out to stress the sines' range reduction
+	for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		mesh.vertices[i] *= 31.0f;
+	MeshVertexStreams reference;
+	CopyMeshSource(reference, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+	MeshVertexStream* referenceStreams[MeshVertexStreams::kStreamCount];
+	reference.GetStreams(referenceStreams);
+
+	typedef void (*CopyFunc)(MeshVertexStreams& dst, int vertexBegin, int vertexEnd, const float* positions, const float* normals, const float* uvs);
+	struct CopyKernel { const char* name; CopyFunc func; bool supported; };
+	const CopyKernel kernels[] =
+	{
+		{ "scalar", CopyMeshSource_Scalar, true },
+#if PLUGIN_KERNELS_X86
+		{ "sse2", CopyMeshSource_SSE2, CpuSupportsSSE2() },
+#endif
+	};
+
+	bool ok = true;
+	MeshVertexStreams scalar;
+	for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k)
+	{
+		if (!kernels[k].supported)
+			continue;
+		MeshVertexStreams whole, split;
+		MeshVertexStream* wholeStreams[MeshVertexStreams::kStreamCount];
+		MeshVertexStream* splitStreams[MeshVertexStreams::kStreamCount];
+		whole.GetStreams(wholeStreams);
+		split.GetStreams(splitStreams);
+		for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+		{
+			wholeStreams[s]->resize(count);
+			splitStreams[s]->resize(count);
+		}
+		kernels[k].func(whole, 0, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+		const int splits[] = { 0, 3, 4, 9, 1030, count - 2, count };
+		for (size_t r = 0; r + 1 < sizeof(splits) / sizeof(splits[0]); ++r)
+			kernels[k].func(split, splits[r], splits[r + 1], &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+		if (k == 0)
+			scalar = whole;
+
+		MeshVertexStream* scalarStreams[MeshVertexStreams::kStreamCount];
+		scalar.GetStreams(scalarStreams);
+		bool copiesMatch = true, splitMatches = true;
+		float maxPhaseDiff = 0.0f;
+		for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+		{
+			splitMatches = splitMatches && memcmp(splitStreams[s]->data(), wholeStreams[s]->data(), count * sizeof(float)) == 0;
+			if (s < 8)
+			{
+				copiesMatch = copiesMatch && memcmp(wholeStreams[s]->data(), scalarStreams[s]->data(), count * sizeof(float)) == 0;
+				continue;
+			}
+			for (int i = 0; i < count; ++i)
+			{
+				const float diff = fabsf((*wholeStreams[s])[i] - (*scalarStreams[s])[i]);
+				maxPhaseDiff = diff > maxPhaseDiff ? diff : maxPhaseDiff;
+			}
+		}
+		const bool kernelOk = copiesMatch && splitMatches && maxPhaseDiff <= kPluginMathExactMaxError;
+		printf("mesh copy kernel %-6s max phase difference to scalar %.2g%s%s%s\n", kernels[k].name, maxPhaseDiff,
+			copiesMatch ? "" : ", copied streams differ", splitMatches ? "" : ", split copy differs", kernelOk ? "" : "  FAILED");
+		ok = ok && kernelOk;
+	}
+
+	// CopyMeshSource itself, serial and on 4 threads
+	const int defaultThreshold = GetVertexParallelThreshold();
+	SetVertexParallelThreshold(1);
+	SetPluginWorkerThreadCount(4);
+	MeshVertexStreams parallel;
+	CopyMeshSource(parallel, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+	SetPluginWorkerThreadCount(0);
+	SetVertexParallelThreshold(defaultThreshold);
+	MeshVertexStream* parallelStreams[MeshVertexStreams::kStreamCount];
+	parallel.GetStreams(parallelStreams);
+	bool parallelMatches = true;
+	for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+		parallelMatches = parallelMatches && memcmp(parallelStreams[s]->data(), referenceStreams[s]->data(), count * sizeof(float)) == 0;
+	printf("mesh copy on 4 threads%s\n", parallelMatches ? " matches 1 thread" : " differs from 1 thread  FAILED");
+	return ok && parallelMatches;
+}
+
+
+// DeformMeshBatch on meshes from one vertex to a few chunks, copied and referenced ones, each
+// with its own time and with its buffer starting at another offset from a cache line, on 4
+// threads with the parallel path forced, for every kernel; returns false unless every mesh
+// gets exactly what DeformMeshVertices gives it on its own, and nothing around it is written.
+static bool CheckMeshBatch()
+{
+	const int counts[] = { 1, 30, 63, 64, 65, 500, 3 * kVertexChunkSize + 17, 7, 2 * kVertexChunkSize };
+	const int meshCount = int(sizeof(counts) / sizeof(counts[0]));
+	std::vector<HostMesh> meshes(meshCount);
+	std::vector<MeshVertexStreams> sources(meshCount);
+	std::vector<std::vector<unsigned char> > referenceBuffers(meshCount), batchBuffers(meshCount);
+	std::vector<MeshDeformTarget> references(meshCount), targets(meshCount);
+	for (int m = 0; m < meshCount; ++m)
+	{
+		CreateGridMesh(counts[m], meshes[m]);
+		if (m % 2)
+			ReferenceMeshSource(sources[m], counts[m], (const MeshSourceVertex*)meshes[m].interleaved.data());
+		else
+			CopyMeshSource(sources[m], counts[m], &meshes[m].vertices[0], &meshes[m].normals[0], &meshes[m].uvs[0]);
+
+		// 0, 16, 32 or 48 bytes past a cache line
+		const size_t offset = 16 * (m % 4);
+		referenceBuffers[m].resize(counts[m] * sizeof(MeshVertex) + 128, 0x5a);
+		batchBuffers[m].resize(referenceBuffers[m].size(), 0x5a);
+		const MeshDeformTarget reference = { &sources[m], (void*)((((size_t)referenceBuffers[m].data() + 63) & ~(size_t)63) + offset),
+			int(sizeof(MeshVertex)), 0.37f + 3.5f * m };
+		MeshDeformTarget target = reference;
+		target.dst = (void*)((((size_t)batchBuffers[m].data() + 63) & ~(size_t)63) + offset);
+		references[m] = reference;
+		targets[m] = target;
+	}
+	const VertexKernel defaultKernel = GetVertexKernel();
+	const int defaultThreshold = GetVertexParallelThreshold();
+
+	bool ok = true;
+	for (int kernel = 0; kernel < kVertexKernelCount; ++kernel)
+	{
+		if (!SetVertexKernel(VertexKernel(kernel)))
+			continue;
+		SetPluginWorkerThreadCount(1);
+		SetVertexParallelThreshold(defaultThreshold);
+		for (int m = 0; m < meshCount; ++m)
+			DeformMeshVertices(*references[m].src, references[m].dst, references[m].dstStride, references[m].time);
+		SetPluginWorkerThreadCount(4);
+		SetVertexParallelThreshold(1);
+		DeformMeshBatch(targets.data(), meshCount);
+		bool kernelOk = true;
+		for (int m = 0; m < meshCount; ++m)
+		{
+			kernelOk = kernelOk && memcmp(references[m].dst, targets[m].dst, counts[m] * sizeof(MeshVertex)) == 0;
+			// Nothing around the mesh's vertices is touched
+			const unsigned char* begin = (const unsigned char*)targets[m].dst;
+			const unsigned char* end = begin + counts[m] * sizeof(MeshVertex);
+			for (const unsigned char* b = batchBuffers[m].data(); b < batchBuffers[m].data() + batchBuffers[m].size(); ++b)
+				kernelOk = kernelOk && ((b >= begin && b < end) || *b == 0x5a);
+		}
+		printf("vertex kernel %-11s batch of %d meshes on 4 threads%s\n", GetVertexKernelName(VertexKernel(kernel)), meshCount,
+			kernelOk ? " matches each mesh on its own" : " differs from each mesh on its own  FAILED");
+		ok = ok && kernelOk;
+	}
+	SetPluginWorkerThreadCount(0);
+	SetVertexParallelThreshold(defaultThreshold);
+	SetVertexKernel(defaultKernel);
+	return ok;
+}
+
+
+// Every kernel on one thread, the default kernel into RG8 and R8 and into a few dirty rects,
+// then the default kernel on 1, 2, 4, ... options.maxThreads threads
+static void BenchTextures(const BenchOptions& options, RenderAPI* api)
+{
+	const PlasmaKernel defaultKernel = GetPlasmaKernel();
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < options.maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(options.maxThreads);
+
+	const int maxSize = options.quick ? 1024 : 4096;
+	for (int size = 256; size <= maxSize; size *= 2)
+	{
+		NullTexture texture;
+		const long long pixels = (long long)size * size;
+		SetPluginWorkerThreadCount(1);
+		for (int kernel = 0; kernel < kPlasmaKernelCount; ++kernel)
+		{
+			if (!SetPlasmaKernel(PlasmaKernel(kernel)))
+				continue;
+			float time = 0.0f;
+			RunBench(options, "ModifyTexturePixels", GetPlasmaKernelName(PlasmaKernel(kernel)), TextureSizeLabel(size), "pixel", pixels, double(pixels * 4),
+				[&]() { ModifyTexturePixels(api, &texture, size, size, kPluginTextureFormat_RGBA8, time += 0.016f); });
+		}
+		// The kernels with per-pixel sines again, with the fast ones
+		SetKernelMathPrecision(kPluginMathPrecision_Fast);
+		for (int kernel = 0; kernel < kPlasmaKernelCount; ++kernel)
+		{
+			if (kernel == kPlasmaKernel_Tables || !SetPlasmaKernel(PlasmaKernel(kernel)))
+				continue;
+			char variant[32];
+			snprintf(variant, sizeof(variant), "%s/fast", GetPlasmaKernelName(PlasmaKernel(kernel)));
+			float time = 0.0f;
+			RunBench(options, "ModifyTexturePixels", variant, TextureSizeLabel(size), "pixel", pixels, double(pixels * 4),
+				[&]() { ModifyTexturePixels(api, &texture, size, size, kPluginTextureFormat_RGBA8, time += 0.016f); });
+		}
+		SetKernelMathPrecision(kPluginMathPrecision_Exact);
+		SetPlasmaKernel(defaultKernel);
+
+		// The default kernel into the smaller formats; bytes/ns is what the upload sees
+		const PluginTextureFormat smallFormats[] = { kPluginTextureFormat_RG8, kPluginTextureFormat_R8 };
+		const char* const smallFormatNames[] = { "rg8", "r8" };
+		for (int f = 0; f < 2; ++f)
+		{
+			const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(smallFormats[f]);
+			char variant[32];
+			snprintf(variant, sizeof(variant), "%s/%s", GetPlasmaKernelName(defaultKernel), smallFormatNames[f]);
+			float time = 0.0f;
+			RunBench(options, "ModifyTexturePixels", variant, TextureSizeLabel(size), "pixel", pixels, double(pixels * bytesPerPixel),
+				[&]() { ModifyTexturePixels(api, &texture, size, size, smallFormats[f], time += 0.016f); });
+		}
+
+		// Four dirty rects covering 1/16 of the texture, in one region update; per pixel
+		// updated this should cost about what the whole texture update does
+		{
+			const int quarter = size / 4, rectSize = size / 8;
+			const PluginTextureRect rects[4] =
+			{
+				{ 0, 0, rectSize, rectSize }, { 3 * quarter, 0, rectSize, rectSize },
+				{ 0, 3 * quarter, rectSize, rectSize }, { 3 * quarter, 3 * quarter, rectSize, rectSize },
+			};
+			const long long rectPixels = 4LL * rectSize * rectSize;
+			char variant[32];
+			snprintf(variant, sizeof(variant), "%s/4rects", GetPlasmaKernelName(defaultKernel));
+			float time = 0.0f;
+			RunBench(options, "ModifyTexturePixels", variant, TextureSizeLabel(size), "pixel", rectPixels, double(rectPixels * 4),
+				[&]() { ModifyTexturePixels(api, &texture, size, size, kPluginTextureFormat_RGBA8, time += 0.016f, rects, 4); });
+		}
+
+		// The fill alone into a cache line aligned buffer, with regular and with streaming
+		// stores. Host memory is not write-combined, so this shows the cost of bypassing the
+		// cache rather than the gain on an upload heap.
+		std::vector<unsigned char> buffer(size_t(pixels) * 4 + 64);
+		unsigned char* alignedPixels = (unsigned char*)(((size_t)buffer.data() + 63) & ~(size_t)63);
+		for (int kernel = 0; kernel < kPlasmaKernelCount; ++kernel)
+		{
+			if (kernel == kPlasmaKernel_Scalar || !SetPlasmaKernel(PlasmaKernel(kernel)))
+				continue;
+			for (int streaming = 0; streaming < 2; ++streaming)
+			{
+				char variant[32];
+				snprintf(variant, sizeof(variant), "%s%s", GetPlasmaKernelName(PlasmaKernel(kernel)), streaming ? "/nt" : "");
+				float time = 0.0f;
+				RunBench(options, "FillPlasmaPixels", variant, TextureSizeLabel(size), "pixel", pixels, double(pixels * 4),
+					[&]() { FillPlasmaPixels(alignedPixels, size, size, size * 4, 4, time += 0.016f, streaming != 0); });
+			}
+		}
+		SetPlasmaKernel(defaultKernel);
+
+		for (size_t i = 0; i < threadCounts.size(); ++i)
+		{
+			const int threads = threadCounts[i];
+			SetPluginWorkerThreadCount(threads);
+			char variant[32];
+			snprintf(variant, sizeof(variant), "%s/%dt", GetPlasmaKernelName(defaultKernel), threads);
+			float time = 0.0f;
+			RunBench(options, "ModifyTexturePixels", variant, TextureSizeLabel(size), "pixel", pixels, double(pixels * 4),
+				[&]() { ModifyTexturePixels(api, &texture, size, size, kPluginTextureFormat_RGBA8, time += 0.016f); });
+		}
+	}
+	SetPluginWorkerThreadCount(0);
+}
+
+
+// The deformation loop as it was before the source moved to streams: one MeshVertex struct
+// read per vertex, two libm sines. Kept here to compare the kernels against.
+static void DeformInterleavedVertices(const MeshVertex* src, int vertexCount, MeshVertex* dst, float time)
+{
+	const float t = time * 3.0f;
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		const MeshVertex& s = src[i];
+		MeshVertex& d = dst[i];
+		d.pos[0] = s.pos[0];
+		d.pos[1] = s.pos[1] + sinf(s.pos[0] * 1.1f + t) * 0.4f + sinf(s.pos[2] * 0.9f - t) * 0.3f;
+		d.pos[2] = s.pos[2];
+		d.normal[0] = s.normal[0];
+		d.normal[1] = s.normal[1];
+		d.normal[2] = s.normal[2];
+		d.uv[0] = s.uv[0];
+		d.uv[1] = s.uv[1];
+	}
+}
+
+
+// The source mesh copy with each copy kernel and through both exports; the deformation on
+// its own on one thread: the former interleaved loop, every vertex kernel with exact and with
+// fast sines (the table kernel has none) and the vertex array kernels; then the whole
+// ModifyVertexBuffer stage with the default kernel on 1, 2, 4, ... options.maxThreads threads
+static void BenchMeshes(const BenchOptions& options, RenderAPI* api)
+{
+	const int maxCount = options.quick ? 256 * 1024 : 4 * 1024 * 1024;
+	const VertexKernel defaultKernel = GetVertexKernel();
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < options.maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(options.maxThreads);
+	for (int count = 1024; count <= maxCount; count *= 4)
+	{
+		HostMesh mesh;
+		CreateGridMesh(count, mesh);
+
+		// Deformation writes position, normal and uv of every vertex
+		const double bytesPerVertex = 8 * sizeof(float);
+		MeshVertexStreams source;
+		CopyMeshSource(source, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+
+		// The source copy on its own with each kernel, then whole calls as the script makes
+		// them: the copy on the default threads, and the vertex array, which only keeps a pointer
+		const double bytesPerSourceVertex = 12 * sizeof(float);
+		RunBench(options, "CopyMeshSource", "scalar", VertexCountLabel(count), "vertex", count, bytesPerSourceVertex * count,
+			[&]() { CopyMeshSource_Scalar(source, 0, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]); });
+#if PLUGIN_KERNELS_X86
+		if (CpuSupportsSSE2())
+			RunBench(options, "CopyMeshSource", "sse2", VertexCountLabel(count), "vertex", count, bytesPerSourceVertex * count,
+				[&]() { CopyMeshSource_SSE2(source, 0, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]); });
+#endif
+		SetPluginWorkerThreadCount(0);
+		RunBench(options, "SetMeshBuffersFromUnity", "copy", VertexCountLabel(count), "vertex", count, bytesPerSourceVertex * count,
+			[&]() { SetMeshBuffersFromUnity(NULL, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]); });
+		RunBench(options, "SetMeshVertexArrayFromUnity", "reference", VertexCountLabel(count), "vertex", count, 0.0,
+			[&]() { SetMeshVertexArrayFromUnity(NULL, count, mesh.interleaved.data()); });
+		SetMeshVertexArrayFromUnity(NULL, 0, NULL);
+		std::vector<MeshVertex> interleavedSource(count), deformed(count);
+		for (int i = 0; i < count; ++i)
+			DeformMeshVertex<kPluginMathPrecision_Exact>(source, i, interleavedSource[i], 0.0f);
+		float time = 0.0f;
+		SetPluginWorkerThreadCount(1);
+		RunBench(options, "DeformMeshVertices", "aos", VertexCountLabel(count), "vertex", count, bytesPerVertex * count,
+			[&]() { DeformInterleavedVertices(interleavedSource.data(), count, deformed.data(), time += 0.016f); });
+		for (int run = 0; run < 2 * kVertexKernelCount; ++run)
+		{
+			const int kernel = run % kVertexKernelCount;
+			const bool fast = run >= kVertexKernelCount;
+			if ((fast && kernel == kVertexKernel_Tables) || !SetVertexKernel(VertexKernel(kernel)))
+				continue;
+			SetKernelMathPrecision(fast ? kPluginMathPrecision_Fast : kPluginMathPrecision_Exact);
+			char variant[32];
+			snprintf(variant, sizeof(variant), "%s%s", GetVertexKernelName(VertexKernel(kernel)), fast ? "/fast" : "");
+			RunBench(options, "DeformMeshVertices", variant, VertexCountLabel(count), "vertex", count, bytesPerVertex * count,
+				[&]() { DeformMeshVertices(source, deformed.data(), sizeof(MeshVertex), time += 0.016f); });
+		}
+		SetKernelMathPrecision(kPluginMathPrecision_Exact);
+
+		// From the interleaved vertex array, which has a scalar and an SSE2 kernel
+		MeshVertexStreams array;
+		ReferenceMeshSource(array, count, (const MeshSourceVertex*)mesh.interleaved.data());
+		for (int kernel = 0; kernel <= kVertexKernel_SSE2; ++kernel)
+		{
+			if (!SetVertexKernel(VertexKernel(kernel)))
+				continue;
+			char variant[32];
+			snprintf(variant, sizeof(variant), "array/%s", GetVertexKernelName(VertexKernel(kernel)));
+			RunBench(options, "DeformMeshVertices", variant, VertexCountLabel(count), "vertex", count, bytesPerVertex * count,
+				[&]() { DeformMeshVertices(array, deformed.data(), sizeof(MeshVertex), time += 0.016f); });
+		}
+		SetVertexKernel(defaultKernel);
+
+		// Below the parallel threshold more threads change nothing
+		NullBuffer buffer;
+		buffer.data.resize(size_t(count) * sizeof(MeshVertex));
+		for (size_t i = 0; i < threadCounts.size(); ++i)
+		{
+			const int threads = threadCounts[i];
+			if (threads > 1 && count < GetVertexParallelThreshold())
+				break;
+			SetPluginWorkerThreadCount(threads);
+			char variant[32];
+			snprintf(variant, sizeof(variant), "%s/%dt", GetVertexKernelName(defaultKernel), threads);
+			RunBench(options, "ModifyVertexBuffer", variant, VertexCountLabel(count), "vertex", count, bytesPerVertex * count,
+				[&]() { ModifyVertexBuffer(api, &buffer, source, time += 0.016f); });
+		}
+	}
+	SetPluginWorkerThreadCount(0);
+}
+
+
+// Many small meshes with the default kernel, on 1, 2, 4, ... options.maxThreads threads: one
+// ModifyVertexBuffer per mesh, which only goes parallel within a mesh, against one
+// ModifyVertexBufferBatch for all of them, which spreads the meshes over the threads
+static void BenchMeshBatch(const BenchOptions& options, RenderAPI* api)
+{
+	const int meshCount = 512, count = 512;
+	HostMesh mesh;
+	CreateGridMesh(count, mesh);
+	MeshVertexStreams source;
+	CopyMeshSource(source, count, &mesh.vertices[0], &mesh.normals[0], &mesh.uvs[0]);
+	std::vector<NullBuffer> buffers(meshCount);
+	std::vector<MeshBufferUpdate> updates(meshCount);
+	for (int m = 0; m < meshCount; ++m)
+	{
+		buffers[m].data.resize(size_t(count) * sizeof(MeshVertex));
+		const MeshBufferUpdate update = { &buffers[m], &source, 0.25f * m };
+		updates[m] = update;
+	}
+
+	const long long vertexCount = (long long)meshCount * count;
+	const double bytesWritten = 8 * sizeof(float) * double(vertexCount);
+	char size[32];
+	snprintf(size, sizeof(size), "%dx%d", meshCount, count);
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < options.maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(options.maxThreads);
+	float time = 0.0f;
+	for (size_t i = 0; i < threadCounts.size(); ++i)
+	{
+		SetPluginWorkerThreadCount(threadCounts[i]);
+		char variant[32];
+		snprintf(variant, sizeof(variant), "each/%dt", threadCounts[i]);
+		RunBench(options, "ModifyVertexBufferBatch", variant, size, "vertex", vertexCount, bytesWritten,
+			[&]()
+			{
+				time += 0.016f;
+				for (int m = 0; m < meshCount; ++m)
+					ModifyVertexBuffer(api, &buffers[m], source, time + updates[m].time);
+			});
+		snprintf(variant, sizeof(variant), "batch/%dt", threadCounts[i]);
+		RunBench(options, "ModifyVertexBufferBatch", variant, size, "vertex", vertexCount, bytesWritten,
+			[&]() { ModifyVertexBufferBatch(api, updates.data(), meshCount); });
+	}
+	SetPluginWorkerThreadCount(0);
+}
+
+
+// Every sine and cosine form over values spread across a few hundred periods
+static void BenchMath(const BenchOptions& options)
+{
+	const int count = 64 * 1024;
+	std::vector<float> x(count), out(count);
+	for (int i = 0; i < count; ++i)
+		x[i] = -1000.0f + 2000.0f * float(i) / float(count);
+	for (size_t f = 0; f < sizeof(kMathForms) / sizeof(kMathForms[0]); ++f)
+	{
+		const MathForm& form = kMathForms[f];
+		if (!IsMathFormSupported(form))
+			continue;
+		RunBench(options, "PluginMath", form.name, "64k", "value", count, double(count) * sizeof(float),
+			[&]() { form.func(x.data(), out.data(), count); });
+	}
+}
+
+
+static void BenchTriangle(const BenchOptions& options, RenderAPI* api)
+{
+	float time = 0.0f;
+	RunBench(options, "DrawColoredTriangle", "scalar", "2 tris", "vertex", 6, 6 * sizeof(SimpleVertex) + 16 * sizeof(float),
+		[&]() { DrawColoredTriangle(api, time += 0.016f); });
+}
+
+
+static void PrintUsage(const char* exe)
+{
+	printf("usage: %s [options]\n", exe);
+	printf("  --min-time S      run every case for at least S seconds (default 0.25)\n");
+	printf("  --quick           skip textures above 1024x1024 and meshes above 256k vertices\n");
+	printf("  --filter NAME     only run benchmarks whose name contains NAME\n");
+	printf("  --json FILE       write the results to FILE as JSON\n");
+	printf("  --threads N       time the texture fill and vertex buffer update with 1, 2, 4, ... up to N threads (default: one per core)\n");
+}
+
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	options.minSeconds = 0.25;
+	options.minIterations = 3;
+	options.quick = false;
+	options.maxThreads = int(std::thread::hardware_concurrency());
+	if (options.maxThreads < 1)
+		options.maxThreads = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(argv[i], "--quick") == 0)
+			options.quick = true;
+		else if (strcmp(argv[i], "--min-time") == 0 && value)
+			options.minSeconds = atof(argv[++i]);
+		else if (strcmp(argv[i], "--filter") == 0 && value)
+			options.filter = argv[++i];
+		else if (strcmp(argv[i], "--json") == 0 && value)
+			options.jsonPath = argv[++i];
+		else if (strcmp(argv[i], "--threads") == 0 && value && atoi(value) > 0)
+			options.maxThreads = atoi(argv[++i]);
+		else
+		{
+			PrintUsage(argv[0]);
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	RenderAPI* api = CreateRenderAPI(kUnityGfxRendererNull);
+	if (!api)
+	{
+		fprintf(stderr, "null RenderAPI not available, build with SUPPORT_NULL=1\n");
+		return 1;
+	}
+	api->ProcessDeviceEvent(kUnityGfxDeviceEventInitialize, NULL);
+
+	const bool mathOk = CheckMathFunctions();
+	const bool kernelsOk = CheckPlasmaKernels();
+	const bool vertexKernelsOk = CheckVertexKernels() && CheckParallelDeformation() && CheckVertexArrayKernels() && CheckMeshSourceCopy() &&
+		CheckMeshBatch();
+
+	BenchMath(options);
+	BenchTriangle(options, api);
+	BenchTextures(options, api);
+	BenchMeshes(options, api);
+	BenchMeshBatch(options, api);
+
+	api->ProcessDeviceEvent(kUnityGfxDeviceEventShutdown, NULL);
+	delete api;
+
+	if (!options.jsonPath.empty() && !WriteJson(options.jsonPath.c_str()))
+	{
+		fprintf(stderr, "failed to write %s\n", options.jsonPath.c_str());
+		return 1;
+	}
+	return mathOk && kernelsOk && vertexKernelsOk ? 0 : 1;
+}
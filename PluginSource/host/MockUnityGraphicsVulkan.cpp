@@ -0,0 +1,1094 @@
+#include "MockUnityGraphicsVulkan.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <dlfcn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define MOCK_USED_VULKAN_API_FUNCTIONS(apply) \
+	apply(vkDestroyInstance); \
+	apply(vkEnumeratePhysicalDevices); \
+	apply(vkGetPhysicalDeviceProperties); \
+	apply(vkGetPhysicalDeviceQueueFamilyProperties); \
+	apply(vkGetPhysicalDeviceMemoryProperties); \
+	apply(vkCreateDevice); \
+	apply(vkDestroyDevice); \
+	apply(vkGetDeviceQueue); \
+	apply(vkDeviceWaitIdle); \
+	apply(vkQueueSubmit); \
+	apply(vkQueueWaitIdle); \
+	apply(vkCreatePipelineCache); \
+	apply(vkDestroyPipelineCache); \
+	apply(vkCreateCommandPool); \
+	apply(vkDestroyCommandPool); \
+	apply(vkAllocateCommandBuffers); \
+	apply(vkFreeCommandBuffers); \
+	apply(vkBeginCommandBuffer); \
+	apply(vkEndCommandBuffer); \
+	apply(vkResetCommandBuffer); \
+	apply(vkCreateFence); \
+	apply(vkDestroyFence); \
+	apply(vkWaitForFences); \
+	apply(vkResetFences); \
+	apply(vkGetFenceStatus); \
+	apply(vkCreateRenderPass); \
+	apply(vkDestroyRenderPass); \
+	apply(vkCreateFramebuffer); \
+	apply(vkDestroyFramebuffer); \
+	apply(vkCreateImage); \
+	apply(vkDestroyImage); \
+	apply(vkCreateImageView); \
+	apply(vkDestroyImageView); \
+	apply(vkGetImageMemoryRequirements); \
+	apply(vkCreateBuffer); \
+	apply(vkDestroyBuffer); \
+	apply(vkGetBufferMemoryRequirements); \
+	apply(vkAllocateMemory); \
+	apply(vkFreeMemory); \
+	apply(vkBindImageMemory); \
+	apply(vkBindBufferMemory); \
+	apply(vkMapMemory); \
+	apply(vkUnmapMemory); \
+	apply(vkCmdBeginRenderPass); \
+	apply(vkCmdEndRenderPass); \
+	apply(vkCmdSetViewport); \
+	apply(vkCmdSetScissor); \
+	apply(vkCmdPipelineBarrier); \
+	apply(vkCmdCopyImageToBuffer);
+
+#define VULKAN_DEFINE_API_FUNCPTR(func) static PFN_##func func
+VULKAN_DEFINE_API_FUNCPTR(vkCreateInstance);
+MOCK_USED_VULKAN_API_FUNCTIONS(VULKAN_DEFINE_API_FUNCPTR);
+#undef VULKAN_DEFINE_API_FUNCPTR
+
+
+// Size of the offscreen color target the frame's render pass draws into
+static const uint32_t kRenderTargetSize = 256;
+static const VkFormat kColorFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+
+MockUnityGraphicsVulkan* MockUnityGraphicsVulkan::s_Instance = NULL;
+
+// vkGetInstanceProcAddr returned by the plugins' initialization callbacks. Like the one
+// in RenderingPlugin, these only return the entry points they intercept, so fall back
+// to the loader for everything else.
+static PFN_vkGetInstanceProcAddr s_InterceptedGetInstanceProcAddr = NULL;
+static PFN_vkGetInstanceProcAddr s_LoaderGetInstanceProcAddr = NULL;
+
+static PFN_vkVoidFunction GetInstanceProc(VkInstance instance, const char* name)
+{
+	PFN_vkVoidFunction func = NULL;
+	if (s_InterceptedGetInstanceProcAddr)
+		func = s_InterceptedGetInstanceProcAddr(instance, name);
+	if (!func)
+		func = s_LoaderGetInstanceProcAddr(instance, name);
+	return func;
+}
+
+
+MockUnityGraphicsVulkan::MockUnityGraphicsVulkan()
+	: m_LoaderLibrary(NULL)
+	, m_LoaderGetInstanceProcAddr(NULL)
+	, m_Instance()
+	, m_CommandPool(VK_NULL_HANDLE)
+	, m_ColorImage(VK_NULL_HANDLE)
+	, m_ColorMemory(VK_NULL_HANDLE)
+	, m_ColorView(VK_NULL_HANDLE)
+	, m_ClearRenderPass(VK_NULL_HANDLE)
+	, m_LoadRenderPass(VK_NULL_HANDLE)
+	, m_Framebuffer(VK_NULL_HANDLE)
+	, m_FrameNumber(0)
+	, m_SafeFrameNumber(0)
+	, m_InsideFrame(false)
+	, m_InsideRenderPass(false)
+{
+	assert(s_Instance == NULL);
+	s_Instance = this;
+
+	memset(&m_MemoryProperties, 0, sizeof(m_MemoryProperties));
+	memset(m_Frames, 0, sizeof(m_Frames));
+
+	memset(&m_Interface, 0, sizeof(m_Interface));
+	m_Interface.InterceptInitialization = InterceptInitialization;
+	m_Interface.InterceptVulkanAPI = InterceptVulkanAPI;
+	m_Interface.ConfigureEvent = ConfigureEvent;
+	m_Interface.Instance = Instance;
+	m_Interface.CommandRecordingState = CommandRecordingState;
+	m_Interface.AccessTexture = AccessTexture;
+	m_Interface.AccessRenderBufferTexture = AccessRenderBufferTexture;
+	m_Interface.AccessRenderBufferResolveTexture = AccessRenderBufferTexture;
+	m_Interface.AccessBuffer = AccessBuffer;
+	m_Interface.EnsureOutsideRenderPass = EnsureOutsideRenderPass;
+	m_Interface.EnsureInsideRenderPass = EnsureInsideRenderPass;
+	m_Interface.AccessQueue = AccessQueue;
+	m_Interface.ConfigureSwapchain = ConfigureSwapchain;
+
+	memset(&m_InterfaceV2, 0, sizeof(m_InterfaceV2));
+	m_InterfaceV2.InterceptInitialization = InterceptInitialization;
+	m_InterfaceV2.InterceptVulkanAPI = InterceptVulkanAPI;
+	m_InterfaceV2.ConfigureEvent = ConfigureEvent;
+	m_InterfaceV2.Instance = Instance;
+	m_InterfaceV2.CommandRecordingState = CommandRecordingState;
+	m_InterfaceV2.AccessTexture = AccessTexture;
+	m_InterfaceV2.AccessRenderBufferTexture = AccessRenderBufferTexture;
+	m_InterfaceV2.AccessRenderBufferResolveTexture = AccessRenderBufferTexture;
+	m_InterfaceV2.AccessBuffer = AccessBuffer;
+	m_InterfaceV2.EnsureOutsideRenderPass = EnsureOutsideRenderPass;
+	m_InterfaceV2.EnsureInsideRenderPass = EnsureInsideRenderPass;
+	m_InterfaceV2.AccessQueue = AccessQueue;
+	m_InterfaceV2.ConfigureSwapchain = ConfigureSwapchain;
+	m_InterfaceV2.AccessTextureByID = AccessTextureByID;
+	m_InterfaceV2.AddInterceptInitialization = AddInterceptInitialization;
+	m_InterfaceV2.RemoveInterceptInitialization = RemoveInterceptInitialization;
+}
+
+
+MockUnityGraphicsVulkan::~MockUnityGraphicsVulkan()
+{
+	Shutdown();
+	s_Instance = NULL;
+}
+
+
+bool MockUnityGraphicsVulkan::Initialize()
+{
+	m_LoaderLibrary = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+	if (!m_LoaderLibrary)
+		m_LoaderLibrary = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
+	if (!m_LoaderLibrary)
+	{
+		fprintf(stderr, "failed to load the Vulkan loader: %s\n", dlerror());
+		return false;
+	}
+	m_LoaderGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)dlsym(m_LoaderLibrary, "vkGetInstanceProcAddr");
+	if (!m_LoaderGetInstanceProcAddr)
+	{
+		fprintf(stderr, "vkGetInstanceProcAddr not found in the Vulkan loader\n");
+		return false;
+	}
+	s_LoaderGetInstanceProcAddr = m_LoaderGetInstanceProcAddr;
+
+	// Run the initialization callbacks; the one with the highest priority wraps the loader directly
+	std::vector<InitCallback> callbacks = m_InitCallbacks;
+	std::stable_sort(callbacks.begin(), callbacks.end(),
+		[](const InitCallback& a, const InitCallback& b) { return a.priority > b.priority; });
+	PFN_vkGetInstanceProcAddr getInstanceProcAddr = m_LoaderGetInstanceProcAddr;
+	for (size_t i = 0; i < callbacks.size(); ++i)
+	{
+		PFN_vkGetInstanceProcAddr intercepted = callbacks[i].func(getInstanceProcAddr, callbacks[i].userData);
+		if (intercepted)
+			getInstanceProcAddr = intercepted;
+	}
+	if (getInstanceProcAddr != m_LoaderGetInstanceProcAddr)
+		s_InterceptedGetInstanceProcAddr = getInstanceProcAddr;
+
+	vkCreateInstance = (PFN_vkCreateInstance)GetInstanceProc(VK_NULL_HANDLE, "vkCreateInstance");
+	if (!vkCreateInstance)
+	{
+		fprintf(stderr, "vkCreateInstance not found\n");
+		return false;
+	}
+
+	VkApplicationInfo appInfo = {};
+	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+	appInfo.pApplicationName = "RenderingPlugin host";
+	appInfo.pEngineName = "MockUnityGraphicsVulkan";
+	appInfo.apiVersion = VK_API_VERSION_1_0;
+
+	VkInstanceCreateInfo instanceInfo = {};
+	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+	instanceInfo.pApplicationInfo = &appInfo;
+
+	VkResult result = vkCreateInstance(&instanceInfo, NULL, &m_Instance.instance);
+	if (result != VK_SUCCESS)
+	{
+		fprintf(stderr, "vkCreateInstance failed (%d)\n", (int)result);
+		return false;
+	}
+	m_Instance.getInstanceProcAddr = m_LoaderGetInstanceProcAddr;
+
+	bool loaded = true;
+#define LOAD_VULKAN_FUNC(fn) if (!(fn = (PFN_##fn)GetInstanceProc(m_Instance.instance, #fn))) { fprintf(stderr, "%s not found\n", #fn); loaded = false; }
+	MOCK_USED_VULKAN_API_FUNCTIONS(LOAD_VULKAN_FUNC);
+#undef LOAD_VULKAN_FUNC
+	if (!loaded)
+		return false;
+
+	return CreateDevice() && CreateRenderTarget();
+}
+
+
+bool MockUnityGraphicsVulkan::CreateDevice()
+{
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(m_Instance.instance, &deviceCount, NULL);
+	std::vector<VkPhysicalDevice> devices(deviceCount);
+	if (deviceCount > 0)
+		vkEnumeratePhysicalDevices(m_Instance.instance, &deviceCount, devices.data());
+
+	// Prefer a CPU implementation (lavapipe), so results don't depend on the GPU of the machine
+	int selectedQueueFamily = -1;
+	for (int pass = 0; pass < 2 && selectedQueueFamily < 0; ++pass)
+	{
+		for (uint32_t i = 0; i < deviceCount && selectedQueueFamily < 0; ++i)
+		{
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(devices[i], &properties);
+			if (pass == 0 && properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU)
+				continue;
+
+			uint32_t familyCount = 0;
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, NULL);
+			std::vector<VkQueueFamilyProperties> families(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &familyCount, families.data());
+			for (uint32_t family = 0; family < familyCount; ++family)
+			{
+				if (families[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+				{
+					selectedQueueFamily = int(family);
+					m_Instance.physicalDevice = devices[i];
+					m_DeviceName = properties.deviceName;
+					break;
+				}
+			}
+		}
+	}
+	if (selectedQueueFamily < 0)
+	{
+		fprintf(stderr, "no Vulkan device with a graphics queue found\n");
+		return false;
+	}
+	m_Instance.queueFamilyIndex = unsigned(selectedQueueFamily);
+	vkGetPhysicalDeviceMemoryProperties(m_Instance.physicalDevice, &m_MemoryProperties);
+
+	const float queuePriority = 1.0f;
+	VkDeviceQueueCreateInfo queueInfo = {};
+	queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueInfo.queueFamilyIndex = m_Instance.queueFamilyIndex;
+	queueInfo.queueCount = 1;
+	queueInfo.pQueuePriorities = &queuePriority;
+
+	VkDeviceCreateInfo deviceInfo = {};
+	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.pQueueCreateInfos = &queueInfo;
+
+	VkResult result = vkCreateDevice(m_Instance.physicalDevice, &deviceInfo, NULL, &m_Instance.device);
+	if (result != VK_SUCCESS)
+	{
+		fprintf(stderr, "vkCreateDevice failed (%d)\n", (int)result);
+		return false;
+	}
+	vkGetDeviceQueue(m_Instance.device, m_Instance.queueFamilyIndex, 0, &m_Instance.graphicsQueue);
+
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	if (vkCreatePipelineCache(m_Instance.device, &cacheInfo, NULL, &m_Instance.pipelineCache) != VK_SUCCESS)
+		m_Instance.pipelineCache = VK_NULL_HANDLE;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = m_Instance.queueFamilyIndex;
+	if (vkCreateCommandPool(m_Instance.device, &poolInfo, NULL, &m_CommandPool) != VK_SUCCESS)
+	{
+		fprintf(stderr, "vkCreateCommandPool failed\n");
+		return false;
+	}
+
+	for (int i = 0; i < kFramesInFlight; ++i)
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_CommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		// Created signaled, so that waiting for a slot that was never submitted returns right away
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		if (vkAllocateCommandBuffers(m_Instance.device, &allocInfo, &m_Frames[i].commandBuffer) != VK_SUCCESS ||
+			vkCreateFence(m_Instance.device, &fenceInfo, NULL, &m_Frames[i].fence) != VK_SUCCESS)
+		{
+			fprintf(stderr, "failed to create the frame command buffers\n");
+			return false;
+		}
+		m_Frames[i].frameNumber = 0;
+	}
+	return true;
+}
+
+
+bool MockUnityGraphicsVulkan::CreateRenderTarget()
+{
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = kColorFormat;
+	imageInfo.extent.width = kRenderTargetSize;
+	imageInfo.extent.height = kRenderTargetSize;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(m_Instance.device, &imageInfo, NULL, &m_ColorImage) != VK_SUCCESS)
+	{
+		fprintf(stderr, "failed to create the render target image\n");
+		return false;
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(m_Instance.device, m_ColorImage, &requirements);
+	unsigned int typeIndex;
+	if (!AllocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_ColorMemory, &typeIndex) ||
+		vkBindImageMemory(m_Instance.device, m_ColorImage, m_ColorMemory, 0) != VK_SUCCESS)
+	{
+		fprintf(stderr, "failed to allocate the render target memory\n");
+		return false;
+	}
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = m_ColorImage;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = kColorFormat;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.layerCount = 1;
+	if (vkCreateImageView(m_Instance.device, &viewInfo, NULL, &m_ColorView) != VK_SUCCESS)
+	{
+		fprintf(stderr, "failed to create the render target view\n");
+		return false;
+	}
+
+	// Two compatible render passes: the first one of a frame clears, the ones after
+	// an EnsureOutsideRenderPass continue with the previous contents
+	for (int i = 0; i < 2; ++i)
+	{
+		const bool clear = i == 0;
+
+		VkAttachmentDescription attachment = {};
+		attachment.format = kColorFormat;
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		attachment.loadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout = clear ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorReference = {};
+		colorReference.attachment = 0;
+		colorReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorReference;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &attachment;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		VkRenderPass& renderPass = clear ? m_ClearRenderPass : m_LoadRenderPass;
+		if (vkCreateRenderPass(m_Instance.device, &renderPassInfo, NULL, &renderPass) != VK_SUCCESS)
+		{
+			fprintf(stderr, "failed to create the render pass\n");
+			return false;
+		}
+	}
+
+	VkFramebufferCreateInfo framebufferInfo = {};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = m_ClearRenderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.pAttachments = &m_ColorView;
+	framebufferInfo.width = kRenderTargetSize;
+	framebufferInfo.height = kRenderTargetSize;
+	framebufferInfo.layers = 1;
+	if (vkCreateFramebuffer(m_Instance.device, &framebufferInfo, NULL, &m_Framebuffer) != VK_SUCCESS)
+	{
+		fprintf(stderr, "failed to create the framebuffer\n");
+		return false;
+	}
+	return true;
+}
+
+
+void MockUnityGraphicsVulkan::Shutdown()
+{
+	if (m_Instance.device != VK_NULL_HANDLE)
+	{
+		VkDevice device = m_Instance.device;
+		vkDeviceWaitIdle(device);
+		GarbageCollect(true);
+
+		for (size_t i = 0; i < m_Textures.size(); ++i)
+		{
+			vkDestroyImage(device, m_Textures[i]->image, NULL);
+			vkFreeMemory(device, m_Textures[i]->memory, NULL);
+			delete m_Textures[i];
+		}
+		m_Textures.clear();
+		for (size_t i = 0; i < m_Buffers.size(); ++i)
+		{
+			DestroyBufferMemory(*m_Buffers[i]);
+			delete m_Buffers[i];
+		}
+		m_Buffers.clear();
+
+		vkDestroyFramebuffer(device, m_Framebuffer, NULL);
+		vkDestroyRenderPass(device, m_ClearRenderPass, NULL);
+		vkDestroyRenderPass(device, m_LoadRenderPass, NULL);
+		vkDestroyImageView(device, m_ColorView, NULL);
+		vkDestroyImage(device, m_ColorImage, NULL);
+		vkFreeMemory(device, m_ColorMemory, NULL);
+		for (int i = 0; i < kFramesInFlight; ++i)
+			vkDestroyFence(device, m_Frames[i].fence, NULL);
+		vkDestroyCommandPool(device, m_CommandPool, NULL);
+		vkDestroyPipelineCache(device, m_Instance.pipelineCache, NULL);
+		vkDestroyDevice(device, NULL);
+	}
+	if (m_Instance.instance != VK_NULL_HANDLE)
+		vkDestroyInstance(m_Instance.instance, NULL);
+	if (m_LoaderLibrary)
+		dlclose(m_LoaderLibrary);
+
+	m_LoaderLibrary = NULL;
+	m_LoaderGetInstanceProcAddr = NULL;
+	s_LoaderGetInstanceProcAddr = NULL;
+	s_InterceptedGetInstanceProcAddr = NULL;
+	m_Instance = UnityVulkanInstance();
+	m_CommandPool = VK_NULL_HANDLE;
+	memset(m_Frames, 0, sizeof(m_Frames));
+	m_ColorImage = VK_NULL_HANDLE;
+	m_ColorMemory = VK_NULL_HANDLE;
+	m_ColorView = VK_NULL_HANDLE;
+	m_ClearRenderPass = VK_NULL_HANDLE;
+	m_LoadRenderPass = VK_NULL_HANDLE;
+	m_Framebuffer = VK_NULL_HANDLE;
+	m_InsideFrame = false;
+	m_InsideRenderPass = false;
+}
+
+
+bool MockUnityGraphicsVulkan::AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags flags, VkDeviceMemory* memory, unsigned int* typeIndex)
+{
+	for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; ++i)
+	{
+		if ((requirements.memoryTypeBits & (1u << i)) && (m_MemoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+		{
+			VkMemoryAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = requirements.size;
+			allocInfo.memoryTypeIndex = i;
+			*typeIndex = i;
+			return vkAllocateMemory(m_Instance.device, &allocInfo, NULL, memory) == VK_SUCCESS;
+		}
+	}
+	return false;
+}
+
+
+MockVulkanTexture* MockUnityGraphicsVulkan::CreateTexture(int width, int height, VkFormat format)
+{
+	MockVulkanTexture* texture = new MockVulkanTexture();
+	texture->format = format;
+	texture->width = width;
+	texture->height = height;
+	texture->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	texture->stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	texture->access = 0;
+
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = texture->format;
+	imageInfo.extent.width = uint32_t(width);
+	imageInfo.extent.height = uint32_t(height);
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkMemoryRequirements requirements = {};
+	bool success = vkCreateImage(m_Instance.device, &imageInfo, NULL, &texture->image) == VK_SUCCESS;
+	if (success)
+	{
+		vkGetImageMemoryRequirements(m_Instance.device, texture->image, &requirements);
+		success = AllocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &texture->memory, &texture->memoryTypeIndex) &&
+			vkBindImageMemory(m_Instance.device, texture->image, texture->memory, 0) == VK_SUCCESS;
+	}
+	if (!success)
+	{
+		fprintf(stderr, "failed to create a %dx%d texture\n", width, height);
+		if (texture->image != VK_NULL_HANDLE)
+			vkDestroyImage(m_Instance.device, texture->image, NULL);
+		if (texture->memory != VK_NULL_HANDLE)
+			vkFreeMemory(m_Instance.device, texture->memory, NULL);
+		delete texture;
+		return NULL;
+	}
+	texture->memorySize = requirements.size;
+
+	m_Textures.push_back(texture);
+	return texture;
+}
+
+
+bool MockUnityGraphicsVulkan::CreateBufferMemory(MockVulkanBuffer& buffer)
+{
+	buffer.buffer = VK_NULL_HANDLE;
+	buffer.memory = VK_NULL_HANDLE;
+	buffer.mapped = NULL;
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = buffer.sizeInBytes;
+	bufferInfo.usage = buffer.usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateBuffer(m_Instance.device, &bufferInfo, NULL, &buffer.buffer) != VK_SUCCESS)
+		return false;
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(m_Instance.device, buffer.buffer, &requirements);
+	if (!AllocateMemory(requirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &buffer.memory, &buffer.memoryTypeIndex) ||
+		vkBindBufferMemory(m_Instance.device, buffer.buffer, buffer.memory, 0) != VK_SUCCESS ||
+		vkMapMemory(m_Instance.device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped) != VK_SUCCESS)
+	{
+		DestroyBufferMemory(buffer);
+		return false;
+	}
+	buffer.memorySize = requirements.size;
+	buffer.memoryFlags = m_MemoryProperties.memoryTypes[buffer.memoryTypeIndex].propertyFlags;
+	return true;
+}
+
+
+void MockUnityGraphicsVulkan::DestroyBufferMemory(const MockVulkanBuffer& buffer)
+{
+	if (buffer.buffer != VK_NULL_HANDLE)
+		vkDestroyBuffer(m_Instance.device, buffer.buffer, NULL);
+	if (buffer.mapped)
+		vkUnmapMemory(m_Instance.device, buffer.memory);
+	if (buffer.memory != VK_NULL_HANDLE)
+		vkFreeMemory(m_Instance.device, buffer.memory, NULL);
+}
+
+
+MockVulkanBuffer* MockUnityGraphicsVulkan::CreateVertexBuffer(size_t sizeInBytes)
+{
+	MockVulkanBuffer* buffer = new MockVulkanBuffer();
+	buffer->sizeInBytes = sizeInBytes;
+	buffer->usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if (!CreateBufferMemory(*buffer))
+	{
+		fprintf(stderr, "failed to create a vertex buffer of %zu bytes\n", sizeInBytes);
+		delete buffer;
+		return NULL;
+	}
+	memset(buffer->mapped, 0, sizeInBytes);
+	m_Buffers.push_back(buffer);
+	return buffer;
+}
+
+
+MockVulkanTexture* MockUnityGraphicsVulkan::FindTexture(void* nativeTexture)
+{
+	std::vector<MockVulkanTexture*>::iterator it = std::find(m_Textures.begin(), m_Textures.end(), (MockVulkanTexture*)nativeTexture);
+	return it != m_Textures.end() ? *it : NULL;
+}
+
+
+MockVulkanBuffer* MockUnityGraphicsVulkan::FindBuffer(void* nativeBuffer)
+{
+	std::vector<MockVulkanBuffer*>::iterator it = std::find(m_Buffers.begin(), m_Buffers.end(), (MockVulkanBuffer*)nativeBuffer);
+	return it != m_Buffers.end() ? *it : NULL;
+}
+
+
+void MockUnityGraphicsVulkan::BeginRenderPass(VkRenderPass renderPass)
+{
+	VkClearValue clearValue = {};
+	clearValue.color.float32[0] = 0.0f;
+	clearValue.color.float32[1] = 0.0f;
+	clearValue.color.float32[2] = 0.25f;
+	clearValue.color.float32[3] = 1.0f;
+
+	VkRenderPassBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	beginInfo.renderPass = renderPass;
+	beginInfo.framebuffer = m_Framebuffer;
+	beginInfo.renderArea.extent.width = kRenderTargetSize;
+	beginInfo.renderArea.extent.height = kRenderTargetSize;
+	beginInfo.clearValueCount = 1;
+	beginInfo.pClearValues = &clearValue;
+
+	// Goes through the plugin's hook if it intercepted vkCmdBeginRenderPass
+	PFN_vkCmdBeginRenderPass cmdBeginRenderPass = vkCmdBeginRenderPass;
+	std::map<std::string, PFN_vkVoidFunction>::const_iterator it = m_InterceptedFunctions.find("vkCmdBeginRenderPass");
+	if (it != m_InterceptedFunctions.end())
+		cmdBeginRenderPass = (PFN_vkCmdBeginRenderPass)it->second;
+
+	VkCommandBuffer commandBuffer = m_Frames[m_FrameNumber % kFramesInFlight].commandBuffer;
+	cmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	// Unity sets the dynamic viewport and scissor state for plugin events inside a render pass
+	VkViewport viewport = {};
+	viewport.width = float(kRenderTargetSize);
+	viewport.height = float(kRenderTargetSize);
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &beginInfo.renderArea);
+
+	m_InsideRenderPass = true;
+}
+
+
+void MockUnityGraphicsVulkan::UpdateSafeFrameNumber()
+{
+	// Single queue, so a signaled fence also means all earlier frames are done
+	for (int i = 0; i < kFramesInFlight; ++i)
+	{
+		if (m_Frames[i].frameNumber > m_SafeFrameNumber && vkGetFenceStatus(m_Instance.device, m_Frames[i].fence) == VK_SUCCESS)
+			m_SafeFrameNumber = m_Frames[i].frameNumber;
+	}
+}
+
+
+void MockUnityGraphicsVulkan::GarbageCollect(bool force)
+{
+	DeleteQueue::iterator it = m_DeleteQueue.begin();
+	while (it != m_DeleteQueue.end())
+	{
+		if (force || it->first <= m_SafeFrameNumber)
+		{
+			for (size_t i = 0; i < it->second.size(); ++i)
+				DestroyBufferMemory(it->second[i]);
+			m_DeleteQueue.erase(it++);
+		}
+		else
+			++it;
+	}
+}
+
+
+void MockUnityGraphicsVulkan::BeginFrame()
+{
+	assert(!m_InsideFrame);
+	++m_FrameNumber;
+	FrameSlot& slot = m_Frames[m_FrameNumber % kFramesInFlight];
+
+	// Wait for the frame that used this command buffer kFramesInFlight frames ago
+	vkWaitForFences(m_Instance.device, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+	UpdateSafeFrameNumber();
+	GarbageCollect(false);
+
+	vkResetFences(m_Instance.device, 1, &slot.fence);
+	vkResetCommandBuffer(slot.commandBuffer, 0);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(slot.commandBuffer, &beginInfo);
+
+	m_InsideFrame = true;
+	BeginRenderPass(m_ClearRenderPass);
+}
+
+
+void MockUnityGraphicsVulkan::BeforeEvent(int eventID)
+{
+	std::map<int, UnityVulkanPluginEventConfig>::const_iterator it = m_EventConfigs.find(eventID);
+	if (it == m_EventConfigs.end())
+		return;
+
+	if (it->second.renderPassPrecondition == kUnityVulkanRenderPass_EnsureInside)
+		EnsureInsideRenderPass();
+	else if (it->second.renderPassPrecondition == kUnityVulkanRenderPass_EnsureOutside)
+		EnsureOutsideRenderPass();
+}
+
+
+void MockUnityGraphicsVulkan::EndFrame()
+{
+	assert(m_InsideFrame);
+	FrameSlot& slot = m_Frames[m_FrameNumber % kFramesInFlight];
+	if (m_InsideRenderPass)
+	{
+		vkCmdEndRenderPass(slot.commandBuffer);
+		m_InsideRenderPass = false;
+	}
+	vkEndCommandBuffer(slot.commandBuffer);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &slot.commandBuffer;
+	VkResult result = vkQueueSubmit(m_Instance.graphicsQueue, 1, &submitInfo, slot.fence);
+	if (result != VK_SUCCESS)
+		fprintf(stderr, "vkQueueSubmit failed for frame %llu (%d)\n", m_FrameNumber, (int)result);
+
+	slot.frameNumber = m_FrameNumber;
+	m_InsideFrame = false;
+}
+
+
+void MockUnityGraphicsVulkan::WaitIdle()
+{
+	vkDeviceWaitIdle(m_Instance.device);
+	UpdateSafeFrameNumber();
+	GarbageCollect(false);
+}
+
+
+bool MockUnityGraphicsVulkan::ReadTexture(MockVulkanTexture* texture, std::vector<unsigned char>& pixels)
+{
+	assert(!m_InsideFrame);
+	MockVulkanBuffer staging = {};
+	int bytesPerPixel = 4;
+	if (texture->format == VK_FORMAT_R8_UNORM)
+		bytesPerPixel = 1;
+	else if (texture->format == VK_FORMAT_R8G8_UNORM)
+		bytesPerPixel = 2;
+	staging.sizeInBytes = size_t(texture->width) * texture->height * bytesPerPixel;
+	staging.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if (!CreateBufferMemory(staging))
+		return false;
+
+	VkCommandBufferAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = m_CommandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	VkCommandBuffer commandBuffer;
+	if (vkAllocateCommandBuffers(m_Instance.device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+	{
+		DestroyBufferMemory(staging);
+		return false;
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	VkImageMemoryBarrier imageBarrier = {};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = texture->access;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = texture->layout;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = texture->image;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, texture->stage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &imageBarrier);
+
+	VkBufferImageCopy region = {};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent.width = uint32_t(texture->width);
+	region.imageExtent.height = uint32_t(texture->height);
+	region.imageExtent.depth = 1;
+	vkCmdCopyImageToBuffer(commandBuffer, texture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging.buffer, 1, &region);
+
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = staging.buffer;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &bufferBarrier, 0, NULL);
+
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	bool success = vkQueueSubmit(m_Instance.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) == VK_SUCCESS &&
+		vkQueueWaitIdle(m_Instance.graphicsQueue) == VK_SUCCESS;
+	if (success)
+	{
+		pixels.resize(staging.sizeInBytes);
+		memcpy(pixels.data(), staging.mapped, staging.sizeInBytes);
+	}
+	texture->layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	texture->stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	texture->access = VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkFreeCommandBuffers(m_Instance.device, m_CommandPool, 1, &commandBuffer);
+	DestroyBufferMemory(staging);
+	return success;
+}
+
+
+// --------------------------------------------------------------------------
+// IUnityGraphicsVulkan
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::InterceptInitialization(UnityVulkanInitCallback func, void* userdata)
+{
+	return AddInterceptInitialization(func, userdata, kUnityVulkanInitCallbackMaxPriority);
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::AddInterceptInitialization(UnityVulkanInitCallback func, void* userdata, int32_t priority)
+{
+	// Too late once the instance exists
+	if (s_Instance->m_Instance.instance != VK_NULL_HANDLE)
+		return false;
+
+	std::vector<InitCallback>& callbacks = s_Instance->m_InitCallbacks;
+	for (size_t i = 0; i < callbacks.size(); ++i)
+	{
+		// Only one callback may have the maximum priority, a new one replaces it
+		if (callbacks[i].func == func || (priority == kUnityVulkanInitCallbackMaxPriority && callbacks[i].priority == priority))
+		{
+			callbacks.erase(callbacks.begin() + i);
+			break;
+		}
+	}
+	InitCallback callback = { func, userdata, priority };
+	callbacks.push_back(callback);
+	return true;
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::RemoveInterceptInitialization(UnityVulkanInitCallback func)
+{
+	std::vector<InitCallback>& callbacks = s_Instance->m_InitCallbacks;
+	for (size_t i = 0; i < callbacks.size(); ++i)
+	{
+		if (callbacks[i].func == func)
+		{
+			callbacks.erase(callbacks.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+PFN_vkVoidFunction UNITY_INTERFACE_API MockUnityGraphicsVulkan::InterceptVulkanAPI(const char* name, PFN_vkVoidFunction func)
+{
+	// Only vkCmdBeginRenderPass is called through the intercepted pointer, it's the
+	// only function the mock itself records that plugins are interested in
+	std::map<std::string, PFN_vkVoidFunction>& intercepted = s_Instance->m_InterceptedFunctions;
+	std::map<std::string, PFN_vkVoidFunction>::const_iterator it = intercepted.find(name);
+	PFN_vkVoidFunction previous = it != intercepted.end() ? it->second : GetInstanceProc(s_Instance->m_Instance.instance, name);
+	intercepted[name] = func;
+	return previous;
+}
+
+
+void UNITY_INTERFACE_API MockUnityGraphicsVulkan::ConfigureEvent(int eventID, const UnityVulkanPluginEventConfig* pluginEventConfig)
+{
+	if (pluginEventConfig)
+		s_Instance->m_EventConfigs[eventID] = *pluginEventConfig;
+	else
+		s_Instance->m_EventConfigs.erase(eventID);
+}
+
+
+UnityVulkanInstance UNITY_INTERFACE_API MockUnityGraphicsVulkan::Instance()
+{
+	return s_Instance->m_Instance;
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::CommandRecordingState(UnityVulkanRecordingState* outCommandRecordingState, UnityVulkanGraphicsQueueAccess queueAccess)
+{
+	MockUnityGraphicsVulkan& self = *s_Instance;
+	if (!self.m_InsideFrame)
+		return false;
+
+	memset(outCommandRecordingState, 0, sizeof(*outCommandRecordingState));
+	outCommandRecordingState->commandBuffer = self.m_Frames[self.m_FrameNumber % kFramesInFlight].commandBuffer;
+	outCommandRecordingState->commandBufferLevel = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	// Always report the "clear" pass, the "load" one is compatible with it
+	outCommandRecordingState->renderPass = self.m_InsideRenderPass ? self.m_ClearRenderPass : VK_NULL_HANDLE;
+	outCommandRecordingState->framebuffer = self.m_InsideRenderPass ? self.m_Framebuffer : VK_NULL_HANDLE;
+	outCommandRecordingState->subPassIndex = self.m_InsideRenderPass ? 0 : -1;
+	outCommandRecordingState->currentFrameNumber = self.m_FrameNumber;
+	outCommandRecordingState->safeFrameNumber = self.m_SafeFrameNumber;
+	return true;
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::AccessTexture(void* nativeTexture, const VkImageSubresource* subResource, VkImageLayout layout,
+	VkPipelineStageFlags pipelineStageFlags, VkAccessFlags accessFlags, UnityVulkanResourceAccessMode accessMode, UnityVulkanImage* outImage)
+{
+	MockUnityGraphicsVulkan& self = *s_Instance;
+	MockVulkanTexture* texture = self.FindTexture(nativeTexture);
+	if (!texture)
+		return false;
+
+	if (accessMode == kUnityVulkanResourceAccess_Recreate)
+		return false; // not needed by the plugin, textures are only ever written in place
+
+	if (accessMode == kUnityVulkanResourceAccess_PipelineBarrier)
+	{
+		// Barriers are recorded into the frame's command buffer, which can't be done inside the render pass
+		if (!self.m_InsideFrame || self.m_InsideRenderPass)
+			return false;
+
+		// Always transitions the whole image; the plugin only uses UnityVulkanWholeImage
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = texture->access;
+		barrier.dstAccessMask = accessFlags;
+		barrier.oldLayout = texture->layout;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = texture->image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		vkCmdPipelineBarrier(self.m_Frames[self.m_FrameNumber % kFramesInFlight].commandBuffer,
+			texture->stage, pipelineStageFlags, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+		texture->layout = layout;
+		texture->stage = pipelineStageFlags;
+		texture->access = accessFlags;
+	}
+
+	memset(outImage, 0, sizeof(*outImage));
+	outImage->memory.memory = texture->memory;
+	outImage->memory.size = texture->memorySize;
+	outImage->memory.flags = self.m_MemoryProperties.memoryTypes[texture->memoryTypeIndex].propertyFlags;
+	outImage->memory.memoryTypeIndex = texture->memoryTypeIndex;
+	outImage->image = texture->image;
+	outImage->layout = texture->layout;
+	outImage->aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+	outImage->usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	outImage->format = texture->format;
+	outImage->extent.width = uint32_t(texture->width);
+	outImage->extent.height = uint32_t(texture->height);
+	outImage->extent.depth = 1;
+	outImage->tiling = VK_IMAGE_TILING_OPTIMAL;
+	outImage->type = VK_IMAGE_TYPE_2D;
+	outImage->samples = VK_SAMPLE_COUNT_1_BIT;
+	outImage->layers = 1;
+	outImage->mipCount = 1;
+	return true;
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::AccessRenderBufferTexture(UnityRenderBuffer, const VkImageSubresource*, VkImageLayout,
+	VkPipelineStageFlags, VkAccessFlags, UnityVulkanResourceAccessMode, UnityVulkanImage*)
+{
+	return false; // the host has no render buffers
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::AccessTextureByID(UnityTextureID, const VkImageSubresource*, VkImageLayout,
+	VkPipelineStageFlags, VkAccessFlags, UnityVulkanResourceAccessMode, UnityVulkanImage*)
+{
+	return false; // texture IDs only come from texture update callbacks, which the host does not send
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::AccessBuffer(void* nativeBuffer, VkPipelineStageFlags pipelineStageFlags, VkAccessFlags accessFlags,
+	UnityVulkanResourceAccessMode accessMode, UnityVulkanBuffer* outBuffer)
+{
+	MockUnityGraphicsVulkan& self = *s_Instance;
+	MockVulkanBuffer* buffer = self.FindBuffer(nativeBuffer);
+	if (!buffer)
+		return false;
+
+	if (accessMode == kUnityVulkanResourceAccess_Recreate)
+	{
+		// Keep the old buffer alive until the frames that may still read it are done
+		MockVulkanBuffer previous = *buffer;
+		if (!self.CreateBufferMemory(*buffer))
+		{
+			*buffer = previous;
+			return false;
+		}
+		self.m_DeleteQueue[self.m_FrameNumber].push_back(previous);
+		++buffer->recreateCount;
+	}
+	else if (accessMode == kUnityVulkanResourceAccess_PipelineBarrier && !(pipelineStageFlags & VK_PIPELINE_STAGE_HOST_BIT))
+	{
+		// Host writes are made visible by the queue submission itself, anything else needs a barrier
+		if (!self.m_InsideFrame || self.m_InsideRenderPass)
+			return false;
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+		barrier.dstAccessMask = accessFlags;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer->buffer;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(self.m_Frames[self.m_FrameNumber % kFramesInFlight].commandBuffer,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, pipelineStageFlags, 0, 0, NULL, 1, &barrier, 0, NULL);
+	}
+
+	memset(outBuffer, 0, sizeof(*outBuffer));
+	outBuffer->memory.memory = buffer->memory;
+	outBuffer->memory.size = buffer->memorySize;
+	outBuffer->memory.mapped = buffer->mapped;
+	outBuffer->memory.flags = buffer->memoryFlags;
+	outBuffer->memory.memoryTypeIndex = buffer->memoryTypeIndex;
+	outBuffer->buffer = buffer->buffer;
+	outBuffer->sizeInBytes = buffer->sizeInBytes;
+	outBuffer->usage = buffer->usage;
+	return true;
+}
+
+
+void UNITY_INTERFACE_API MockUnityGraphicsVulkan::EnsureOutsideRenderPass()
+{
+	MockUnityGraphicsVulkan& self = *s_Instance;
+	if (self.m_InsideFrame && self.m_InsideRenderPass)
+	{
+		vkCmdEndRenderPass(self.m_Frames[self.m_FrameNumber % kFramesInFlight].commandBuffer);
+		self.m_InsideRenderPass = false;
+	}
+}
+
+
+void UNITY_INTERFACE_API MockUnityGraphicsVulkan::EnsureInsideRenderPass()
+{
+	MockUnityGraphicsVulkan& self = *s_Instance;
+	if (self.m_InsideFrame && !self.m_InsideRenderPass)
+		self.BeginRenderPass(self.m_LoadRenderPass);
+}
+
+
+void UNITY_INTERFACE_API MockUnityGraphicsVulkan::AccessQueue(UnityRenderingEventAndData callback, int eventId, void* userData, bool /*flush*/)
+{
+	// Called right away; the frame's command buffer is only submitted in EndFrame, so 'flush' is not honored
+	callback(eventId, userData);
+}
+
+
+bool UNITY_INTERFACE_API MockUnityGraphicsVulkan::ConfigureSwapchain(const UnityVulkanSwapchainConfiguration*)
+{
+	return true; // always offscreen
+}
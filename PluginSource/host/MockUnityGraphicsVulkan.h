@@ -0,0 +1,173 @@
+#pragma once
+
+// Stand-in for the IUnityGraphicsVulkan interface on top of a real Vulkan device,
+// meant for a software implementation such as Mesa's lavapipe so that the plugin's
+// Vulkan paths can run on machines without a GPU. The mock owns the instance and
+// device, records one command buffer per frame with an offscreen render pass, and
+// provides the textures and vertex buffers the host hands to the plugin.
+//
+// The Vulkan loader is opened at runtime, like Unity does; select the lavapipe ICD
+// with VK_ICD_FILENAMES if the machine has other drivers installed.
+
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+#include "Unity/IUnityInterface.h"
+#include "Unity/IUnityGraphics.h"
+#include "Unity/IUnityGraphicsVulkan.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+// Native texture handle: like Unity's, it points at the VkImage.
+struct MockVulkanTexture
+{
+	VkImage image;
+	VkDeviceMemory memory;
+	VkDeviceSize memorySize;
+	unsigned int memoryTypeIndex;
+	VkFormat format;
+	int width;
+	int height;
+	VkImageLayout layout;
+	VkPipelineStageFlags stage;		// last access, source of the next barrier
+	VkAccessFlags access;
+};
+
+// Native vertex buffer handle: points at the VkBuffer. Host visible, kept mapped.
+struct MockVulkanBuffer
+{
+	VkBuffer buffer;
+	VkDeviceMemory memory;
+	VkDeviceSize memorySize;
+	unsigned int memoryTypeIndex;
+	VkMemoryPropertyFlags memoryFlags;
+	void* mapped;
+	size_t sizeInBytes;
+	VkBufferUsageFlags usage;
+	unsigned int recreateCount;
+};
+
+
+class MockUnityGraphicsVulkan
+{
+public:
+	MockUnityGraphicsVulkan();
+	~MockUnityGraphicsVulkan();
+
+	IUnityGraphicsVulkan* GetInterface() { return &m_Interface; }
+	IUnityGraphicsVulkanV2* GetInterfaceV2() { return &m_InterfaceV2; }
+
+	// Loads the Vulkan loader and creates instance and device, running the initialization
+	// callbacks that plugins registered with InterceptInitialization. CPU devices (lavapipe)
+	// are preferred over any others. Prints the reason and returns false on failure.
+	bool Initialize();
+	void Shutdown();
+	const char* GetDeviceName() const { return m_DeviceName.c_str(); }
+
+	// 'format' is one of the 8 bit UNORM formats with 1, 2 or 4 channels
+	MockVulkanTexture* CreateTexture(int width, int height, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM);
+	MockVulkanBuffer* CreateVertexBuffer(size_t sizeInBytes);
+
+	// Frame recording. The frame starts inside the offscreen render pass, like
+	// the rendering of a camera would; BeforeEvent applies what the plugin asked
+	// for with ConfigureEvent.
+	void BeginFrame();
+	void BeforeEvent(int eventID);
+	void EndFrame();
+	void WaitIdle();
+	unsigned long long GetCurrentFrameNumber() const { return m_FrameNumber; }
+
+	// Copies the texture contents back to host memory (tightly packed rows).
+	// Must be called outside of a frame; waits for the device.
+	bool ReadTexture(MockVulkanTexture* texture, std::vector<unsigned char>& pixels);
+
+private:
+	struct FrameSlot
+	{
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		unsigned long long frameNumber;
+	};
+
+	struct InitCallback
+	{
+		UnityVulkanInitCallback func;
+		void* userData;
+		int32_t priority;
+	};
+
+	typedef std::map<unsigned long long, std::vector<MockVulkanBuffer> > DeleteQueue;
+
+	bool CreateDevice();
+	bool CreateRenderTarget();
+	bool AllocateMemory(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags flags, VkDeviceMemory* memory, unsigned int* typeIndex);
+	bool CreateBufferMemory(MockVulkanBuffer& buffer);
+	void DestroyBufferMemory(const MockVulkanBuffer& buffer);
+	void BeginRenderPass(VkRenderPass renderPass);
+	void UpdateSafeFrameNumber();
+	void GarbageCollect(bool force);
+	MockVulkanTexture* FindTexture(void* nativeTexture);
+	MockVulkanBuffer* FindBuffer(void* nativeBuffer);
+
+	static bool UNITY_INTERFACE_API InterceptInitialization(UnityVulkanInitCallback func, void* userdata);
+	static bool UNITY_INTERFACE_API AddInterceptInitialization(UnityVulkanInitCallback func, void* userdata, int32_t priority);
+	static bool UNITY_INTERFACE_API RemoveInterceptInitialization(UnityVulkanInitCallback func);
+	static PFN_vkVoidFunction UNITY_INTERFACE_API InterceptVulkanAPI(const char* name, PFN_vkVoidFunction func);
+	static void UNITY_INTERFACE_API ConfigureEvent(int eventID, const UnityVulkanPluginEventConfig* pluginEventConfig);
+	static UnityVulkanInstance UNITY_INTERFACE_API Instance();
+	static bool UNITY_INTERFACE_API CommandRecordingState(UnityVulkanRecordingState* outCommandRecordingState, UnityVulkanGraphicsQueueAccess queueAccess);
+	static bool UNITY_INTERFACE_API AccessTexture(void* nativeTexture, const VkImageSubresource* subResource, VkImageLayout layout,
+		VkPipelineStageFlags pipelineStageFlags, VkAccessFlags accessFlags, UnityVulkanResourceAccessMode accessMode, UnityVulkanImage* outImage);
+	static bool UNITY_INTERFACE_API AccessRenderBufferTexture(UnityRenderBuffer nativeRenderBuffer, const VkImageSubresource* subResource, VkImageLayout layout,
+		VkPipelineStageFlags pipelineStageFlags, VkAccessFlags accessFlags, UnityVulkanResourceAccessMode accessMode, UnityVulkanImage* outImage);
+	static bool UNITY_INTERFACE_API AccessTextureByID(UnityTextureID textureID, const VkImageSubresource* subResource, VkImageLayout layout,
+		VkPipelineStageFlags pipelineStageFlags, VkAccessFlags accessFlags, UnityVulkanResourceAccessMode accessMode, UnityVulkanImage* outImage);
+	static bool UNITY_INTERFACE_API AccessBuffer(void* nativeBuffer, VkPipelineStageFlags pipelineStageFlags, VkAccessFlags accessFlags,
+		UnityVulkanResourceAccessMode accessMode, UnityVulkanBuffer* outBuffer);
+	static void UNITY_INTERFACE_API EnsureOutsideRenderPass();
+	static void UNITY_INTERFACE_API EnsureInsideRenderPass();
+	static void UNITY_INTERFACE_API AccessQueue(UnityRenderingEventAndData callback, int eventId, void* userData, bool flush);
+	static bool UNITY_INTERFACE_API ConfigureSwapchain(const UnityVulkanSwapchainConfiguration* swapChainConfig);
+
+private:
+	// Same as MockUnityInterfaces: the interface is a function table without a context pointer.
+	static MockUnityGraphicsVulkan* s_Instance;
+
+	enum { kFramesInFlight = 2 };
+
+	IUnityGraphicsVulkan m_Interface;
+	IUnityGraphicsVulkanV2 m_InterfaceV2;
+
+	void* m_LoaderLibrary;
+	PFN_vkGetInstanceProcAddr m_LoaderGetInstanceProcAddr;
+	std::vector<InitCallback> m_InitCallbacks;
+	std::map<std::string, PFN_vkVoidFunction> m_InterceptedFunctions;
+	std::map<int, UnityVulkanPluginEventConfig> m_EventConfigs;
+
+	UnityVulkanInstance m_Instance;
+	std::string m_DeviceName;
+	VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+	VkCommandPool m_CommandPool;
+	FrameSlot m_Frames[kFramesInFlight];
+
+	// Offscreen color target the frame's render pass draws into. The "load" pass
+	// is compatible with the "clear" one and resumes it after EnsureOutsideRenderPass.
+	VkImage m_ColorImage;
+	VkDeviceMemory m_ColorMemory;
+	VkImageView m_ColorView;
+	VkRenderPass m_ClearRenderPass;
+	VkRenderPass m_LoadRenderPass;
+	VkFramebuffer m_Framebuffer;
+
+	unsigned long long m_FrameNumber;		// frame being recorded, starts at 1
+	unsigned long long m_SafeFrameNumber;	// newest frame the GPU is known to have finished
+	bool m_InsideFrame;
+	bool m_InsideRenderPass;
+
+	std::vector<MockVulkanTexture*> m_Textures;
+	std::vector<MockVulkanBuffer*> m_Buffers;
+	DeleteQueue m_DeleteQueue;				// buffers replaced by kUnityVulkanResourceAccess_Recreate
+};
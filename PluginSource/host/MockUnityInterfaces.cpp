@@ -0,0 +1,103 @@
+#include "MockUnityInterfaces.h"
+
+#include <algorithm>
+#include <assert.h>
+
+
+MockUnityInterfaces* MockUnityInterfaces::s_Instance = NULL;
+
+
+MockUnityInterfaces::MockUnityInterfaces(UnityGfxRenderer renderer)
+	: m_Renderer(renderer)
+	, m_NextEventID(1000)
+{
+	assert(s_Instance == NULL);
+	s_Instance = this;
+
+	m_Interfaces.GetInterface = GetInterface;
+	m_Interfaces.RegisterInterface = RegisterInterfaceImpl;
+	m_Interfaces.GetInterfaceSplit = GetInterfaceSplit;
+	m_Interfaces.RegisterInterfaceSplit = RegisterInterfaceSplit;
+
+	m_Graphics.GetRenderer = GetRenderer;
+	m_Graphics.RegisterDeviceEventCallback = RegisterDeviceEventCallback;
+	m_Graphics.UnregisterDeviceEventCallback = UnregisterDeviceEventCallback;
+	m_Graphics.ReserveEventIDRange = ReserveEventIDRange;
+
+	RegisterInterface(UNITY_GET_INTERFACE_GUID(IUnityGraphics), &m_Graphics);
+}
+
+
+MockUnityInterfaces::~MockUnityInterfaces()
+{
+	s_Instance = NULL;
+}
+
+
+void MockUnityInterfaces::RegisterInterface(const UnityInterfaceGUID& guid, IUnityInterface* ptr)
+{
+	m_Registry[guid] = ptr;
+}
+
+
+void MockUnityInterfaces::SendDeviceEvent(UnityGfxDeviceEventType eventType)
+{
+	// Copy, callbacks are allowed to unregister themselves
+	std::vector<IUnityGraphicsDeviceEventCallback> callbacks = m_DeviceEventCallbacks;
+	for (size_t i = 0; i < callbacks.size(); ++i)
+		callbacks[i](eventType);
+}
+
+
+IUnityInterface* UNITY_INTERFACE_API MockUnityInterfaces::GetInterface(UnityInterfaceGUID guid)
+{
+	std::map<UnityInterfaceGUID, IUnityInterface*>::const_iterator it = s_Instance->m_Registry.find(guid);
+	return it != s_Instance->m_Registry.end() ? it->second : NULL;
+}
+
+
+void UNITY_INTERFACE_API MockUnityInterfaces::RegisterInterfaceImpl(UnityInterfaceGUID guid, IUnityInterface* ptr)
+{
+	s_Instance->RegisterInterface(guid, ptr);
+}
+
+
+IUnityInterface* UNITY_INTERFACE_API MockUnityInterfaces::GetInterfaceSplit(unsigned long long guidHigh, unsigned long long guidLow)
+{
+	return GetInterface(UnityInterfaceGUID(guidHigh, guidLow));
+}
+
+
+void UNITY_INTERFACE_API MockUnityInterfaces::RegisterInterfaceSplit(unsigned long long guidHigh, unsigned long long guidLow, IUnityInterface* ptr)
+{
+	s_Instance->RegisterInterface(UnityInterfaceGUID(guidHigh, guidLow), ptr);
+}
+
+
+UnityGfxRenderer UNITY_INTERFACE_API MockUnityInterfaces::GetRenderer()
+{
+	return s_Instance->m_Renderer;
+}
+
+
+void UNITY_INTERFACE_API MockUnityInterfaces::RegisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback)
+{
+	std::vector<IUnityGraphicsDeviceEventCallback>& callbacks = s_Instance->m_DeviceEventCallbacks;
+	if (std::find(callbacks.begin(), callbacks.end(), callback) == callbacks.end())
+		callbacks.push_back(callback);
+}
+
+
+void UNITY_INTERFACE_API MockUnityInterfaces::UnregisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback)
+{
+	std::vector<IUnityGraphicsDeviceEventCallback>& callbacks = s_Instance->m_DeviceEventCallbacks;
+	callbacks.erase(std::remove(callbacks.begin(), callbacks.end(), callback), callbacks.end());
+}
+
+
+int UNITY_INTERFACE_API MockUnityInterfaces::ReserveEventIDRange(int count)
+{
+	int first = s_Instance->m_NextEventID;
+	s_Instance->m_NextEventID += count;
+	return first;
+}
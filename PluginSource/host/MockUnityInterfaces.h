@@ -0,0 +1,55 @@
+#pragma once
+
+// Minimal stand-ins for the interfaces Unity hands to a native plugin on load.
+// Used by the host tools to drive RenderingPlugin outside of the engine: the
+// host picks which renderer type IUnityGraphics reports, and fires the device
+// events Unity would normally send.
+
+#include "Unity/IUnityInterface.h"
+#include "Unity/IUnityGraphics.h"
+
+#include <map>
+#include <vector>
+
+
+class MockUnityInterfaces
+{
+public:
+	explicit MockUnityInterfaces(UnityGfxRenderer renderer);
+	~MockUnityInterfaces();
+
+	IUnityInterfaces* GetInterfaces() { return &m_Interfaces; }
+
+	// Registers an additional interface (e.g. a backend specific one) that Get<> will hand out.
+	void RegisterInterface(const UnityInterfaceGUID& guid, IUnityInterface* ptr);
+
+	// Changes the renderer IUnityGraphics reports. Unity reports the null renderer while
+	// plugins are loaded, before the actual device is created.
+	void SetRenderer(UnityGfxRenderer renderer) { m_Renderer = renderer; }
+
+	// Sends a device event to every callback the plugin has registered.
+	void SendDeviceEvent(UnityGfxDeviceEventType eventType);
+
+private:
+	static IUnityInterface* UNITY_INTERFACE_API GetInterface(UnityInterfaceGUID guid);
+	static void UNITY_INTERFACE_API RegisterInterfaceImpl(UnityInterfaceGUID guid, IUnityInterface* ptr);
+	static IUnityInterface* UNITY_INTERFACE_API GetInterfaceSplit(unsigned long long guidHigh, unsigned long long guidLow);
+	static void UNITY_INTERFACE_API RegisterInterfaceSplit(unsigned long long guidHigh, unsigned long long guidLow, IUnityInterface* ptr);
+
+	static UnityGfxRenderer UNITY_INTERFACE_API GetRenderer();
+	static void UNITY_INTERFACE_API RegisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback);
+	static void UNITY_INTERFACE_API UnregisterDeviceEventCallback(IUnityGraphicsDeviceEventCallback callback);
+	static int UNITY_INTERFACE_API ReserveEventIDRange(int count);
+
+private:
+	// Unity interfaces are plain function tables without a context pointer,
+	// so there can only be one mock alive at a time.
+	static MockUnityInterfaces* s_Instance;
+
+	IUnityInterfaces m_Interfaces;
+	IUnityGraphics m_Graphics;
+	UnityGfxRenderer m_Renderer;
+	int m_NextEventID;
+	std::map<UnityInterfaceGUID, IUnityInterface*> m_Registry;
+	std::vector<IUnityGraphicsDeviceEventCallback> m_DeviceEventCallbacks;
+};
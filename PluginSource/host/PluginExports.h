@@ -0,0 +1,42 @@
+#pragma once
+
+// Declarations of the functions RenderingPlugin exports to C# scripts, so that
+// host tools can call them directly after linking the plugin sources in.
+
+#include "Unity/IUnityInterface.h"
+#include "Unity/IUnityGraphics.h"
+#include "PluginMemory.h"
+#include "PluginStats.h"
+
+extern "C"
+{
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTimeFromUnity(float t);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureFromUnity(void* textureHandle, int w, int h);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureFromUnityWithFormat(void* textureHandle, int w, int h, int format);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureDirtyRectsFromUnity(const int* rects, int rectCount);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AddTextureFromUnity(void* textureHandle, int w, int h, int format);
+	UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UpdateTextureFromUnity(int id, void* textureHandle, int w, int h, int format);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RemoveTextureFromUnity(int id);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureTileUpdateFromUnity(int tileSize, int maxBytesPerFrame, float maxMillisecondsPerFrame);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetMeshBuffersFromUnity(void* vertexBufferHandle, int vertexCount, float* sourceVertices, float* sourceNormals, float* sourceUV);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetMeshVertexArrayFromUnity(void* vertexBufferHandle, int vertexCount, void* sourceVertices);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AddMeshFromUnity(void* vertexBufferHandle, int vertexCount, float* sourceVertices, float* sourceNormals, float* sourceUV);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API AddMeshVertexArrayFromUnity(void* vertexBufferHandle, int vertexCount, void* sourceVertices);
+	UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API SetMeshDeformationFromUnity(int id, float speed, float timeOffset);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RemoveMeshFromUnity(int id);
+	UnityRenderingEvent UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetRenderEventFunc();
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateTextures(const char* image1, const char* image2);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPluginFrameStats(PluginStageStats* outStats, int maxStages);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPluginStageCount();
+	UNITY_INTERFACE_EXPORT const char* UNITY_INTERFACE_API GetPluginStageName(int stage);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPluginMemoryStats(PluginMemoryStats* outStats, int maxCategories);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPluginMemoryCategoryCount();
+	UNITY_INTERFACE_EXPORT const char* UNITY_INTERFACE_API GetPluginMemoryCategoryName(int category);
+	UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API StartPluginTrace(const char* path);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API StopPluginTrace();
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetPluginWorkerThreadCount(int count);
+	int UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API GetPluginWorkerThreadCount();
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetPluginVertexParallelThreshold(int vertexCount);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetPluginPipelinedGeneration(int enabled);
+	void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetPluginMathPrecision(int precision);
+}
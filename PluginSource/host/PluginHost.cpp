@@ -0,0 +1,145 @@
+// Headless host for RenderingPlugin: loads the plugin against mock Unity
+// interfaces reporting the "null" graphics device, hands it a texture and a
+// mesh like UseRenderingPlugin.cs does, and pumps the render event for a
+// number of frames while timing every stage. With the null RenderAPI
+// (RenderAPI_Null.cpp) all of the plugin's CPU work runs against host memory.
+
+#include "HostCommon.h"
+#include "MockUnityInterfaces.h"
+#include "PluginExports.h"
+#include "RenderAPI.h"
+#include "RenderAPI_Null.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+struct NullResources
+{
+	NullTexture texture;
+	NullBuffer vertexBuffer;
+	std::vector<NullTexture> extraTextures;		// registered with AddTextureFromUnity
+	std::vector<NullBuffer> extraVertexBuffers;	// registered with AddMeshFromUnity
+	bool printChecksums;
+};
+
+
+static void PrintChecksums(int frame, void* userData)
+{
+	const NullResources& resources = *(const NullResources*)userData;
+	if (!resources.printChecksums)
+		return;
+
+	printf("frame %5d: texture checksum %08x (%u updates), vertex buffer checksum %08x (%u updates)", frame,
+		resources.texture.checksum, resources.texture.updateCount, resources.vertexBuffer.checksum, resources.vertexBuffer.updateCount);
+	if (!resources.extraTextures.empty())
+	{
+		// One checksum over the pixels of all of them
+		unsigned int checksum = kNullChecksumSeed;
+		unsigned int updateCount = 0;
+		for (size_t i = 0; i < resources.extraTextures.size(); ++i)
+		{
+			checksum = NullChecksum(resources.extraTextures[i].pixels.data(), resources.extraTextures[i].pixels.size(), checksum);
+			updateCount += resources.extraTextures[i].updateCount;
+		}
+		printf(", %d more textures checksum %08x (%u updates)", int(resources.extraTextures.size()), checksum, updateCount);
+	}
+	if (!resources.extraVertexBuffers.empty())
+	{
+		unsigned int checksum = kNullChecksumSeed;
+		unsigned int updateCount = 0;
+		for (size_t i = 0; i < resources.extraVertexBuffers.size(); ++i)
+		{
+			checksum = NullChecksum(resources.extraVertexBuffers[i].data.data(), resources.extraVertexBuffers[i].data.size(), checksum);
+			updateCount += resources.extraVertexBuffers[i].updateCount;
+		}
+		printf(", %d more meshes checksum %08x (%u updates)", int(resources.extraVertexBuffers.size()), checksum, updateCount);
+	}
+	printf("\n");
+}
+
+
+static void PrintUsage(const char* exe)
+{
+	printf("usage: %s [options]\n", exe);
+	PrintHostOptionsUsage();
+	printf("  --checksum        print checksums of the texture and vertex buffer contents after every frame\n");
+}
+
+
+int main(int argc, char** argv)
+{
+	HostOptions options;
+	InitHostOptions(options);
+	NullResources resources;
+	resources.printChecksums = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		bool error = false;
+		if (strcmp(argv[i], "--checksum") == 0)
+			resources.printChecksums = true;
+		else if (!ParseHostOption(argc, argv, i, options, error) || error)
+		{
+			if (strcmp(argv[i], "--help") != 0)
+				fprintf(stderr, "invalid argument: %s\n", argv[i]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	MockUnityInterfaces unity(kUnityGfxRendererNull);
+	if (!StartHostTrace(options))
+		return 1;
+	UnityPluginLoad(unity.GetInterfaces());
+
+	// The null device's "native" resources are host memory, see RenderAPI_Null.h
+	if (options.textureWidth > 0 && options.textureHeight > 0)
+	{
+		resources.texture.width = options.textureWidth;
+		resources.texture.height = options.textureHeight;
+		resources.texture.bytesPerPixel = GetPluginTextureFormatBytesPerPixel(PluginTextureFormat(options.textureFormat));
+		resources.texture.pixels.resize(size_t(options.textureWidth) * options.textureHeight * resources.texture.bytesPerPixel);
+		resources.texture.computeChecksum = resources.printChecksums;
+		SetTextureFromUnityWithFormat(&resources.texture, options.textureWidth, options.textureHeight, options.textureFormat);
+	}
+
+	resources.extraTextures.resize(options.extraTextureCount);
+	for (size_t i = 0; i < resources.extraTextures.size(); ++i)
+	{
+		NullTexture& texture = resources.extraTextures[i];
+		texture.width = texture.height = options.extraTextureSize;
+		texture.bytesPerPixel = GetPluginTextureFormatBytesPerPixel(PluginTextureFormat(options.textureFormat));
+		texture.pixels.resize(size_t(texture.width) * texture.height * texture.bytesPerPixel);
+		texture.computeChecksum = resources.printChecksums;
+		AddTextureFromUnity(&texture, texture.width, texture.height, options.textureFormat);
+	}
+
+	HostMesh mesh;
+	if (options.vertexCount > 0)
+	{
+		CreateGridMesh(options.vertexCount, mesh);
+		resources.vertexBuffer.data.resize(size_t(mesh.vertexCount) * kMeshVertexSize);
+		resources.vertexBuffer.computeChecksum = resources.printChecksums;
+		SendHostMeshToPlugin(&resources.vertexBuffer, mesh, options);
+	}
+
+	HostMesh extraMesh;
+	if (options.extraMeshCount > 0)
+		CreateGridMesh(options.extraMeshVertexCount, extraMesh);
+	resources.extraVertexBuffers.resize(options.extraMeshCount);
+	for (size_t i = 0; i < resources.extraVertexBuffers.size(); ++i)
+	{
+		resources.extraVertexBuffers[i].data.resize(size_t(extraMesh.vertexCount) * kMeshVertexSize);
+		AddHostMeshToPlugin(&resources.extraVertexBuffers[i], extraMesh, int(i), options);
+	}
+
+	RunPluginFrames(options, PrintChecksums, &resources);
+	PrintPluginFrameStats();
+	PrintPluginMemoryStats("after the last frame");
+
+	unity.SendDeviceEvent(kUnityGfxDeviceEventShutdown);
+	PrintPluginMemoryStats("after device shutdown");
+	UnityPluginUnload();
+	StopHostTrace(options);
+	return 0;
+}
@@ -0,0 +1,193 @@
+// Headless Vulkan host for RenderingPlugin: like PluginHost, but the plugin runs its
+// real Vulkan backend (RenderAPI_Vulkan.cpp) on top of MockUnityGraphicsVulkan, which
+// creates a device through the system's Vulkan loader. With Mesa's lavapipe driver
+// this needs no GPU, so the upload, draw and garbage collection paths can be timed and
+// checked on any Linux machine:
+//
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json ./VulkanHost --checksum
+//
+// The checksums printed with --checksum match the ones of PluginHost for the same options.
+
+#include "HostCommon.h"
+#include "MockUnityGraphicsVulkan.h"
+#include "MockUnityInterfaces.h"
+#include "PluginExports.h"
+#include "RenderAPI.h"
+#include "RenderAPI_Null.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+struct VulkanFrameState
+{
+	MockUnityGraphicsVulkan* vulkan;
+	MockVulkanTexture* texture;
+	MockVulkanBuffer* vertexBuffer;
+	std::vector<MockVulkanTexture*> extraTextures;		// registered with AddTextureFromUnity
+	std::vector<MockVulkanBuffer*> extraVertexBuffers;	// registered with AddMeshFromUnity
+	bool printChecksums;
+};
+
+
+static void BeginFrame(int, void* userData)
+{
+	((VulkanFrameState*)userData)->vulkan->BeginFrame();
+}
+
+
+static void BeforeEvent(int eventID, void* userData)
+{
+	((VulkanFrameState*)userData)->vulkan->BeforeEvent(eventID);
+}
+
+
+static void EndFrame(int, void* userData)
+{
+	((VulkanFrameState*)userData)->vulkan->EndFrame();
+}
+
+
+static void PrintChecksums(int frame, void* userData)
+{
+	VulkanFrameState& state = *(VulkanFrameState*)userData;
+	if (!state.printChecksums)
+		return;
+
+	// Waits for the GPU, which serializes the frames; don't combine with timing runs
+	state.vulkan->WaitIdle();
+
+	unsigned int textureChecksum = 0;
+	std::vector<unsigned char> pixels;
+	if (state.texture && state.vulkan->ReadTexture(state.texture, pixels))
+		textureChecksum = NullChecksum(pixels.data(), pixels.size());
+	unsigned int vertexChecksum = 0;
+	if (state.vertexBuffer)
+		vertexChecksum = NullChecksum(state.vertexBuffer->mapped, state.vertexBuffer->sizeInBytes);
+
+	printf("frame %5d: texture checksum %08x, vertex buffer checksum %08x (%u recreated)", frame,
+		textureChecksum, vertexChecksum, state.vertexBuffer ? state.vertexBuffer->recreateCount : 0);
+	if (!state.extraTextures.empty())
+	{
+		unsigned int checksum = kNullChecksumSeed;
+		for (size_t i = 0; i < state.extraTextures.size(); ++i)
+		{
+			if (state.vulkan->ReadTexture(state.extraTextures[i], pixels))
+				checksum = NullChecksum(pixels.data(), pixels.size(), checksum);
+		}
+		printf(", %d more textures checksum %08x", int(state.extraTextures.size()), checksum);
+	}
+	if (!state.extraVertexBuffers.empty())
+	{
+		unsigned int checksum = kNullChecksumSeed;
+		for (size_t i = 0; i < state.extraVertexBuffers.size(); ++i)
+			checksum = NullChecksum(state.extraVertexBuffers[i]->mapped, state.extraVertexBuffers[i]->sizeInBytes, checksum);
+		printf(", %d more meshes checksum %08x", int(state.extraVertexBuffers.size()), checksum);
+	}
+	printf("\n");
+}
+
+
+static void PrintUsage(const char* exe)
+{
+	printf("usage: %s [options]\n", exe);
+	PrintHostOptionsUsage();
+	printf("  --checksum        read back the texture and vertex buffer after every frame and print their checksums\n");
+}
+
+
+int main(int argc, char** argv)
+{
+	HostOptions options;
+	InitHostOptions(options);
+	VulkanFrameState state = {};
+	for (int i = 1; i < argc; ++i)
+	{
+		bool error = false;
+		if (strcmp(argv[i], "--checksum") == 0)
+			state.printChecksums = true;
+		else if (!ParseHostOption(argc, argv, i, options, error) || error)
+		{
+			if (strcmp(argv[i], "--help") != 0)
+				fprintf(stderr, "invalid argument: %s\n", argv[i]);
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// Unity loads plugins while reporting the null renderer, so that they can hook
+	// Vulkan initialization, and only then creates the device
+	MockUnityInterfaces unity(kUnityGfxRendererNull);
+	MockUnityGraphicsVulkan vulkan;
+	unity.RegisterInterface(UNITY_GET_INTERFACE_GUID(IUnityGraphicsVulkan), vulkan.GetInterface());
+	unity.RegisterInterface(UNITY_GET_INTERFACE_GUID(IUnityGraphicsVulkanV2), vulkan.GetInterfaceV2());
+	if (!StartHostTrace(options))
+		return 1;
+	UnityPluginLoad(unity.GetInterfaces());
+
+	if (!vulkan.Initialize())
+		return 1;
+	printf("Vulkan device: %s\n", vulkan.GetDeviceName());
+	state.vulkan = &vulkan;
+
+	unity.SetRenderer(kUnityGfxRendererVulkan);
+	unity.SendDeviceEvent(kUnityGfxDeviceEventInitialize);
+
+	// UseRenderingPlugin.cs does this on start; it sets up the descriptor set the triangle draw binds
+	CreateTextures("", "");
+
+	static const VkFormat kFormats[kPluginTextureFormatCount] = { VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8_UNORM, VK_FORMAT_R8G8_UNORM };
+	if (options.textureWidth > 0 && options.textureHeight > 0)
+	{
+		state.texture = vulkan.CreateTexture(options.textureWidth, options.textureHeight, kFormats[options.textureFormat]);
+		if (state.texture)
+			SetTextureFromUnityWithFormat(state.texture, options.textureWidth, options.textureHeight, options.textureFormat);
+	}
+	for (int i = 0; i < options.extraTextureCount; ++i)
+	{
+		MockVulkanTexture* texture = vulkan.CreateTexture(options.extraTextureSize, options.extraTextureSize, kFormats[options.textureFormat]);
+		if (!texture)
+			break;
+		state.extraTextures.push_back(texture);
+		AddTextureFromUnity(texture, options.extraTextureSize, options.extraTextureSize, options.textureFormat);
+	}
+
+	HostMesh mesh;
+	if (options.vertexCount > 0)
+	{
+		CreateGridMesh(options.vertexCount, mesh);
+		state.vertexBuffer = vulkan.CreateVertexBuffer(size_t(mesh.vertexCount) * kMeshVertexSize);
+		if (state.vertexBuffer)
+			SendHostMeshToPlugin(state.vertexBuffer, mesh, options);
+	}
+
+	HostMesh extraMesh;
+	if (options.extraMeshCount > 0)
+		CreateGridMesh(options.extraMeshVertexCount, extraMesh);
+	for (int i = 0; i < options.extraMeshCount; ++i)
+	{
+		MockVulkanBuffer* buffer = vulkan.CreateVertexBuffer(size_t(extraMesh.vertexCount) * kMeshVertexSize);
+		if (!buffer)
+			break;
+		state.extraVertexBuffers.push_back(buffer);
+		AddHostMeshToPlugin(buffer, extraMesh, i, options);
+	}
+
+	HostFrameHooks hooks = {};
+	hooks.beginFrame = BeginFrame;
+	hooks.beforeEvent = BeforeEvent;
+	hooks.endFrame = EndFrame;
+	hooks.afterFrame = PrintChecksums;
+	hooks.userData = &state;
+	RunPluginFrames(options, hooks);
+	PrintPluginFrameStats();
+	PrintPluginMemoryStats("after the last frame");
+
+	vulkan.WaitIdle();
+	unity.SendDeviceEvent(kUnityGfxDeviceEventShutdown);
+	PrintPluginMemoryStats("after device shutdown");
+	UnityPluginUnload();
+	StopHostTrace(options);
+	vulkan.Shutdown();
+	return 0;
+}
@@ -9,6 +9,16 @@ LOCAL_ARM_MODE := arm
 
 LOCAL_SRC_FILES += $(SRC_DIR)/RenderAPI.cpp
 LOCAL_SRC_FILES += $(SRC_DIR)/RenderingPlugin.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginMeshes.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginTextures.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginPipeline.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginTiles.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginWorkers.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginKernels_SIMD.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginMemory.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginTrace.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginStats.cpp
+LOCAL_SRC_FILES += $(SRC_DIR)/PluginKernels.cpp
 
 # OpenGL ES
 LOCAL_SRC_FILES += $(SRC_DIR)/RenderAPI_OpenGLCoreES.cpp
@@ -60,8 +60,12 @@
 		#define SUPPORT_VULKAN 0
 	#endif
 #elif UNITY_OSX || UNITY_LINUX
-	#define SUPPORT_OPENGL_UNIFIED 1
-	#define SUPPORT_OPENGL_CORE 1
+	#ifndef SUPPORT_OPENGL_UNIFIED
+		#define SUPPORT_OPENGL_UNIFIED 1
+	#endif
+	#ifndef SUPPORT_OPENGL_CORE
+		#define SUPPORT_OPENGL_CORE SUPPORT_OPENGL_UNIFIED
+	#endif
 #elif UNITY_EMBEDDED_LINUX
 	#define SUPPORT_OPENGL_UNIFIED 1
 	#define SUPPORT_OPENGL_ES 1
@@ -77,6 +81,22 @@
 	#define SUPPORT_METAL 1
 #endif
 
+// CPU-only implementation for the "null" device (see RenderAPI_Null.cpp), used by the host tools.
+// Off by default: Unity also reports the null device when loading plugins ahead of Vulkan initialization.
+#ifndef SUPPORT_NULL
+	#define SUPPORT_NULL 0
+#endif
+
+// Per-stage timers of the render event (PluginStats.h), reported through GetPluginFrameStats.
+#ifndef PLUGIN_FRAME_STATS
+	#define PLUGIN_FRAME_STATS 1
+#endif
+
+// Chrome trace recording (PluginTrace.h), started at runtime with StartPluginTrace.
+#ifndef PLUGIN_TRACE
+	#define PLUGIN_TRACE 1
+#endif
+
 
 
 // COM-like Release macro
@@ -0,0 +1,1139 @@
+#include "PluginKernels.h"
+#include "PluginMemory.h"
+#include "PluginStats.h"
+#include "PluginTrace.h"
+#include "PluginWorkers.h"
+#include "RenderAPI.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include <vector>
+
+
+template<PluginMathPrecision Precision>
+static void FillPlasmaRows_Scalar(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	const float t = time * 4.0f;
+	const int bytesPerPixel = target.bytesPerPixel;
+
+	unsigned char* dst = target.pixels + size_t(rowBegin) * target.rowPitch;
+	for (int y = target.y + rowBegin; y < target.y + rowEnd; ++y)
+	{
+		const float rowTerm = 127.0f + (127.0f * PluginSin<Precision>(y / 5.0f - t));
+		unsigned char* ptr = dst;
+		for (int x = target.x; x < target.x + target.width; ++x)
+		{
+			const unsigned char vv = PlasmaPixelValue<Precision>(x, y, t, rowTerm);
+
+			// Write the texture pixel, all of its channels
+			for (int c = 0; c < bytesPerPixel; ++c)
+				ptr[c] = vv;
+
+			// To next pixel
+			ptr += bytesPerPixel;
+		}
+
+		// To next image row
+		dst += target.rowPitch;
+	}
+}
+
+void FillPlasmaPixels_Scalar(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	if (target.mathPrecision == kPluginMathPrecision_Fast)
+		FillPlasmaRows_Scalar<kPluginMathPrecision_Fast>(target, time, rowBegin, rowEnd);
+	else
+		FillPlasmaRows_Scalar<kPluginMathPrecision_Exact>(target, time, rowBegin, rowEnd);
+}
+
+
+// sin(d) and cos(d) of the radial term's phase d = sqrt(x*x + y*y) / 4, width x height each.
+// Only depends on the texture size, so it's kept across frames for the last few sizes used,
+// up to kPlasmaRadialFieldBudget bytes in all; counted as kPluginMemory_KernelTables.
+struct PlasmaRadialField
+{
+	int width, height;
+	std::vector<float> sinPhase;
+	std::vector<float> cosPhase;
+
+	PlasmaRadialField(int w, int h)
+		: width(w), height(h), sinPhase(size_t(w) * h), cosPhase(size_t(w) * h)
+	{
+		PluginMemory_Allocate(kPluginMemory_KernelTables, GetPlasmaRadialFieldBytes(w, h));
+	}
+	~PlasmaRadialField()
+	{
+		PluginMemory_Free(kPluginMemory_KernelTables, GetPlasmaRadialFieldBytes(width, height));
+	}
+};
+
+typedef std::shared_ptr<const PlasmaRadialField> PlasmaRadialFieldPtr;
+
+struct CachedPlasmaRadialField
+{
+	PlasmaRadialFieldPtr field;
+	unsigned int lastReserved;		// s_PlasmaRadialFieldReserves when a fill last reserved it
+};
+
+static std::vector<CachedPlasmaRadialField> s_PlasmaRadialFields;	// most recently used first
+static size_t s_PlasmaRadialFieldBytes = 0;							// of the fields in s_PlasmaRadialFields
+static unsigned int s_PlasmaRadialFieldReserves = 0;
+
+// Fields that no fill reserved for this many fills are no longer drawn with and may make room
+// for another size; those that were are kept, so two sizes in use never evict each other
+static const unsigned int kPlasmaRadialFieldStaleReserves = 64;
+
+
+// Row bands of one fill run on several threads (see FillPlasmaPixels), the first to get
+// here builds the field. Fills hold a reference to theirs, so neither the eviction of a
+// size another thread (the pipeline's or the render thread) is filling with nor
+// ReleasePlasmaTables on device shutdown frees a field that is still read.
+static std::mutex s_PlasmaRadialFieldsMutex;
+
+static PlasmaRadialFieldPtr FindPlasmaRadialFieldLocked(int width, int height)
+{
+	for (size_t i = 0; i < s_PlasmaRadialFields.size(); ++i)
+	{
+		CachedPlasmaRadialField cached = s_PlasmaRadialFields[i];
+		if (cached.field->width != width || cached.field->height != height)
+			continue;
+		s_PlasmaRadialFields.erase(s_PlasmaRadialFields.begin() + i);
+		s_PlasmaRadialFields.insert(s_PlasmaRadialFields.begin(), cached);
+		return cached.field;
+	}
+	return PlasmaRadialFieldPtr();
+}
+
+static void EvictPlasmaRadialFieldLocked()
+{
+	const PlasmaRadialField& field = *s_PlasmaRadialFields.back().field;
+	s_PlasmaRadialFieldBytes -= GetPlasmaRadialFieldBytes(field.width, field.height);
+	s_PlasmaRadialFields.pop_back();
+}
+
+static PlasmaRadialFieldPtr BuildPlasmaRadialFieldLocked(int width, int height)
+{
+	PLUGIN_TRACE_SCOPE("BuildPlasmaRadialField");
+	std::shared_ptr<PlasmaRadialField> field = std::make_shared<PlasmaRadialField>(width, height);
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const float d = sqrtf(float(x*x + y*y)) / 4.0f;
+			field->sinPhase[size_t(y) * width + x] = sinf(d);
+			field->cosPhase[size_t(y) * width + x] = cosf(d);
+		}
+	}
+	CachedPlasmaRadialField cached = { field, s_PlasmaRadialFieldReserves };
+	s_PlasmaRadialFields.insert(s_PlasmaRadialFields.begin(), cached);
+	s_PlasmaRadialFieldBytes += GetPlasmaRadialFieldBytes(width, height);
+	return field;
+}
+
+// What the table kernel reads from. Makes room least recently used first, whatever the fields
+// are used for; a field over the budget on its own is still kept, alone. Only the table kernel
+// set explicitly gets here without ReservePlasmaRadialField, see FillPlasmaRect.
+static PlasmaRadialFieldPtr GetPlasmaRadialField(int width, int height)
+{
+	std::lock_guard<std::mutex> lock(s_PlasmaRadialFieldsMutex);
+	PlasmaRadialFieldPtr field = FindPlasmaRadialFieldLocked(width, height);
+	if (field)
+		return field;
+
+	const size_t bytes = GetPlasmaRadialFieldBytes(width, height);
+	while (!s_PlasmaRadialFields.empty() && s_PlasmaRadialFieldBytes + bytes > kPlasmaRadialFieldBudget)
+		EvictPlasmaRadialFieldLocked();
+	return BuildPlasmaRadialFieldLocked(width, height);
+}
+
+// For a fill with the default table kernel: the image's field, built if it fits into the budget
+// next to the fields other fills still reserve, or NULL if it doesn't.
+static PlasmaRadialFieldPtr ReservePlasmaRadialField(int width, int height)
+{
+	std::lock_guard<std::mutex> lock(s_PlasmaRadialFieldsMutex);
+	const unsigned int reserve = ++s_PlasmaRadialFieldReserves;
+	PlasmaRadialFieldPtr field = FindPlasmaRadialFieldLocked(width, height);
+	if (field)
+	{
+		s_PlasmaRadialFields.front().lastReserved = reserve;
+		return field;
+	}
+
+	const size_t bytes = GetPlasmaRadialFieldBytes(width, height);
+	while (!s_PlasmaRadialFields.empty() && s_PlasmaRadialFieldBytes + bytes > kPlasmaRadialFieldBudget &&
+		reserve - s_PlasmaRadialFields.back().lastReserved > kPlasmaRadialFieldStaleReserves)
+		EvictPlasmaRadialFieldLocked();
+	if (s_PlasmaRadialFieldBytes + bytes > kPlasmaRadialFieldBudget)
+		return PlasmaRadialFieldPtr();
+	return BuildPlasmaRadialFieldLocked(width, height);
+}
+
+
+void ReleasePlasmaTables()
+{
+	std::lock_guard<std::mutex> lock(s_PlasmaRadialFieldsMutex);
+	s_PlasmaRadialFields.clear();
+	s_PlasmaRadialFieldBytes = 0;
+}
+
+
+void FillPlasmaPixels_Tables(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	const int width = target.width;
+	const int bytesPerPixel = target.bytesPerPixel;
+	if (width <= 0 || rowBegin >= rowEnd)
+		return;
+	const float t = time * 4.0f;
+
+	const PlasmaRadialFieldPtr radialField = GetPlasmaRadialField(target.imageWidth, target.imageHeight);
+	const PlasmaRadialField& radial = *radialField;
+
+	// The per-frame tables, for the columns of the target and its rows [rowBegin, rowEnd) only:
+	// everything but the radial term, already offset and scaled. diagonalTerms[i] is for
+	// x + y == x0 + y0 + i, with (x0, y0) the first pixel of row rowBegin.
+	const int x0 = target.x, y0 = target.y + rowBegin;
+	const int rowCount = rowEnd - rowBegin;
+	std::vector<float> columnTerms(width), rowTerms(rowCount), diagonalTerms(width + rowCount - 1);
+	for (int i = 0; i < width; ++i)
+		columnTerms[i] = 127.0f + (127.0f * sinf((x0 + i) / 7.0f + t));
+	for (int i = 0; i < rowCount; ++i)
+		rowTerms[i] = 127.0f + (127.0f * sinf((y0 + i) / 5.0f - t));
+	for (int i = 0; i < width + rowCount - 1; ++i)
+		diagonalTerms[i] = 127.0f + (127.0f * sinf((x0 + y0 + i) / 6.0f - t));
+
+#if PLUGIN_KERNELS_X86
+	static const bool useSSE2 = CpuSupportsSSE2();
+#endif
+
+	PlasmaTablesRow row;
+	row.columns = columnTerms.data();
+	row.sinScale = 127.0f * cosf(t);
+	row.cosScale = -127.0f * sinf(t);
+	unsigned char* dst = target.pixels + size_t(rowBegin) * target.rowPitch;
+	for (int i = 0; i < rowCount; ++i)
+	{
+		const size_t fieldOffset = size_t(y0 + i) * target.imageWidth + x0;
+		row.rowTerm = rowTerms[i];
+		row.diagonals = diagonalTerms.data() + i;
+		row.sinPhase = radial.sinPhase.data() + fieldOffset;
+		row.cosPhase = radial.cosPhase.data() + fieldOffset;
+#if PLUGIN_KERNELS_X86
+		if (useSSE2)
+		{
+			WritePlasmaTablesRow_SSE2(dst, width, bytesPerPixel, row, target.streamingStores);
+			dst += target.rowPitch;
+			continue;
+		}
+#endif
+		for (int x = 0; x < width; ++x)
+			StorePlasmaPixel(dst + x * bytesPerPixel, PlasmaTablesPixelValue(row, x), bytesPerPixel);
+		dst += target.rowPitch;
+	}
+
+#if PLUGIN_KERNELS_X86
+	if (useSSE2 && target.streamingStores)
+		StreamingStoreFence();
+#endif
+}
+
+
+typedef void (*FillPlasmaPixelsFunc)(const PlasmaTarget& target, float time, int rowBegin, int rowEnd);
+
+static const FillPlasmaPixelsFunc kPlasmaKernelFuncs[kPlasmaKernelCount] =
+{
+	FillPlasmaPixels_Scalar,
+#if PLUGIN_KERNELS_X86
+	FillPlasmaPixels_SSE2,
+	FillPlasmaPixels_AVX2,
+#else
+	NULL,
+	NULL,
+#endif
+	FillPlasmaPixels_Tables,
+};
+
+static const char* const kPlasmaKernelNames[kPlasmaKernelCount] = { "scalar", "sse2", "avx2", "tables" };
+
+
+const char* GetPlasmaKernelName(PlasmaKernel kernel)
+{
+	return kernel >= 0 && kernel < kPlasmaKernelCount ? kPlasmaKernelNames[kernel] : NULL;
+}
+
+
+bool IsPlasmaKernelSupported(PlasmaKernel kernel)
+{
+	switch (kernel)
+	{
+	case kPlasmaKernel_Scalar:
+	case kPlasmaKernel_Tables: return true;
+#if PLUGIN_KERNELS_X86
+	case kPlasmaKernel_SSE2: return CpuSupportsSSE2();
+	case kPlasmaKernel_AVX2: return CpuSupportsAVX2();
+#endif
+	default: return false;
+	}
+}
+
+
+// Chosen on first use; set from script/host threads, read on the render thread
+static std::atomic<int> s_PlasmaKernel(-1);
+static std::atomic<bool> s_PlasmaKernelOverridden(false);
+
+PlasmaKernel GetPlasmaKernel()
+{
+	int kernel = s_PlasmaKernel.load(std::memory_order_relaxed);
+	if (kernel < 0)
+	{
+		kernel = kPlasmaKernelCount - 1;
+		while (!IsPlasmaKernelSupported(PlasmaKernel(kernel)))
+			--kernel;
+		s_PlasmaKernel.store(kernel, std::memory_order_relaxed);
+	}
+	return PlasmaKernel(kernel);
+}
+
+
+bool SetPlasmaKernel(PlasmaKernel kernel)
+{
+	if (!IsPlasmaKernelSupported(kernel))
+		return false;
+	s_PlasmaKernel.store(kernel, std::memory_order_relaxed);
+	s_PlasmaKernelOverridden.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+
+static std::atomic<int> s_KernelMathPrecision(kPluginMathPrecision_Exact);
+
+PluginMathPrecision GetKernelMathPrecision()
+{
+	return PluginMathPrecision(s_KernelMathPrecision.load(std::memory_order_relaxed));
+}
+
+void SetKernelMathPrecision(PluginMathPrecision precision)
+{
+	if (precision >= 0 && precision < kPluginMathPrecisionCount)
+		s_KernelMathPrecision.store(precision, std::memory_order_relaxed);
+}
+
+
+struct PlasmaFillJob
+{
+	FillPlasmaPixelsFunc kernel;
+	PlasmaTarget target;
+	float time;
+};
+
+static void FillPlasmaRowBand(int rowBegin, int rowEnd, void* userData)
+{
+	PLUGIN_TRACE_SCOPE("FillPlasmaRows");
+	const PlasmaFillJob& job = *(const PlasmaFillJob*)userData;
+	job.kernel(job.target, job.time, rowBegin, rowEnd);
+}
+
+void FillPlasmaRect(unsigned char* dst, int x, int y, int width, int height, int imageWidth, int imageHeight, int rowPitch,
+	int bytesPerPixel, float time, bool streamingStores)
+{
+	if (width <= 0 || height <= 0)
+		return;
+
+	// The default table kernel gives way to the fastest one that computes the radial term
+	// where the image's field doesn't fit into the cache budget. The reference keeps the
+	// field alive until the bands, which look it up again, are done.
+	int kernel = GetPlasmaKernel();
+	PlasmaRadialFieldPtr radialField;
+	if (kernel == kPlasmaKernel_Tables && !s_PlasmaKernelOverridden.load(std::memory_order_relaxed))
+	{
+		radialField = ReservePlasmaRadialField(imageWidth, imageHeight);
+		if (!radialField)
+		{
+			kernel = kPlasmaKernel_Tables - 1;
+			while (!IsPlasmaKernelSupported(PlasmaKernel(kernel)))
+				--kernel;
+		}
+	}
+
+	PlasmaFillJob job;
+	job.kernel = kPlasmaKernelFuncs[kernel];
+	job.target.pixels = dst;
+	job.target.x = x;
+	job.target.y = y;
+	job.target.width = width;
+	job.target.height = height;
+	job.target.rowPitch = rowPitch;
+	job.target.imageWidth = imageWidth;
+	job.target.imageHeight = imageHeight;
+	job.target.bytesPerPixel = bytesPerPixel;
+	job.target.streamingStores = streamingStores;
+	job.target.mathPrecision = GetKernelMathPrecision();
+	job.time = time;
+	// Waking a worker costs a few microseconds; only hand it bands worth more than that
+	const int minRowsPerBand = (kPlasmaMinPixelsPerBand + width - 1) / width;
+	PluginWorkers_ParallelFor(height, minRowsPerBand, FillPlasmaRowBand, &job);
+}
+
+void FillPlasmaPixels(unsigned char* dst, int width, int height, int rowPitch, int bytesPerPixel, float time, bool streamingStores)
+{
+	FillPlasmaRect(dst, 0, 0, width, height, width, height, rowPitch, bytesPerPixel, time, streamingStores);
+}
+
+
+template<PluginMathPrecision Precision>
+static void DeformVertices_Scalar(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride, float time)
+{
+	const float t = time * 3.0f;
+
+	// modify vertex Y position with several scrolling sine waves,
+	// copy the rest of the source data unmodified
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	for (int i = vertexBegin; i < vertexEnd; ++i)
+	{
+		DeformMeshVertex<Precision>(src, i, *(MeshVertex*)bufferPtr, t);
+		bufferPtr += dstStride;
+	}
+}
+
+void DeformMeshVertices_Scalar(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision)
+{
+	if (precision == kPluginMathPrecision_Fast)
+		DeformVertices_Scalar<kPluginMathPrecision_Fast>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+	else
+		DeformVertices_Scalar<kPluginMathPrecision_Exact>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+}
+
+
+void DeformMeshVertices_Tables(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision)
+{
+	if (vertexBegin >= vertexEnd)
+		return;
+	const float t = time * 3.0f;
+	const float sinT = sinf(t), cosT = cosf(t);
+	VertexWaveScales scales;
+	scales.sinX = 0.4f * cosT;
+	scales.cosX = 0.4f * sinT;
+	scales.sinZ = 0.3f * cosT;
+	scales.cosZ = -0.3f * sinT;
+
+#if PLUGIN_KERNELS_X86
+	static const bool useSSE2 = CpuSupportsSSE2();
+	if (useSSE2)
+	{
+		DeformMeshVerticesTables_SSE2(src, vertexBegin, vertexEnd, dst, dstStride, scales);
+		return;
+	}
+#endif
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	for (int i = vertexBegin; i < vertexEnd; ++i)
+	{
+		StoreMeshVertex(src, i, DeformTablesY(src, i, scales), *(MeshVertex*)bufferPtr);
+		bufferPtr += dstStride;
+	}
+}
+
+
+template<PluginMathPrecision Precision>
+static void DeformVertexArray_Scalar(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride, float time)
+{
+	const float t = time * 3.0f;
+
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	for (int i = vertexBegin; i < vertexEnd; ++i)
+	{
+		const MeshSourceVertex& s = src.vertexArray[i];
+		MeshVertex& d = *(MeshVertex*)bufferPtr;
+		d.pos[0] = s.pos[0];
+		d.pos[1] = DeformWaveY<Precision>(s.pos[0], s.pos[1], s.pos[2], t);
+		d.pos[2] = s.pos[2];
+		d.normal[0] = s.normal[0];
+		d.normal[1] = s.normal[1];
+		d.normal[2] = s.normal[2];
+		d.uv[0] = s.uv[0];
+		d.uv[1] = s.uv[1];
+		bufferPtr += dstStride;
+	}
+}
+
+void DeformVertexArray_Scalar(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision)
+{
+	if (precision == kPluginMathPrecision_Fast)
+		DeformVertexArray_Scalar<kPluginMathPrecision_Fast>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+	else
+		DeformVertexArray_Scalar<kPluginMathPrecision_Exact>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+}
+
+
+typedef void (*DeformMeshVerticesFunc)(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+
+static const DeformMeshVerticesFunc kVertexKernelFuncs[kVertexKernelCount] =
+{
+	DeformMeshVertices_Scalar,
+#if PLUGIN_KERNELS_X86
+	DeformMeshVertices_SSE2,
+	DeformMeshVertices_AVX2,
+#else
+	NULL,
+	NULL,
+#endif
+	DeformMeshVertices_Tables,
+};
+
+static const char* const kVertexKernelNames[kVertexKernelCount] = { "scalar", "sse2", "avx2", "tables" };
+
+// What each kernel selection runs on a referenced vertex array; only the scalar one needs no SSE2
+static const DeformMeshVerticesFunc kVertexArrayKernelFuncs[kVertexKernelCount] =
+{
+	DeformVertexArray_Scalar,
+#if PLUGIN_KERNELS_X86
+	DeformVertexArray_SSE2,
+	DeformVertexArray_SSE2,
+	DeformVertexArray_SSE2,
+#else
+	NULL,
+	NULL,
+	DeformVertexArray_Scalar,
+#endif
+};
+
+
+const char* GetVertexKernelName(VertexKernel kernel)
+{
+	return kernel >= 0 && kernel < kVertexKernelCount ? kVertexKernelNames[kernel] : NULL;
+}
+
+
+bool IsVertexKernelSupported(VertexKernel kernel)
+{
+	switch (kernel)
+	{
+	case kVertexKernel_Scalar:
+	case kVertexKernel_Tables: return true;
+#if PLUGIN_KERNELS_X86
+	case kVertexKernel_SSE2: return CpuSupportsSSE2();
+	case kVertexKernel_AVX2: return CpuSupportsAVX2();
+#endif
+	default: return false;
+	}
+}
+
+
+// Chosen on first use, like the plasma kernel
+static std::atomic<int> s_VertexKernel(-1);
+
+VertexKernel GetVertexKernel()
+{
+	int kernel = s_VertexKernel.load(std::memory_order_relaxed);
+	if (kernel < 0)
+	{
+		kernel = kVertexKernelCount - 1;
+		while (!IsVertexKernelSupported(VertexKernel(kernel)))
+			--kernel;
+		s_VertexKernel.store(kernel, std::memory_order_relaxed);
+	}
+	return VertexKernel(kernel);
+}
+
+
+bool SetVertexKernel(VertexKernel kernel)
+{
+	if (!IsVertexKernelSupported(kernel))
+		return false;
+	s_VertexKernel.store(kernel, std::memory_order_relaxed);
+	return true;
+}
+
+
+static std::atomic<int> s_VertexParallelThreshold(kVertexParallelDefaultThreshold);
+
+int GetVertexParallelThreshold()
+{
+	return s_VertexParallelThreshold.load(std::memory_order_relaxed);
+}
+
+void SetVertexParallelThreshold(int vertexCount)
+{
+	s_VertexParallelThreshold.store(vertexCount > 0 ? vertexCount : kVertexParallelDefaultThreshold, std::memory_order_relaxed);
+}
+
+
+struct VertexDeformJob
+{
+	DeformMeshVerticesFunc kernel;
+	const MeshVertexStreams* src;
+	void* dst;
+	int dstStride;
+	int vertexCount;
+	int firstAlignedVertex;		// the first one that starts on a cache line of dst, 0 if none does (see DeformMeshVertices)
+	float time;
+	PluginMathPrecision precision;
+};
+
+static void InitVertexDeformJob(VertexDeformJob& job, VertexKernel kernel, const MeshVertexStreams& src, void* dst, int dstStride,
+	float time, PluginMathPrecision precision)
+{
+	job.kernel = (src.vertexArray ? kVertexArrayKernelFuncs : kVertexKernelFuncs)[kernel];
+	job.src = &src;
+	job.dst = dst;
+	job.dstStride = dstStride;
+	job.vertexCount = src.GetVertexCount();
+	job.firstAlignedVertex = 0;
+	for (int i = 0; i < 64; ++i)
+	{
+		if (((size_t)dst + size_t(i) * dstStride) % 64 == 0)
+		{
+			job.firstAlignedVertex = i;
+			break;
+		}
+	}
+	job.time = time;
+	job.precision = precision;
+}
+
+// Chunk c of 'chunkSize' vertices starts at firstAlignedVertex + c * chunkSize, except chunk 0,
+// which also takes the vertices before that
+static int GetVertexChunkBegin(const VertexDeformJob& job, int chunk, int chunkSize = kVertexChunkSize)
+{
+	if (chunk == 0)
+		return 0;
+	const long long begin = job.firstAlignedVertex + (long long)chunk * chunkSize;
+	return begin < job.vertexCount ? int(begin) : job.vertexCount;
+}
+
+static int GetVertexChunkCount(const VertexDeformJob& job, int chunkSize = kVertexChunkSize)
+{
+	const int count = (job.vertexCount - job.firstAlignedVertex + chunkSize - 1) / chunkSize;
+	return count > 1 ? count : 1;
+}
+
+static void DeformVertexChunks(int chunkBegin, int chunkEnd, void* userData)
+{
+	PLUGIN_TRACE_SCOPE("DeformVertexChunks");
+	const VertexDeformJob& job = *(const VertexDeformJob*)userData;
+	job.kernel(*job.src, GetVertexChunkBegin(job, chunkBegin), GetVertexChunkBegin(job, chunkEnd), job.dst, job.dstStride,
+		job.time, job.precision);
+}
+
+void DeformMeshVertices(const MeshVertexStreams& src, void* dst, int dstStride, float time)
+{
+	VertexDeformJob job;
+	InitVertexDeformJob(job, GetVertexKernel(), src, dst, dstStride, time, GetKernelMathPrecision());
+	if (job.vertexCount < GetVertexParallelThreshold() || job.vertexCount <= kVertexChunkSize)
+	{
+		job.kernel(src, 0, job.vertexCount, dst, dstStride, time, job.precision);
+		return;
+	}
+	PluginWorkers_ParallelFor(GetVertexChunkCount(job), 1, DeformVertexChunks, &job);
+}
+
+
+// The runs of all meshes of a DeformMeshBatch, numbered one mesh after the other
+struct MeshBatchDeformJob
+{
+	const VertexDeformJob* meshes;
+	const int* firstRuns;		// of each mesh, and the total run count after the last one
+	int meshCount;
+};
+
+static void DeformMeshBatchRuns(int runBegin, int runEnd, void* userData)
+{
+	PLUGIN_TRACE_SCOPE("DeformMeshBatchRuns");
+	const MeshBatchDeformJob& batch = *(const MeshBatchDeformJob*)userData;
+	int mesh = int(std::upper_bound(batch.firstRuns, batch.firstRuns + batch.meshCount, runBegin) - batch.firstRuns) - 1;
+	for (; mesh < batch.meshCount && batch.firstRuns[mesh] < runEnd; ++mesh)
+	{
+		const VertexDeformJob& job = batch.meshes[mesh];
+		const int firstRun = batch.firstRuns[mesh];
+		const int vertexBegin = GetVertexChunkBegin(job, std::max(runBegin - firstRun, 0), kVertexBatchRunSize);
+		const int vertexEnd = GetVertexChunkBegin(job, std::min(runEnd, batch.firstRuns[mesh + 1]) - firstRun, kVertexBatchRunSize);
+		if (vertexBegin < vertexEnd)
+			job.kernel(*job.src, vertexBegin, vertexEnd, job.dst, job.dstStride, job.time, job.precision);
+	}
+}
+
+void DeformMeshBatch(const MeshDeformTarget* targets, int targetCount)
+{
+	// Only called from the render thread; kept around so that frames don't reallocate them
+	static std::vector<VertexDeformJob> meshes;
+	static std::vector<int> firstRuns;
+	meshes.clear();
+	firstRuns.clear();
+
+	const VertexKernel kernel = GetVertexKernel();
+	const PluginMathPrecision precision = GetKernelMathPrecision();
+	long long vertexCount = 0;
+	int runCount = 0;
+	for (int i = 0; i < targetCount; ++i)
+	{
+		VertexDeformJob job;
+		InitVertexDeformJob(job, kernel, *targets[i].src, targets[i].dst, targets[i].dstStride, targets[i].time, precision);
+		if (job.vertexCount <= 0)
+			continue;
+		meshes.push_back(job);
+		firstRuns.push_back(runCount);
+		vertexCount += job.vertexCount;
+		runCount += GetVertexChunkCount(job, kVertexBatchRunSize);
+	}
+	firstRuns.push_back(runCount);
+
+	if (vertexCount < GetVertexParallelThreshold() || vertexCount <= kVertexChunkSize)
+	{
+		for (size_t i = 0; i < meshes.size(); ++i)
+			meshes[i].kernel(*meshes[i].src, 0, meshes[i].vertexCount, meshes[i].dst, meshes[i].dstStride, meshes[i].time, meshes[i].precision);
+		return;
+	}
+
+	MeshBatchDeformJob batch;
+	batch.meshes = meshes.data();
+	batch.firstRuns = firstRuns.data();
+	batch.meshCount = int(meshes.size());
+	PluginWorkers_ParallelFor(runCount, kVertexChunkSize / kVertexBatchRunSize, DeformMeshBatchRuns, &batch);
+}
+
+
+void CopyMeshSource_Scalar(MeshVertexStreams& dst, int vertexBegin, int vertexEnd, const float* positions, const float* normals, const float* uvs)
+{
+	positions += size_t(vertexBegin) * 3;
+	normals += size_t(vertexBegin) * 3;
+	uvs += size_t(vertexBegin) * 2;
+	for (int i = vertexBegin; i < vertexEnd; ++i)
+	{
+		dst.posX[i] = positions[0];
+		dst.posY[i] = positions[1];
+		dst.posZ[i] = positions[2];
+		dst.normalX[i] = normals[0];
+		dst.normalY[i] = normals[1];
+		dst.normalZ[i] = normals[2];
+		dst.u[i] = uvs[0];
+		dst.v[i] = uvs[1];
+		// The phases rounded to float like the reference kernel rounds them
+		const float phaseX = positions[0] * 1.1f, phaseZ = positions[2] * 0.9f;
+		dst.sinPhaseX[i] = sinf(phaseX);
+		dst.cosPhaseX[i] = cosf(phaseX);
+		dst.sinPhaseZ[i] = sinf(phaseZ);
+		dst.cosPhaseZ[i] = cosf(phaseZ);
+		positions += 3;
+		normals += 3;
+		uvs += 2;
+	}
+}
+
+
+typedef void (*CopyMeshSourceFunc)(MeshVertexStreams& dst, int vertexBegin, int vertexEnd, const float* positions, const float* normals, const float* uvs);
+
+struct MeshSourceCopyJob
+{
+	CopyMeshSourceFunc kernel;
+	MeshVertexStreams* dst;
+	int vertexCount;
+	const float* positions;
+	const float* normals;
+	const float* uvs;
+};
+
+static void CopyMeshSourceChunks(int chunkBegin, int chunkEnd, void* userData)
+{
+	PLUGIN_TRACE_SCOPE("CopyMeshSourceChunks");
+	const MeshSourceCopyJob& job = *(const MeshSourceCopyJob*)userData;
+	const int vertexEnd = (long long)chunkEnd * kVertexChunkSize < job.vertexCount ? chunkEnd * kVertexChunkSize : job.vertexCount;
+	job.kernel(*job.dst, chunkBegin * kVertexChunkSize, vertexEnd, job.positions, job.normals, job.uvs);
+}
+
+void CopyMeshSource(MeshVertexStreams& dst, int vertexCount, const float* positions, const float* normals, const float* uvs)
+{
+	MeshVertexStream* streams[MeshVertexStreams::kStreamCount];
+	dst.GetStreams(streams);
+	for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+		streams[s]->resize(vertexCount);
+	dst.vertexArray = NULL;
+	dst.vertexArrayCount = 0;
+
+	MeshSourceCopyJob job;
+	job.kernel = CopyMeshSource_Scalar;
+#if PLUGIN_KERNELS_X86
+	static const bool useSSE2 = CpuSupportsSSE2();
+	if (useSSE2)
+		job.kernel = CopyMeshSource_SSE2;
+#endif
+	job.dst = &dst;
+	job.vertexCount = vertexCount;
+	job.positions = positions;
+	job.normals = normals;
+	job.uvs = uvs;
+	if (vertexCount < GetVertexParallelThreshold() || vertexCount <= kVertexChunkSize)
+		job.kernel(dst, 0, vertexCount, positions, normals, uvs);
+	else
+		PluginWorkers_ParallelFor((vertexCount + kVertexChunkSize - 1) / kVertexChunkSize, 1, CopyMeshSourceChunks, &job);
+}
+
+
+void ReferenceMeshSource(MeshVertexStreams& dst, int vertexCount, const MeshSourceVertex* vertices)
+{
+	MeshVertexStream* streams[MeshVertexStreams::kStreamCount];
+	dst.GetStreams(streams);
+	for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+		MeshVertexStream().swap(*streams[s]);
+	dst.vertexArray = vertexCount > 0 ? vertices : NULL;
+	dst.vertexArrayCount = vertexCount > 0 && vertices ? vertexCount : 0;
+}
+
+
+void DrawColoredTriangle(RenderAPI* api, float time)
+{
+	PLUGIN_STAGE_TIMER(kPluginStage_DrawColoredTriangle);
+
+	// Draw a colored triangle. Note that colors will come out differently
+	// in D3D and OpenGL, for example, since they expect color bytes
+	// in different ordering.
+	SimpleVertex verts[6] =
+	{
+		{ -0.5f, -0.5f,  0, 0xFFff0000, 0.f, 0.f},
+		{  0.5f, -0.5f,  0, 0xFF00ff00, 1.f, 0.f},
+		{  0.5f,  0.5f,  0, 0xFF0000ff, 1.f, 1.f},
+		{ -0.5f, -0.5f,  0, 0xFFff0000, 0.f, 0.f},
+		{  0.5f,  0.5f,  0, 0xFF0000ff, 1.f, 1.f},
+		{ -0.5f,  0.5f,  0, 0xFF00ff00, 0.f, 1.f},
+	};
+
+	// Transformation matrix: rotate around Z axis based on time.
+	float phi = time; // time set externally from Unity script
+	float cosPhi = cosf(phi);
+	float sinPhi = sinf(phi);
+	float depth = 0.7f;
+	float finalDepth = api->GetUsesReverseZ() ? 1.0f - depth : depth;
+	float worldMatrix[16] = {
+		cosPhi,-sinPhi,0,0,
+		sinPhi,cosPhi,0,0,
+		0,0,1,0,
+		0,0,finalDepth,1,
+	};
+
+	PLUGIN_STAGE_TIMER(kPluginStage_DrawSimpleTriangles);
+	api->DrawSimpleTriangles(worldMatrix, 2, verts);
+}
+
+
+// Clips the rect to a width x height texture; false if nothing is left
+static bool ClipTextureRect(const PluginTextureRect& rect, int width, int height, PluginTextureRect& clipped)
+{
+	const int x0 = rect.x > 0 ? rect.x : 0;
+	const int y0 = rect.y > 0 ? rect.y : 0;
+	const int x1 = rect.x + rect.width < width ? rect.x + rect.width : width;
+	const int y1 = rect.y + rect.height < height ? rect.y + rect.height : height;
+	clipped.x = x0;
+	clipped.y = y0;
+	clipped.width = x1 - x0;
+	clipped.height = y1 - y0;
+	return x0 < x1 && y0 < y1;
+}
+
+
+// Updates only the given rects of the texture, as a region update or, on backends without those
+// (D3D12), as a batch of one update per rect; false if the backend has neither
+static bool ModifyTextureRects(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	const PluginTextureRect* rects, int rectCount)
+{
+	std::vector<PluginTextureRect> clipped;
+	clipped.reserve(rectCount);
+	for (int i = 0; i < rectCount; ++i)
+	{
+		PluginTextureRect rect;
+		if (ClipTextureRect(rects[i], width, height, rect))
+			clipped.push_back(rect);
+	}
+	if (clipped.empty())
+		return true;
+
+	std::vector<PluginTextureRectMemory> memory(clipped.size());
+	std::vector<PluginTextureUpdate> batch;
+	void* textureDataPtr;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyTexture);
+		textureDataPtr = api->BeginModifyTextureRegion(textureHandle, width, height, format, clipped.data(), int(clipped.size()), memory.data());
+		if (!textureDataPtr)
+		{
+			batch.resize(clipped.size());
+			for (size_t i = 0; i < clipped.size(); ++i)
+			{
+				PluginTextureUpdate update = { textureHandle, width, height, format, clipped[i] };
+				batch[i] = update;
+			}
+			textureDataPtr = api->BeginModifyTextures(batch.data(), int(batch.size()), memory.data());
+		}
+	}
+	if (!textureDataPtr)
+		return false;
+
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	const bool streamingStores = api->IsTextureMemoryWriteCombined();
+	for (size_t i = 0; i < clipped.size(); ++i)
+	{
+		const PluginTextureRect& rect = clipped[i];
+		FillPlasmaRect(memory[i].pixels, rect.x, rect.y, rect.width, rect.height, width, height, memory[i].rowPitch, bytesPerPixel, time, streamingStores);
+	}
+
+	PLUGIN_STAGE_TIMER(kPluginStage_EndModifyTexture);
+	if (batch.empty())
+		api->EndModifyTextureRegion(textureHandle, width, height, format, clipped.data(), int(clipped.size()), textureDataPtr);
+	else
+		api->EndModifyTextures(batch.data(), int(batch.size()), textureDataPtr);
+	return true;
+}
+
+
+// ModifyTexturePixels without its stage timer
+static void ModifyTexture(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	const PluginTextureRect* rects, int rectCount)
+{
+	if (rectCount > 0 && ModifyTextureRects(api, textureHandle, width, height, format, time, rects, rectCount))
+		return;
+
+	int textureRowPitch;
+	void* textureDataPtr;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyTexture);
+		textureDataPtr = api->BeginModifyTexture(textureHandle, width, height, format, &textureRowPitch);
+	}
+	if (!textureDataPtr)
+		return;
+
+	FillPlasmaPixels((unsigned char*)textureDataPtr, width, height, textureRowPitch, GetPluginTextureFormatBytesPerPixel(format), time,
+		api->IsTextureMemoryWriteCombined());
+
+	PLUGIN_STAGE_TIMER(kPluginStage_EndModifyTexture);
+	api->EndModifyTexture(textureHandle, width, height, format, textureRowPitch, textureDataPtr);
+}
+
+
+void ModifyTexturePixels(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	const PluginTextureRect* rects, int rectCount)
+{
+	if (!textureHandle)
+		return;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyTexturePixels);
+	ModifyTexture(api, textureHandle, width, height, format, time, rects, rectCount);
+}
+
+
+bool ModifyTextureRegion(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	const PluginTextureRect* rects, int rectCount)
+{
+	if (!textureHandle)
+		return true;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyTexturePixels);
+	return ModifyTextureRects(api, textureHandle, width, height, format, time, rects, rectCount);
+}
+
+
+void ModifyTextureBatch(RenderAPI* api, const PluginTextureUpdate* updates, int updateCount, float time)
+{
+	if (updateCount <= 0)
+		return;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyTexturePixels);
+
+	// Only called from the render thread; kept around so that frames don't reallocate them
+	static std::vector<PluginTextureUpdate> batch;
+	static std::vector<PluginTextureRectMemory> memory;
+	batch.clear();
+	for (int i = 0; i < updateCount; ++i)
+	{
+		PluginTextureUpdate update = updates[i];
+		if (update.textureHandle && ClipTextureRect(updates[i].rect, update.textureWidth, update.textureHeight, update.rect))
+			batch.push_back(update);
+	}
+	if (batch.empty())
+		return;
+
+	memory.resize(batch.size());
+	void* textureDataPtr;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyTexture);
+		textureDataPtr = api->BeginModifyTextures(batch.data(), int(batch.size()), memory.data());
+	}
+	if (textureDataPtr)
+	{
+		const bool streamingStores = api->IsTextureMemoryWriteCombined();
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			const PluginTextureUpdate& update = batch[i];
+			FillPlasmaRect(memory[i].pixels, update.rect.x, update.rect.y, update.rect.width, update.rect.height, update.textureWidth,
+				update.textureHeight, memory[i].rowPitch, GetPluginTextureFormatBytesPerPixel(update.format), time, streamingStores);
+		}
+
+		PLUGIN_STAGE_TIMER(kPluginStage_EndModifyTexture);
+		api->EndModifyTextures(batch.data(), int(batch.size()), textureDataPtr);
+		return;
+	}
+
+	// No batches in this backend: one update per texture, as a whole if its rect covers all of it
+	static std::vector<PluginTextureRect> rects;
+	for (size_t begin = 0, end; begin < batch.size(); begin = end)
+	{
+		const PluginTextureUpdate& update = batch[begin];
+		rects.clear();
+		for (end = begin; end < batch.size() && batch[end].textureHandle == update.textureHandle; ++end)
+			rects.push_back(batch[end].rect);
+
+		const bool wholeTexture = rects.size() == 1 && rects[0].width == update.textureWidth && rects[0].height == update.textureHeight;
+		ModifyTexture(api, update.textureHandle, update.textureWidth, update.textureHeight, update.format, time,
+			wholeTexture ? NULL : rects.data(), wholeTexture ? 0 : int(rects.size()));
+	}
+}
+
+
+// ModifyVertexBuffer without its stage timer, which the batch's covers
+static void ModifyVertices(RenderAPI* api, void* bufferHandle, const MeshVertexStreams& source, float time)
+{
+	const int vertexCount = source.GetVertexCount();
+
+	size_t bufferSize;
+	void* bufferDataPtr;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyVertexBuffer);
+		bufferDataPtr = api->BeginModifyVertexBuffer(bufferHandle, &bufferSize);
+	}
+	if (!bufferDataPtr)
+		return;
+	int vertexStride = int(bufferSize / vertexCount);
+
+	// Unity should return us a buffer that is the size of `vertexCount * sizeof(MeshVertex)`
+	// If that's not the case then we should quit to avoid unexpected results.
+	// This can happen if https://docs.unity3d.com/ScriptReference/Mesh.GetNativeVertexBufferPtr.html returns
+	// a pointer to a buffer with an unexpected layout.
+	if (static_cast<unsigned int>(vertexStride) != sizeof(MeshVertex))
+		return;
+
+	DeformMeshVertices(source, bufferDataPtr, vertexStride, time);
+
+	PLUGIN_STAGE_TIMER(kPluginStage_EndModifyVertexBuffer);
+	api->EndModifyVertexBuffer(bufferHandle);
+}
+
+
+void ModifyVertexBuffer(RenderAPI* api, void* bufferHandle, const MeshVertexStreams& source, float time)
+{
+	if (!bufferHandle || source.GetVertexCount() <= 0)
+		return;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyVertexBuffer);
+	ModifyVertices(api, bufferHandle, source, time);
+}
+
+
+void ModifyVertexBufferBatch(RenderAPI* api, const MeshBufferUpdate* updates, int updateCount)
+{
+	// Only called from the render thread; kept around so that frames don't reallocate them
+	static std::vector<MeshBufferUpdate> batch;
+	static std::vector<void*> bufferHandles;
+	static std::vector<PluginVertexBufferMemory> memory;
+	static std::vector<MeshDeformTarget> targets;
+	batch.clear();
+	bufferHandles.clear();
+	for (int i = 0; i < updateCount; ++i)
+	{
+		if (updates[i].bufferHandle && updates[i].source && updates[i].source->GetVertexCount() > 0)
+		{
+			batch.push_back(updates[i]);
+			bufferHandles.push_back(updates[i].bufferHandle);
+		}
+	}
+	if (batch.empty())
+		return;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyVertexBuffer);
+
+	memory.resize(batch.size());
+	bool mapped;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyVertexBuffer);
+		mapped = api->BeginModifyVertexBuffers(bufferHandles.data(), int(batch.size()), memory.data());
+	}
+	if (mapped)
+	{
+		// Buffers that didn't map, or don't hold the source's vertex count in MeshVertex layout
+		// (see ModifyVertices), are left alone
+		targets.clear();
+		for (size_t i = 0; i < batch.size(); ++i)
+		{
+			if (!memory[i].data || memory[i].size / batch[i].source->GetVertexCount() != sizeof(MeshVertex))
+				continue;
+			const MeshDeformTarget target = { batch[i].source, memory[i].data, int(sizeof(MeshVertex)), batch[i].time };
+			targets.push_back(target);
+		}
+		DeformMeshBatch(targets.data(), int(targets.size()));
+
+		PLUGIN_STAGE_TIMER(kPluginStage_EndModifyVertexBuffer);
+		api->EndModifyVertexBuffers(bufferHandles.data(), int(batch.size()), memory.data());
+		return;
+	}
+
+	// No batches in this backend: one update per buffer
+	for (size_t i = 0; i < batch.size(); ++i)
+		ModifyVertices(api, batch[i].bufferHandle, *batch[i].source, batch[i].time);
+}
+
+
+void UploadTexturePixels(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format,
+	const unsigned char* pixels, int rowPitch)
+{
+	if (!textureHandle)
+		return;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyTexturePixels);
+
+	int textureRowPitch;
+	void* textureDataPtr;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyTexture);
+		textureDataPtr = api->BeginModifyTexture(textureHandle, width, height, format, &textureRowPitch);
+	}
+	if (!textureDataPtr)
+		return;
+
+	const size_t rowBytes = size_t(width) * GetPluginTextureFormatBytesPerPixel(format);
+	if (textureRowPitch == rowPitch)
+		memcpy(textureDataPtr, pixels, size_t(rowPitch) * (height - 1) + rowBytes);
+	else
+	{
+		for (int y = 0; y < height; ++y)
+			memcpy((unsigned char*)textureDataPtr + size_t(y) * textureRowPitch, pixels + size_t(y) * rowPitch, rowBytes);
+	}
+
+	PLUGIN_STAGE_TIMER(kPluginStage_EndModifyTexture);
+	api->EndModifyTexture(textureHandle, width, height, format, textureRowPitch, textureDataPtr);
+}
+
+
+void UploadVertexBuffer(RenderAPI* api, void* bufferHandle, int vertexCount, const MeshVertex* vertices)
+{
+	if (!bufferHandle || vertexCount <= 0)
+		return;
+	PLUGIN_STAGE_TIMER(kPluginStage_ModifyVertexBuffer);
+
+	size_t bufferSize;
+	void* bufferDataPtr;
+	{
+		PLUGIN_STAGE_TIMER(kPluginStage_BeginModifyVertexBuffer);
+		bufferDataPtr = api->BeginModifyVertexBuffer(bufferHandle, &bufferSize);
+	}
+	if (!bufferDataPtr)
+		return;
+	if (bufferSize / vertexCount != sizeof(MeshVertex))
+		return;
+
+	// Same fields as DeformMeshVertices writes; the colors in the buffer are left alone
+	MeshVertex* dst = (MeshVertex*)bufferDataPtr;
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		memcpy(dst[i].pos, vertices[i].pos, sizeof(dst[i].pos));
+		memcpy(dst[i].normal, vertices[i].normal, sizeof(dst[i].normal));
+		memcpy(dst[i].uv, vertices[i].uv, sizeof(dst[i].uv));
+	}
+
+	PLUGIN_STAGE_TIMER(kPluginStage_EndModifyVertexBuffer);
+	api->EndModifyVertexBuffer(bufferHandle);
+}
@@ -0,0 +1,466 @@
+#pragma once
+
+// CPU side work the plugin does every frame: generating the "plasma" texture pixels,
+// deforming the mesh vertices and setting up the rotating triangle.
+//
+// Kept apart from the exported entry points in RenderingPlugin.cpp so that the host
+// tools can run and time each piece on its own.
+
+#include "PluginMath.h"
+#include "RenderAPI.h"
+
+#include <math.h>
+#include <memory>
+#include <new>
+#include <stddef.h>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+
+// Vertex layout of the mesh that the script passes in; UseRenderingPlugin.cs
+// sets up the mesh vertex buffer with exactly this layout.
+struct MeshVertex
+{
+	float pos[3];
+	float normal[3];
+	float color[4];
+	float uv[2];
+};
+
+// Vertex layout of the interleaved source arrays SetMeshVertexArrayFromUnity takes, e.g. the
+// contents of a NativeArray of a struct with these three fields.
+struct MeshSourceVertex
+{
+	float pos[3];
+	float normal[3];
+	float uv[2];
+};
+
+// std::allocator that leaves the elements resize() adds uninitialized instead of zeroing
+// them: the source streams are sized right before they are written, so for a mesh of
+// millions of vertices the zeroing would be a whole extra pass over them.
+template<typename T>
+struct UninitializedAllocator : std::allocator<T>
+{
+	template<typename U> struct rebind { typedef UninitializedAllocator<U> other; };
+
+	UninitializedAllocator() { }
+	template<typename U> UninitializedAllocator(const UninitializedAllocator<U>&) { }
+
+	template<typename U> void construct(U* p) { ::new((void*)p) U; }
+	template<typename U, typename... Args> void construct(U* p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...); }
+};
+
+typedef std::vector<float, UninitializedAllocator<float> > MeshVertexStream;
+
+// The source mesh the plugin deforms, one stream of floats per component (structure of
+// arrays) rather than MeshVertex structs, so that the SIMD vertex kernels load the x or z
+// of 4 or 8 vertices with one instruction. Every stream holds one value per vertex.
+//
+// Alternatively the source is an array of MeshSourceVertex in the caller's memory
+// (ReferenceMeshSource): then the streams are empty and nothing is copied; the caller keeps
+// the array alive and unchanged for as long as the source is in use.
+struct MeshVertexStreams
+{
+	MeshVertexStream posX, posY, posZ;
+	MeshVertexStream normalX, normalY, normalZ;
+	MeshVertexStream u, v;
+	// sin and cos of each vertex's wave phases x * 1.1 and z * 0.9, for the table kernel
+	MeshVertexStream sinPhaseX, cosPhaseX, sinPhaseZ, cosPhaseZ;
+
+	const MeshSourceVertex* vertexArray;		// NULL unless referenced
+	int vertexArrayCount;
+
+	MeshVertexStreams() : vertexArray(NULL), vertexArrayCount(0) { }
+
+	int GetVertexCount() const { return vertexArray ? vertexArrayCount : int(posX.size()); }
+
+	// All of the streams above, in that order
+	enum { kStreamCount = 12 };
+	void GetStreams(MeshVertexStream* streams[kStreamCount])
+	{
+		MeshVertexStream* const all[kStreamCount] = { &posX, &posY, &posZ, &normalX, &normalY, &normalZ, &u, &v,
+			&sinPhaseX, &cosPhaseX, &sinPhaseZ, &cosPhaseZ };
+		for (int s = 0; s < kStreamCount; ++s)
+			streams[s] = all[s];
+	}
+};
+
+// Vertex layout used with RenderAPI::DrawSimpleTriangles.
+struct SimpleVertex
+{
+	float x, y, z;
+	unsigned int color;
+	float u, v;
+};
+
+
+// Writes the animated "plasma" pattern for the given time into a width x height image of
+// 'bytesPerPixel' bytes per pixel (1, 2 or 4: R8, RG8 or RGBA8/BGRA8; the pattern is gray, so
+// every channel gets the same value), with the fastest kernel the CPU supports (see
+// PlasmaKernel below). Large images are split into row bands that are filled in parallel on
+// the plugin's worker threads (PluginWorkers.h); returns when all rows are written. With
+// 'streamingStores' the x86 kernels write whole cache lines with non-temporal stores, for
+// write-combined destinations (see RenderAPI::IsTextureMemoryWriteCombined); the pixels are
+// the same either way.
+void FillPlasmaPixels(unsigned char* dst, int width, int height, int rowPitch, int bytesPerPixel, float time, bool streamingStores = false);
+
+// Same, for the width x height rectangle at (x, y) of an imageWidth x imageHeight image only;
+// 'dst' points at the rectangle's first pixel. The pixels are the same as in a whole image fill.
+void FillPlasmaRect(unsigned char* dst, int x, int y, int width, int height, int imageWidth, int imageHeight, int rowPitch,
+	int bytesPerPixel, float time, bool streamingStores = false);
+
+// Smallest band of pixels FillPlasmaPixels gives one thread.
+const int kPlasmaMinPixelsPerBand = 16 * 1024;
+
+// Writes the source vertices to dst in MeshVertex layout (dstStride bytes apart), with the
+// Y position displaced by several scrolling sine waves for the given time, using the
+// fastest vertex kernel the CPU supports (see VertexKernel below; a referenced vertex array
+// has kernels of its own, see DeformVertexArray_Scalar). Colors are left alone.
+// Meshes of at least GetVertexParallelThreshold() vertices are split into chunks that are
+// deformed in parallel on the plugin's worker threads, straight into dst; returns when all
+// vertices are written. The vertices are the same either way.
+//
+// The chunks only start on cache lines of dst if some vertex does: with the 48 byte MeshVertex
+// that takes a dst aligned to 16 bytes (the gcd of stride and cache line). Mapped buffers and
+// the 64-bit allocators are; with a less aligned dst the split still writes the same vertices,
+// but neighbouring chunks share a cache line at each boundary (false sharing).
+void DeformMeshVertices(const MeshVertexStreams& src, void* dst, int dstStride, float time);
+
+// Vertices per chunk of the parallel deformation: 96 KB of MeshVertex output and as much
+// source, which stays in L2 while a thread works on it. A multiple of 64 vertices, so that
+// with chunk boundaries placed on cache lines of dst (see DeformMeshVertices) every chunk
+// ends on a cache line too and no two threads ever write the same line.
+const int kVertexChunkSize = 2048;
+
+// Smaller meshes are deformed on the calling thread only: below this, waking the workers
+// costs more than it saves. Provisional, like the worker count (see PluginWorkers.cpp): it is
+// an estimate from a wake-up of a few microseconds against a few ns per vertex, not a measured
+// crossover, since KernelBench has only run on one core so far. Any thread; 0 restores the
+// default.
+const int kVertexParallelDefaultThreshold = 32 * 1024;
+int GetVertexParallelThreshold();
+void SetVertexParallelThreshold(int vertexCount);
+
+// One mesh of DeformMeshBatch: the source, where its MeshVertex output goes and its time.
+struct MeshDeformTarget
+{
+	const MeshVertexStreams* src;
+	void* dst;
+	int dstStride;
+	float time;
+};
+
+// DeformMeshVertices for any number of meshes. With at least GetVertexParallelThreshold()
+// vertices between them, all of the meshes are cut into runs of kVertexBatchRunSize vertices,
+// starting on cache lines of their dst, and the runs are spread over the worker threads in one
+// go: hundreds of small meshes keep the threads as busy as one large mesh does. The vertices
+// are the same as DeformMeshVertices gives for each mesh.
+void DeformMeshBatch(const MeshDeformTarget* targets, int targetCount);
+
+// Vertices per run of DeformMeshBatch: the fewest that end on a cache line of dst for any
+// start on one (same alignment requirement as DeformMeshVertices). A thread gets at least
+// kVertexChunkSize vertices' worth of runs. The run size only sets how closely the meshes'
+// ends are packed into the threads' shares; KernelBench's "batch/Nt" rows are where to check
+// it, and the threshold, on a multi-core machine.
+const int kVertexBatchRunSize = 64;
+
+// Splits separate float3 position, float3 normal and float2 uv arrays into streams, and
+// computes the phase streams from the positions; on x86 four vertices at a time with the
+// SIMD sines, and for meshes of at least GetVertexParallelThreshold() vertices in chunks
+// on the worker threads. Drops a referenced vertex array.
+void CopyMeshSource(MeshVertexStreams& dst, int vertexCount, const float* positions, const float* normals, const float* uvs);
+
+// Makes dst refer to the caller's vertices instead, without copying anything; frees the streams.
+void ReferenceMeshSource(MeshVertexStreams& dst, int vertexCount, const MeshSourceVertex* vertices);
+
+
+// The per-frame stages of the render event. Each one goes through the given graphics API
+// implementation to get at the texture or buffer memory, and does nothing if that fails.
+void DrawColoredTriangle(RenderAPI* api, float time);
+// With rects, only those parts of the texture are regenerated and uploaded (clipped to the
+// texture), through BeginModifyTextureRegion or else as a BeginModifyTextures batch; backends
+// with neither update the whole texture instead.
+void ModifyTexturePixels(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	const PluginTextureRect* rects = NULL, int rectCount = 0);
+// Only the rects, never the whole texture: false, with nothing updated, on backends with
+// neither kind of partial update.
+bool ModifyTextureRegion(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	const PluginTextureRect* rects, int rectCount);
+// Same for several textures in one batch (RenderAPI::BeginModifyTextures), e.g. whole textures
+// and dirty rects of others; rects are clipped like above. Backends without batches get one
+// update per texture.
+void ModifyTextureBatch(RenderAPI* api, const PluginTextureUpdate* updates, int updateCount, float time);
+void ModifyVertexBuffer(RenderAPI* api, void* bufferHandle, const MeshVertexStreams& source, float time);
+// Same for several vertex buffers in one batch (RenderAPI::BeginModifyVertexBuffers), each with
+// its own source and time, deformed together by DeformMeshBatch. Backends without batches get
+// one update per buffer.
+struct MeshBufferUpdate
+{
+	void* bufferHandle;
+	const MeshVertexStreams* source;
+	float time;
+};
+void ModifyVertexBufferBatch(RenderAPI* api, const MeshBufferUpdate* updates, int updateCount);
+// Same two stages for data that was generated ahead of time (PluginPipeline.h): only copy
+// the given pixels or deformed vertices into the texture or buffer.
+void UploadTexturePixels(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format,
+	const unsigned char* pixels, int rowPitch);
+void UploadVertexBuffer(RenderAPI* api, void* bufferHandle, int vertexCount, const MeshVertex* vertices);
+
+
+// --------------------------------------------------------------------------
+// Plasma kernel variants. The scalar kernel is the reference; the SIMD ones evaluate the
+// sines with a polynomial (PluginMath_SIMD.h) and match it within kPlasmaKernelTolerance
+// per channel: the values differ from sinf() by a few 1e-7, which only changes the output
+// where the sum lands right at a rounding boundary. SIMD kernels exist on x86 only.
+//
+// The table kernel does no per-pixel math beyond a multiply-add: the x, y and x+y terms come
+// from per-column, per-row and per-diagonal tables built for each call, and the radial term
+// sin(d - t) is expanded to sin(d)cos(t) - cos(d)sin(t) with sin(d) and cos(d) read from a
+// field cached per texture size. That is slightly more exact than the reference, which
+// rounds d - t to float first, so it also stays within kPlasmaKernelTolerance.
+//
+// The fields take 8 bytes per pixel and are read again every frame. The cache holds at most
+// kPlasmaRadialFieldBudget bytes of them (reported as kPluginMemory_KernelTables). When the
+// table kernel is only the default, images whose field doesn't fit next to the ones still in
+// use, and any larger than about 2896x2896, are filled with the fastest of the other kernels.
+
+enum PlasmaKernel
+{
+	kPlasmaKernel_Scalar,
+	kPlasmaKernel_SSE2,
+	kPlasmaKernel_AVX2,			// AVX2 + FMA
+	kPlasmaKernel_Tables,		// precomputed phase tables, see above
+	kPlasmaKernelCount
+};
+
+const int kPlasmaKernelTolerance = 1;
+
+const size_t kPlasmaRadialFieldBudget = 64 * 1024 * 1024;
+
+inline size_t GetPlasmaRadialFieldBytes(int width, int height)
+{
+	return size_t(width) * height * 2 * sizeof(float);
+}
+
+// Precision of the sines in the plasma kernels and DeformMeshVertices (see PluginMath.h);
+// exact by default. The fast one still keeps every kernel within kPlasmaKernelTolerance of
+// the exact scalar reference. The table kernels (plasma and vertex) evaluate only a few sines
+// per row band or per frame, always with libm, and ignore it.
+// Any thread; takes effect with the next fill or deformation.
+PluginMathPrecision GetKernelMathPrecision();
+void SetKernelMathPrecision(PluginMathPrecision precision);
+
+const char* GetPlasmaKernelName(PlasmaKernel kernel);
+bool IsPlasmaKernelSupported(PlasmaKernel kernel);
+
+// The kernel FillPlasmaPixels uses; the table kernel unless overridden (see above for the
+// sizes it leaves to the others). SetPlasmaKernel returns false (and changes nothing) if the
+// CPU doesn't support 'kernel'; a kernel set here is used for every size.
+PlasmaKernel GetPlasmaKernel();
+bool SetPlasmaKernel(PlasmaKernel kernel);
+
+// The rectangle of the image a kernel writes into: 'pixels' always points at its first row,
+// which is row y of the image, and its first pixel is pixel x of that row.
+struct PlasmaTarget
+{
+	unsigned char* pixels;
+	int x, y;
+	int width, height, rowPitch;
+	int imageWidth, imageHeight;
+	int bytesPerPixel;			// 1, 2 or 4
+	bool streamingStores;
+	PluginMathPrecision mathPrecision;
+};
+
+// The kernels write rows [rowBegin, rowEnd) of the target (counted from its first row).
+// Different row ranges of one target can be filled from different threads at once. The scalar kernel ignores 'streamingStores',
+// and so does the table kernel on non-x86 targets.
+void FillPlasmaPixels_Scalar(const PlasmaTarget& target, float time, int rowBegin, int rowEnd);
+void FillPlasmaPixels_Tables(const PlasmaTarget& target, float time, int rowBegin, int rowEnd);
+#if PLUGIN_KERNELS_X86
+void FillPlasmaPixels_SSE2(const PlasmaTarget& target, float time, int rowBegin, int rowEnd);
+void FillPlasmaPixels_AVX2(const PlasmaTarget& target, float time, int rowBegin, int rowEnd);
+bool CpuSupportsSSE2();
+bool CpuSupportsAVX2();
+// sfence: orders the streaming stores of the calling thread before anything it does next
+void StreamingStoreFence();
+#endif
+
+// --------------------------------------------------------------------------
+// Vertex kernel variants, for DeformMeshVertices. All of them read the source streams and
+// scatter the results into the interleaved MeshVertex layout; the SIMD ones deform 4 (SSE2)
+// or 8 (AVX2) vertices per iteration with the polynomial sines of PluginMath_SIMD.h and
+// stay within kVertexKernelTolerance of the scalar reference.
+//
+// The table kernel has no per-vertex sines: the phases x * 1.1 and z * 0.9 never change, so
+// with the angle addition formulas sin(a + t) = sin(a)cos(t) + cos(a)sin(t) and
+// sin(b - t) = sin(b)cos(t) - cos(b)sin(t) each vertex takes the sines and cosines of its
+// phases from the source streams, and a frame only evaluates sin(t) and cos(t). That is
+// slightly more exact than the reference, which rounds a + t to float first; the error of
+// the reference grows with t, so this one is checked against the formula in double instead.
+
+enum VertexKernel
+{
+	kVertexKernel_Scalar,
+	kVertexKernel_SSE2,
+	kVertexKernel_AVX2,			// AVX2 + FMA
+	kVertexKernel_Tables,		// precomputed phases, see above
+	kVertexKernelCount
+};
+
+// Largest difference to the scalar kernel of the same precision in any position, in units
+// (for the table kernel: to the exact formula); the waves are 0.7 units tall at most, so
+// this is far below what a mesh can show
+const float kVertexKernelTolerance = 1.0e-5f;
+
+const char* GetVertexKernelName(VertexKernel kernel);
+bool IsVertexKernelSupported(VertexKernel kernel);
+
+// The kernel DeformMeshVertices uses; the fastest supported one unless overridden.
+// SetVertexKernel returns false (and changes nothing) if the CPU doesn't support 'kernel'.
+VertexKernel GetVertexKernel();
+bool SetVertexKernel(VertexKernel kernel);
+
+// The kernels deform vertices [vertexBegin, vertexEnd) of the source into the same vertices
+// of dst, which points at vertex 0. Different ranges can be deformed from different threads,
+// and every vertex comes out the same however the ranges are split.
+// The table kernel ignores 'precision'.
+void DeformMeshVertices_Scalar(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+void DeformMeshVertices_Tables(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+#if PLUGIN_KERNELS_X86
+void DeformMeshVertices_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+void DeformMeshVertices_AVX2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+#endif
+
+// The same for a referenced vertex array (src.vertexArray), which has no streams to load
+// from: the SSE2 kernel loads four MeshSourceVertex structs and transposes their first 16
+// bytes to get at x, y and z. DeformMeshVertices uses the scalar one when the scalar kernel
+// is selected and the SSE2 one otherwise; there are no phase streams for the table kernel.
+// They give exactly the vertices DeformMeshVertices_Scalar and _SSE2 give from streams.
+void DeformVertexArray_Scalar(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+#if PLUGIN_KERNELS_X86
+void DeformVertexArray_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision);
+#endif
+
+// The copy kernels of CopyMeshSource: vertices [vertexBegin, vertexEnd) of the source arrays
+// into the same vertices of dst, whose streams already have the full size. The SSE2 one
+// deinterleaves with shuffles and takes the phases' sines from PluginSin_SSE2 (exact
+// precision, so within kPluginMathExactMaxError of the scalar kernel's libm values); every
+// other stream comes out identical.
+void CopyMeshSource_Scalar(MeshVertexStreams& dst, int vertexBegin, int vertexEnd, const float* positions, const float* normals, const float* uvs);
+#if PLUGIN_KERNELS_X86
+void CopyMeshSource_SSE2(MeshVertexStreams& dst, int vertexBegin, int vertexEnd, const float* positions, const float* normals, const float* uvs);
+#endif
+
+// The scales of the phase streams that make up the waves of a frame:
+// 0.4 sin(a + t) + 0.3 sin(b - t) = sinPhaseX * sinX + cosPhaseX * cosX + sinPhaseZ * sinZ + cosPhaseZ * cosZ
+struct VertexWaveScales
+{
+	float sinX, cosX, sinZ, cosZ;
+};
+
+inline float DeformTablesY(const MeshVertexStreams& src, int i, const VertexWaveScales& scales)
+{
+	return src.posY[i] + src.sinPhaseX[i] * scales.sinX + src.cosPhaseX[i] * scales.cosX + src.sinPhaseZ[i] * scales.sinZ + src.cosPhaseZ[i] * scales.cosZ;
+}
+
+#if PLUGIN_KERNELS_X86
+// The table kernel four vertices at a time; it gives the same vertices as DeformTablesY.
+void DeformMeshVerticesTables_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	const VertexWaveScales& scales);
+#endif
+
+// Writes vertex i of the source with the given deformed y; the color is left alone
+inline void StoreMeshVertex(const MeshVertexStreams& src, int i, float y, MeshVertex& d)
+{
+	d.pos[0] = src.posX[i];
+	d.pos[1] = y;
+	d.pos[2] = src.posZ[i];
+	d.normal[0] = src.normalX[i];
+	d.normal[1] = src.normalY[i];
+	d.normal[2] = src.normalZ[i];
+	d.uv[0] = src.u[i];
+	d.uv[1] = src.v[i];
+}
+
+// The deformed y of a vertex at (x, y, z) in the reference kernel; t is time * 3.
+template<PluginMathPrecision Precision>
+inline float DeformWaveY(float x, float y, float z, float t)
+{
+	return y + PluginSin<Precision>(x * 1.1f + t) * 0.4f + PluginSin<Precision>(z * 0.9f - t) * 0.3f;
+}
+
+// One vertex of the reference kernel
+template<PluginMathPrecision Precision>
+inline void DeformMeshVertex(const MeshVertexStreams& src, int i, MeshVertex& d, float t)
+{
+	StoreMeshVertex(src, i, DeformWaveY<Precision>(src.posX[i], src.posY[i], src.posZ[i], t), d);
+}
+
+
+// Drops the radial fields the table kernel keeps per texture size. They are rebuilt on
+// the next fill; called when the graphics device goes away. Fills in flight, e.g. on the
+// pipeline thread, keep theirs until they are done.
+void ReleasePlasmaTables();
+
+// One pixel of the reference kernel; rowTerm is the part that only depends on y and t,
+// 127 + 127 * sin(y / 5 - t). The SIMD kernels use it for the pixels left over at row ends.
+template<PluginMathPrecision Precision>
+inline unsigned char PlasmaPixelValue(int x, int y, float t, float rowTerm)
+{
+	// Simple "plasma effect": several combined sine waves
+	return (unsigned char)(int(
+		(127.0f + (127.0f * PluginSin<Precision>(x / 7.0f + t))) +
+		rowTerm +
+		(127.0f + (127.0f * PluginSin<Precision>((x + y) / 6.0f - t))) +
+		(127.0f + (127.0f * PluginSin<Precision>(sqrtf(float(x*x + y*y)) / 4.0f - t)))
+		) / 4);
+}
+
+
+// One row of the table kernel: the per-frame tables offset to that row, and the scales of
+// sin(d) and cos(d) that make up the radial term.
+struct PlasmaTablesRow
+{
+	const float* columns;		// indexed by x
+	const float* diagonals;		// indexed by x, already offset by y
+	const float* sinPhase;		// row y of the cached radial field
+	const float* cosPhase;
+	float rowTerm;
+	float sinScale, cosScale;
+};
+
+inline unsigned int PlasmaTablesPixelValue(const PlasmaTablesRow& row, int x)
+{
+	// 127 * sin(d - t) = sin(d) * 127cos(t) - cos(d) * 127sin(t)
+	const float radialTerm = 127.0f + (row.sinPhase[x] * row.sinScale + row.cosPhase[x] * row.cosScale);
+	// Every term is in [0, 254], so truncating sum / 4 is the same as int(sum) / 4
+	return (unsigned int)int((row.columns[x] + row.rowTerm + row.diagonals[x] + radialTerm) * 0.25f);
+}
+
+// Same value in every channel of the pixel; RGBA8 as one 32 bit store
+inline void StorePlasmaPixel(unsigned char* dst, unsigned int value, int bytesPerPixel)
+{
+	if (bytesPerPixel == 4)
+	{
+		const unsigned int pixel = value * 0x01010101u;
+		memcpy(dst, &pixel, 4);
+		return;
+	}
+	dst[0] = (unsigned char)value;
+	if (bytesPerPixel == 2)
+		dst[1] = (unsigned char)value;
+}
+
+#if PLUGIN_KERNELS_X86
+void WritePlasmaTablesRow_SSE2(unsigned char* dst, int width, int bytesPerPixel, const PlasmaTablesRow& row, bool streamingStores);
+#endif
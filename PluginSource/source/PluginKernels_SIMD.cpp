@@ -0,0 +1,752 @@
+#include "PluginKernels.h"
+
+// SSE2 and AVX2 versions of the plasma and vertex kernels, see PluginKernels.h. Both are built into
+// every x86 binary (with function level target attributes on GCC/Clang, so no special
+// compiler flags are needed) and picked at runtime by what the CPU supports.
+
+#if PLUGIN_KERNELS_X86
+
+#include "PluginMath_SIMD.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#if !defined(_MSC_VER) || defined(__clang__)
+#	include <cpuid.h>
+#endif
+
+
+// --------------------------------------------------------------------------
+// CPU feature detection
+
+static void CpuId(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int r[4];
+	__cpuidex(r, int(leaf), int(subleaf));
+	for (int i = 0; i < 4; ++i)
+		regs[i] = (unsigned int)r[i];
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+
+// Which register states the OS saves on context switches
+static unsigned long long XGetBV()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+
+bool CpuSupportsSSE2()
+{
+	unsigned int regs[4];
+	CpuId(1, 0, regs);
+	return (regs[3] & (1u << 26)) != 0;
+}
+
+
+bool CpuSupportsAVX2()
+{
+	unsigned int regs[4];
+	CpuId(0, 0, regs);
+	if (regs[0] < 7)
+		return false;
+
+	CpuId(1, 0, regs);
+	const bool fma = (regs[2] & (1u << 12)) != 0;
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool avx = (regs[2] & (1u << 28)) != 0;
+	if (!fma || !osxsave || !avx)
+		return false;
+	if ((XGetBV() & 6) != 6)	// XMM and YMM state
+		return false;
+
+	CpuId(7, 0, regs);
+	return (regs[1] & (1u << 5)) != 0;
+}
+
+
+// SSE2 has no 32 bit multiply (pmulld is SSE4.1): multiply the even and odd lanes separately
+PLUGIN_TARGET_SSE2 static inline __m128i MulLo32_SSE2(__m128i a, __m128i b)
+{
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+
+// --------------------------------------------------------------------------
+// Streaming stores. Texture memory that is write-combined (a mapped upload heap or staging
+// buffer, see RenderAPI::IsTextureMemoryWriteCombined) is best written in whole 64 byte cache
+// lines with non-temporal stores: partial lines turn into several small bus writes, and
+// regular stores to cached memory first read the line they write into. The kernels below
+// do that when asked to; they compute four 16 byte vectors (or two 32 byte ones) of a line
+// before storing any of it, write the unaligned start and end of each row with regular
+// stores, and end every call with an sfence so the data is visible to the GPU copy that
+// EndModifyTexture records.
+
+static const int kCacheLineSize = 64;
+
+// Pixels to write with regular stores before 'row' reaches a cache line boundary, or -1 if
+// it never does (rows that aren't aligned to a whole pixel).
+static inline int StreamingHeadPixels(const unsigned char* row, int width, int bytesPerPixel)
+{
+	const size_t address = size_t(row);
+	if (address % bytesPerPixel)
+		return -1;
+	const int head = int((kCacheLineSize - (address & (kCacheLineSize - 1))) & (kCacheLineSize - 1)) / bytesPerPixel;
+	return head < width ? head : width;
+}
+
+
+PLUGIN_TARGET_SSE2 void StreamingStoreFence()
+{
+	_mm_sfence();
+}
+
+
+// --------------------------------------------------------------------------
+// Packing pixel values (one per 32 bit lane, 0..255) into the texture format: replicated
+// into all four bytes for RGBA8/BGRA8, into both bytes for RG8, one byte for R8. One output
+// vector takes one, two or four input vectors.
+
+PLUGIN_TARGET_SSE2 static inline __m128i Replicate4_SSE2(__m128i v)
+{
+	const __m128i v2 = _mm_or_si128(v, _mm_slli_epi32(v, 8));
+	return _mm_or_si128(v2, _mm_slli_epi32(v2, 16));
+}
+
+// Row is one of the PlasmaRow types below; Values(x) returns the values of the pixels from x on,
+// one vector's worth
+template<int BytesPerPixel, class Row>
+PLUGIN_TARGET_SSE2 static inline __m128i PackPixels_SSE2(const Row& row, int x)
+{
+	if (BytesPerPixel == 4)
+		return Replicate4_SSE2(row.Values(x));
+	if (BytesPerPixel == 2)
+	{
+		const __m128i v16 = _mm_packs_epi32(row.Values(x), row.Values(x + 4));
+		return _mm_or_si128(v16, _mm_slli_epi16(v16, 8));
+	}
+	const __m128i lo = _mm_packs_epi32(row.Values(x), row.Values(x + 4));
+	const __m128i hi = _mm_packs_epi32(row.Values(x + 8), row.Values(x + 12));
+	return _mm_packus_epi16(lo, hi);
+}
+
+
+// One row: regular stores, or cache line sized groups of streaming stores between the
+// unaligned start and end of the row. Row::WriteReference writes pixels one at a time.
+template<int BytesPerPixel, class Row>
+PLUGIN_TARGET_SSE2 static void WriteRow_SSE2(unsigned char* dst, int width, const Row& row, bool streamingStores)
+{
+	const int pixelsPerVector = 16 / BytesPerPixel;
+	int x = 0;
+	const int head = streamingStores ? StreamingHeadPixels(dst, width, BytesPerPixel) : -1;
+	if (head >= 0)
+	{
+		row.WriteReference(dst, 0, head, BytesPerPixel);
+		for (x = head; x + 4 * pixelsPerVector <= width; x += 4 * pixelsPerVector)
+		{
+			const __m128i p0 = PackPixels_SSE2<BytesPerPixel>(row, x);
+			const __m128i p1 = PackPixels_SSE2<BytesPerPixel>(row, x + pixelsPerVector);
+			const __m128i p2 = PackPixels_SSE2<BytesPerPixel>(row, x + 2 * pixelsPerVector);
+			const __m128i p3 = PackPixels_SSE2<BytesPerPixel>(row, x + 3 * pixelsPerVector);
+			__m128i* line = (__m128i*)(dst + x * BytesPerPixel);
+			_mm_stream_si128(line + 0, p0);
+			_mm_stream_si128(line + 1, p1);
+			_mm_stream_si128(line + 2, p2);
+			_mm_stream_si128(line + 3, p3);
+		}
+	}
+	for (; x + pixelsPerVector <= width; x += pixelsPerVector)
+		_mm_storeu_si128((__m128i*)(dst + x * BytesPerPixel), PackPixels_SSE2<BytesPerPixel>(row, x));
+	row.WriteReference(dst + x * BytesPerPixel, x, width - x, BytesPerPixel);
+}
+
+template<class Row>
+PLUGIN_TARGET_SSE2 static void WriteRow_SSE2(unsigned char* dst, int width, int bytesPerPixel, const Row& row, bool streamingStores)
+{
+	switch (bytesPerPixel)
+	{
+	case 1: WriteRow_SSE2<1>(dst, width, row, streamingStores); break;
+	case 2: WriteRow_SSE2<2>(dst, width, row, streamingStores); break;
+	default: WriteRow_SSE2<4>(dst, width, row, streamingStores); break;
+	}
+}
+
+
+PLUGIN_TARGET_AVX2 static inline __m256i Replicate4_AVX2(__m256i v)
+{
+	const __m256i v2 = _mm256_or_si256(v, _mm256_slli_epi32(v, 8));
+	return _mm256_or_si256(v2, _mm256_slli_epi32(v2, 16));
+}
+
+// The AVX2 packs work within 128 bit lanes, the permutes put the pixels back in order
+template<int BytesPerPixel, class Row>
+PLUGIN_TARGET_AVX2 static inline __m256i PackPixels_AVX2(const Row& row, int x)
+{
+	if (BytesPerPixel == 4)
+		return Replicate4_AVX2(row.Values(x));
+	if (BytesPerPixel == 2)
+	{
+		const __m256i v16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(row.Values(x), row.Values(x + 8)), _MM_SHUFFLE(3, 1, 2, 0));
+		return _mm256_or_si256(v16, _mm256_slli_epi16(v16, 8));
+	}
+	const __m256i lo = _mm256_packs_epi32(row.Values(x), row.Values(x + 8));
+	const __m256i hi = _mm256_packs_epi32(row.Values(x + 16), row.Values(x + 24));
+	return _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+
+template<int BytesPerPixel, class Row>
+PLUGIN_TARGET_AVX2 static void WriteRow_AVX2(unsigned char* dst, int width, const Row& row, bool streamingStores)
+{
+	const int pixelsPerVector = 32 / BytesPerPixel;
+	int x = 0;
+	const int head = streamingStores ? StreamingHeadPixels(dst, width, BytesPerPixel) : -1;
+	if (head >= 0)
+	{
+		row.WriteReference(dst, 0, head, BytesPerPixel);
+		for (x = head; x + 2 * pixelsPerVector <= width; x += 2 * pixelsPerVector)
+		{
+			const __m256i p0 = PackPixels_AVX2<BytesPerPixel>(row, x);
+			const __m256i p1 = PackPixels_AVX2<BytesPerPixel>(row, x + pixelsPerVector);
+			__m256i* line = (__m256i*)(dst + x * BytesPerPixel);
+			_mm256_stream_si256(line + 0, p0);
+			_mm256_stream_si256(line + 1, p1);
+		}
+	}
+	for (; x + pixelsPerVector <= width; x += pixelsPerVector)
+		_mm256_storeu_si256((__m256i*)(dst + x * BytesPerPixel), PackPixels_AVX2<BytesPerPixel>(row, x));
+	row.WriteReference(dst + x * BytesPerPixel, x, width - x, BytesPerPixel);
+}
+
+template<class Row>
+PLUGIN_TARGET_AVX2 static void WriteRow_AVX2(unsigned char* dst, int width, int bytesPerPixel, const Row& row, bool streamingStores)
+{
+	switch (bytesPerPixel)
+	{
+	case 1: WriteRow_AVX2<1>(dst, width, row, streamingStores); break;
+	case 2: WriteRow_AVX2<2>(dst, width, row, streamingStores); break;
+	default: WriteRow_AVX2<4>(dst, width, row, streamingStores); break;
+	}
+}
+
+
+// --------------------------------------------------------------------------
+// The kernels follow the reference operation for operation (same divisions, same order of
+// the additions, the integer x*x + y*y), so only the sines differ.
+
+// Reference pixels [x, x + count) of row y, written to dst
+template<PluginMathPrecision Precision>
+static void WritePlasmaPixels(unsigned char* dst, int x, int count, int y, float t, float rowTerm, int bytesPerPixel)
+{
+	for (int end = x + count; x < end; ++x)
+	{
+		StorePlasmaPixel(dst, PlasmaPixelValue<Precision>(x, y, t, rowTerm), bytesPerPixel);
+		dst += bytesPerPixel;
+	}
+}
+
+
+template<PluginMathPrecision Precision>
+struct PlasmaRow_SSE2
+{
+	__m128 tv, c127, rowTermV;
+	__m128i lane, yv, yy;
+	float t, rowTerm;
+	int x0, y;				// image position of the target's first column, of the row
+
+	PLUGIN_TARGET_SSE2 __m128i Values(int x) const
+	{
+		const __m128i xi = _mm_add_epi32(_mm_set1_epi32(x), lane);
+		const __m128 xf = _mm_cvtepi32_ps(xi);
+		const __m128 xyf = _mm_cvtepi32_ps(_mm_add_epi32(xi, yv));
+		const __m128 distance = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_add_epi32(MulLo32_SSE2(xi, xi), yy)));
+
+		const __m128 s0 = PluginSin_SSE2<Precision>(_mm_add_ps(_mm_div_ps(xf, _mm_set1_ps(7.0f)), tv));
+		const __m128 s2 = PluginSin_SSE2<Precision>(_mm_sub_ps(_mm_div_ps(xyf, _mm_set1_ps(6.0f)), tv));
+		const __m128 s3 = PluginSin_SSE2<Precision>(_mm_sub_ps(_mm_div_ps(distance, _mm_set1_ps(4.0f)), tv));
+
+		__m128 sum = _mm_add_ps(c127, _mm_mul_ps(c127, s0));
+		sum = _mm_add_ps(sum, rowTermV);
+		sum = _mm_add_ps(sum, _mm_add_ps(c127, _mm_mul_ps(c127, s2)));
+		sum = _mm_add_ps(sum, _mm_add_ps(c127, _mm_mul_ps(c127, s3)));
+
+		// Truncate like int() and divide by 4
+		return _mm_srli_epi32(_mm_cvttps_epi32(sum), 2);
+	}
+
+	void WriteReference(unsigned char* dst, int x, int count, int bytesPerPixel) const
+	{
+		WritePlasmaPixels<Precision>(dst, x0 + x, count, y, t, rowTerm, bytesPerPixel);
+	}
+};
+
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static void FillPlasmaRows_SSE2(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	const float t = time * 4.0f;
+	PlasmaRow_SSE2<Precision> row;
+	row.t = t;
+	row.tv = _mm_set1_ps(t);
+	row.c127 = _mm_set1_ps(127.0f);
+	row.x0 = target.x;
+	row.lane = _mm_add_epi32(_mm_set_epi32(3, 2, 1, 0), _mm_set1_epi32(target.x));
+
+	unsigned char* dst = target.pixels + size_t(rowBegin) * target.rowPitch;
+	for (int y = target.y + rowBegin; y < target.y + rowEnd; ++y)
+	{
+		row.y = y;
+		row.rowTerm = 127.0f + (127.0f * PluginSin<Precision>(y / 5.0f - t));
+		row.rowTermV = _mm_set1_ps(row.rowTerm);
+		row.yv = _mm_set1_epi32(y);
+		row.yy = _mm_set1_epi32(y * y);
+		WriteRow_SSE2(dst, target.width, target.bytesPerPixel, row, target.streamingStores);
+		dst += target.rowPitch;
+	}
+	if (target.streamingStores)
+		_mm_sfence();
+}
+
+PLUGIN_TARGET_SSE2 void FillPlasmaPixels_SSE2(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	if (target.mathPrecision == kPluginMathPrecision_Fast)
+		FillPlasmaRows_SSE2<kPluginMathPrecision_Fast>(target, time, rowBegin, rowEnd);
+	else
+		FillPlasmaRows_SSE2<kPluginMathPrecision_Exact>(target, time, rowBegin, rowEnd);
+}
+
+
+template<PluginMathPrecision Precision>
+struct PlasmaRow_AVX2
+{
+	__m256 tv, c127, rowTermV;
+	__m256i lane, yv, yy;
+	float t, rowTerm;
+	int x0, y;				// image position of the target's first column, of the row
+
+	PLUGIN_TARGET_AVX2 __m256i Values(int x) const
+	{
+		const __m256i xi = _mm256_add_epi32(_mm256_set1_epi32(x), lane);
+		const __m256 xf = _mm256_cvtepi32_ps(xi);
+		const __m256 xyf = _mm256_cvtepi32_ps(_mm256_add_epi32(xi, yv));
+		const __m256 distance = _mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_mullo_epi32(xi, xi), yy)));
+
+		const __m256 s0 = PluginSin_AVX2<Precision>(_mm256_add_ps(_mm256_div_ps(xf, _mm256_set1_ps(7.0f)), tv));
+		const __m256 s2 = PluginSin_AVX2<Precision>(_mm256_sub_ps(_mm256_div_ps(xyf, _mm256_set1_ps(6.0f)), tv));
+		const __m256 s3 = PluginSin_AVX2<Precision>(_mm256_sub_ps(_mm256_div_ps(distance, _mm256_set1_ps(4.0f)), tv));
+
+		__m256 sum = _mm256_fmadd_ps(c127, s0, c127);
+		sum = _mm256_add_ps(sum, rowTermV);
+		sum = _mm256_add_ps(sum, _mm256_fmadd_ps(c127, s2, c127));
+		sum = _mm256_add_ps(sum, _mm256_fmadd_ps(c127, s3, c127));
+
+		return _mm256_srli_epi32(_mm256_cvttps_epi32(sum), 2);
+	}
+
+	void WriteReference(unsigned char* dst, int x, int count, int bytesPerPixel) const
+	{
+		WritePlasmaPixels<Precision>(dst, x0 + x, count, y, t, rowTerm, bytesPerPixel);
+	}
+};
+
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_AVX2 static void FillPlasmaRows_AVX2(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	const float t = time * 4.0f;
+	PlasmaRow_AVX2<Precision> row;
+	row.t = t;
+	row.tv = _mm256_set1_ps(t);
+	row.c127 = _mm256_set1_ps(127.0f);
+	row.x0 = target.x;
+	row.lane = _mm256_add_epi32(_mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0), _mm256_set1_epi32(target.x));
+
+	unsigned char* dst = target.pixels + size_t(rowBegin) * target.rowPitch;
+	for (int y = target.y + rowBegin; y < target.y + rowEnd; ++y)
+	{
+		row.y = y;
+		row.rowTerm = 127.0f + (127.0f * PluginSin<Precision>(y / 5.0f - t));
+		row.rowTermV = _mm256_set1_ps(row.rowTerm);
+		row.yv = _mm256_set1_epi32(y);
+		row.yy = _mm256_set1_epi32(y * y);
+		WriteRow_AVX2(dst, target.width, target.bytesPerPixel, row, target.streamingStores);
+		dst += target.rowPitch;
+	}
+	if (target.streamingStores)
+		_mm_sfence();
+}
+
+PLUGIN_TARGET_AVX2 void FillPlasmaPixels_AVX2(const PlasmaTarget& target, float time, int rowBegin, int rowEnd)
+{
+	if (target.mathPrecision == kPluginMathPrecision_Fast)
+		FillPlasmaRows_AVX2<kPluginMathPrecision_Fast>(target, time, rowBegin, rowEnd);
+	else
+		FillPlasmaRows_AVX2<kPluginMathPrecision_Exact>(target, time, rowBegin, rowEnd);
+}
+
+
+// One row of the table kernel (see FillPlasmaPixels_Tables): the same operations as
+// PlasmaTablesPixelValue in the same order, four pixels at a time, so the output is identical.
+struct PlasmaTablesRow_SSE2
+{
+	const PlasmaTablesRow* row;
+	__m128 c127, quarter, rowTermV, sinScaleV, cosScaleV;
+
+	PLUGIN_TARGET_SSE2 __m128i Values(int x) const
+	{
+		const __m128 radialTerm = _mm_add_ps(c127,
+			_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(row->sinPhase + x), sinScaleV), _mm_mul_ps(_mm_loadu_ps(row->cosPhase + x), cosScaleV)));
+		__m128 sum = _mm_add_ps(_mm_loadu_ps(row->columns + x), rowTermV);
+		sum = _mm_add_ps(sum, _mm_loadu_ps(row->diagonals + x));
+		sum = _mm_add_ps(sum, radialTerm);
+		return _mm_cvttps_epi32(_mm_mul_ps(sum, quarter));
+	}
+
+	void WriteReference(unsigned char* dst, int x, int count, int bytesPerPixel) const
+	{
+		for (int end = x + count; x < end; ++x)
+		{
+			StorePlasmaPixel(dst, PlasmaTablesPixelValue(*row, x), bytesPerPixel);
+			dst += bytesPerPixel;
+		}
+	}
+};
+
+
+PLUGIN_TARGET_SSE2 void WritePlasmaTablesRow_SSE2(unsigned char* dst, int width, int bytesPerPixel, const PlasmaTablesRow& row, bool streamingStores)
+{
+	PlasmaTablesRow_SSE2 rowSSE2;
+	rowSSE2.row = &row;
+	rowSSE2.c127 = _mm_set1_ps(127.0f);
+	rowSSE2.quarter = _mm_set1_ps(0.25f);
+	rowSSE2.rowTermV = _mm_set1_ps(row.rowTerm);
+	rowSSE2.sinScaleV = _mm_set1_ps(row.sinScale);
+	rowSSE2.cosScaleV = _mm_set1_ps(row.cosScale);
+	WriteRow_SSE2(dst, width, bytesPerPixel, rowSSE2, streamingStores);
+}
+
+
+// --------------------------------------------------------------------------
+// Vertex kernels
+
+// Scatters 4 consecutive deformed vertices into MeshVertex layout: position and normal x as
+// one 16 byte store, normal y and z, then uv, as 8 bytes each. The colors are left alone.
+PLUGIN_TARGET_SSE2 static inline void StoreMeshVertices4_SSE2(char* dst, int dstStride, __m128 x, __m128 y, __m128 z, __m128 nx,
+	__m128 ny, __m128 nz, __m128 u, __m128 v)
+{
+	const size_t normalYOffset = offsetof(MeshVertex, normal) + sizeof(float);
+	const size_t uvOffset = offsetof(MeshVertex, uv);
+	_MM_TRANSPOSE4_PS(x, y, z, nx);
+	const __m128 normals01 = _mm_unpacklo_ps(ny, nz), normals23 = _mm_unpackhi_ps(ny, nz);
+	const __m128 uvs01 = _mm_unpacklo_ps(u, v), uvs23 = _mm_unpackhi_ps(u, v);
+
+	_mm_storeu_ps((float*)dst, x);
+	_mm_storel_pi((__m64*)(dst + normalYOffset), normals01);
+	_mm_storel_pi((__m64*)(dst + uvOffset), uvs01);
+	dst += dstStride;
+	_mm_storeu_ps((float*)dst, y);
+	_mm_storeh_pi((__m64*)(dst + normalYOffset), normals01);
+	_mm_storeh_pi((__m64*)(dst + uvOffset), uvs01);
+	dst += dstStride;
+	_mm_storeu_ps((float*)dst, z);
+	_mm_storel_pi((__m64*)(dst + normalYOffset), normals23);
+	_mm_storel_pi((__m64*)(dst + uvOffset), uvs23);
+	dst += dstStride;
+	_mm_storeu_ps((float*)dst, nx);
+	_mm_storeh_pi((__m64*)(dst + normalYOffset), normals23);
+	_mm_storeh_pi((__m64*)(dst + uvOffset), uvs23);
+}
+
+// The source streams of vertices [i, i + 4) that pass through unchanged, and the deformed y
+PLUGIN_TARGET_SSE2 static inline void StoreMeshVertices4_SSE2(char* dst, int dstStride, const MeshVertexStreams& src, int i, __m128 y)
+{
+	StoreMeshVertices4_SSE2(dst, dstStride, _mm_loadu_ps(src.posX.data() + i), y, _mm_loadu_ps(src.posZ.data() + i),
+		_mm_loadu_ps(src.normalX.data() + i), _mm_loadu_ps(src.normalY.data() + i), _mm_loadu_ps(src.normalZ.data() + i),
+		_mm_loadu_ps(src.u.data() + i), _mm_loadu_ps(src.v.data() + i));
+}
+
+
+// The vertices after the last full iteration get their y from the same SIMD sines, in a
+// partly filled register, so that every vertex comes out the same wherever a range starts
+// or ends.
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static inline __m128 DeformY_SSE2(__m128 xv, __m128 yv, __m128 zv, __m128 tv)
+{
+	yv = _mm_add_ps(yv, _mm_mul_ps(PluginSin_SSE2<Precision>(_mm_add_ps(_mm_mul_ps(xv, _mm_set1_ps(1.1f)), tv)), _mm_set1_ps(0.4f)));
+	yv = _mm_add_ps(yv, _mm_mul_ps(PluginSin_SSE2<Precision>(_mm_sub_ps(_mm_mul_ps(zv, _mm_set1_ps(0.9f)), tv)), _mm_set1_ps(0.3f)));
+	return yv;
+}
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static inline __m128 DeformY_SSE2(const float* x, const float* y, const float* z, __m128 tv)
+{
+	return DeformY_SSE2<Precision>(_mm_loadu_ps(x), _mm_loadu_ps(y), _mm_loadu_ps(z), tv);
+}
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static void DeformVertices_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride, float time)
+{
+	const __m128 tv = _mm_set1_ps(time * 3.0f);
+
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	int i = vertexBegin;
+	for (; i + 4 <= vertexEnd; i += 4)
+	{
+		const __m128 y = DeformY_SSE2<Precision>(src.posX.data() + i, src.posY.data() + i, src.posZ.data() + i, tv);
+		StoreMeshVertices4_SSE2(bufferPtr, dstStride, src, i, y);
+		bufferPtr += 4 * size_t(dstStride);
+	}
+	if (i < vertexEnd)
+	{
+		const int count = vertexEnd - i;
+		float x[4] = {}, y[4] = {}, z[4] = {};
+		memcpy(x, src.posX.data() + i, count * sizeof(float));
+		memcpy(y, src.posY.data() + i, count * sizeof(float));
+		memcpy(z, src.posZ.data() + i, count * sizeof(float));
+		_mm_storeu_ps(y, DeformY_SSE2<Precision>(x, y, z, tv));
+		for (int k = 0; k < count; ++k)
+		{
+			StoreMeshVertex(src, i + k, y[k], *(MeshVertex*)bufferPtr);
+			bufferPtr += dstStride;
+		}
+	}
+}
+
+PLUGIN_TARGET_SSE2 void DeformMeshVertices_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision)
+{
+	if (precision == kPluginMathPrecision_Fast)
+		DeformVertices_SSE2<kPluginMathPrecision_Fast>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+	else
+		DeformVertices_SSE2<kPluginMathPrecision_Exact>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+}
+
+
+// Four MeshSourceVertex structs in, four MeshVertex out: the first 16 bytes of each (position
+// and normal x) are transposed so that the sines get x, y and z in registers, and back; the
+// other 16 (normal y and z, uv) go straight to their places. The colors are left alone.
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static inline void DeformVertexArray4_SSE2(char* dst, int dstStride, const MeshSourceVertex* src, __m128 tv)
+{
+	const size_t normalYOffset = offsetof(MeshVertex, normal) + sizeof(float);
+	const size_t uvOffset = offsetof(MeshVertex, uv);
+	__m128 v0 = _mm_loadu_ps(src[0].pos), v1 = _mm_loadu_ps(src[1].pos), v2 = _mm_loadu_ps(src[2].pos), v3 = _mm_loadu_ps(src[3].pos);
+	_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+	v1 = DeformY_SSE2<Precision>(v0, v1, v2, tv);
+	_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+
+	const __m128 vs[4] = { v0, v1, v2, v3 };
+	for (int k = 0; k < 4; ++k)
+	{
+		const __m128 rest = _mm_loadu_ps(src[k].normal + 1);
+		_mm_storeu_ps((float*)dst, vs[k]);
+		_mm_storel_pi((__m64*)(dst + normalYOffset), rest);
+		_mm_storeh_pi((__m64*)(dst + uvOffset), rest);
+		dst += dstStride;
+	}
+}
+
+// The last vertices go through a zero padded group of four, into a temporary, like the
+// stream kernels' tails
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static void DeformVertexArray_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride, float time)
+{
+	const __m128 tv = _mm_set1_ps(time * 3.0f);
+
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	int i = vertexBegin;
+	for (; i + 4 <= vertexEnd; i += 4)
+	{
+		DeformVertexArray4_SSE2<Precision>(bufferPtr, dstStride, src.vertexArray + i, tv);
+		bufferPtr += 4 * size_t(dstStride);
+	}
+	if (i < vertexEnd)
+	{
+		const int count = vertexEnd - i;
+		MeshSourceVertex tail[4] = {};
+		MeshVertex deformed[4];
+		memcpy(tail, src.vertexArray + i, count * sizeof(MeshSourceVertex));
+		DeformVertexArray4_SSE2<Precision>((char*)deformed, sizeof(MeshVertex), tail, tv);
+		for (int k = 0; k < count; ++k)
+		{
+			MeshVertex& d = *(MeshVertex*)bufferPtr;
+			memcpy(d.pos, deformed[k].pos, sizeof(d.pos) + sizeof(d.normal));
+			memcpy(d.uv, deformed[k].uv, sizeof(d.uv));
+			bufferPtr += dstStride;
+		}
+	}
+}
+
+PLUGIN_TARGET_SSE2 void DeformVertexArray_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision)
+{
+	if (precision == kPluginMathPrecision_Fast)
+		DeformVertexArray_SSE2<kPluginMathPrecision_Fast>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+	else
+		DeformVertexArray_SSE2<kPluginMathPrecision_Exact>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+}
+
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_AVX2 static inline __m256 DeformY_AVX2(const float* x, const float* y, const float* z, __m256 tv)
+{
+	const __m256 xv = _mm256_loadu_ps(x), zv = _mm256_loadu_ps(z);
+	__m256 yv = _mm256_loadu_ps(y);
+	yv = _mm256_fmadd_ps(PluginSin_AVX2<Precision>(_mm256_fmadd_ps(xv, _mm256_set1_ps(1.1f), tv)), _mm256_set1_ps(0.4f), yv);
+	yv = _mm256_fmadd_ps(PluginSin_AVX2<Precision>(_mm256_fmsub_ps(zv, _mm256_set1_ps(0.9f), tv)), _mm256_set1_ps(0.3f), yv);
+	return yv;
+}
+
+// Eight vertices per iteration; the sines take the whole width, the scatter goes out as two
+// halves of four, which is as wide as the 16 byte position stores get
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_AVX2 static void DeformVertices_AVX2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride, float time)
+{
+	const __m256 tv = _mm256_set1_ps(time * 3.0f);
+
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	int i = vertexBegin;
+	for (; i + 8 <= vertexEnd; i += 8)
+	{
+		const __m256 y = DeformY_AVX2<Precision>(src.posX.data() + i, src.posY.data() + i, src.posZ.data() + i, tv);
+		StoreMeshVertices4_SSE2(bufferPtr, dstStride, src, i, _mm256_castps256_ps128(y));
+		StoreMeshVertices4_SSE2(bufferPtr + 4 * size_t(dstStride), dstStride, src, i + 4, _mm256_extractf128_ps(y, 1));
+		bufferPtr += 8 * size_t(dstStride);
+	}
+	if (i < vertexEnd)
+	{
+		const int count = vertexEnd - i;
+		float x[8] = {}, y[8] = {}, z[8] = {};
+		memcpy(x, src.posX.data() + i, count * sizeof(float));
+		memcpy(y, src.posY.data() + i, count * sizeof(float));
+		memcpy(z, src.posZ.data() + i, count * sizeof(float));
+		_mm256_storeu_ps(y, DeformY_AVX2<Precision>(x, y, z, tv));
+		for (int k = 0; k < count; ++k)
+		{
+			StoreMeshVertex(src, i + k, y[k], *(MeshVertex*)bufferPtr);
+			bufferPtr += dstStride;
+		}
+	}
+}
+
+PLUGIN_TARGET_AVX2 void DeformMeshVertices_AVX2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	float time, PluginMathPrecision precision)
+{
+	if (precision == kPluginMathPrecision_Fast)
+		DeformVertices_AVX2<kPluginMathPrecision_Fast>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+	else
+		DeformVertices_AVX2<kPluginMathPrecision_Exact>(src, vertexBegin, vertexEnd, dst, dstStride, time);
+}
+
+
+// Plain multiplies and adds in the order of DeformTablesY, so the scalar loop for the last
+// vertices gives the same values
+PLUGIN_TARGET_SSE2 void DeformMeshVerticesTables_SSE2(const MeshVertexStreams& src, int vertexBegin, int vertexEnd, void* dst, int dstStride,
+	const VertexWaveScales& scales)
+{
+	const __m128 sinX = _mm_set1_ps(scales.sinX), cosX = _mm_set1_ps(scales.cosX);
+	const __m128 sinZ = _mm_set1_ps(scales.sinZ), cosZ = _mm_set1_ps(scales.cosZ);
+
+	char* bufferPtr = (char*)dst + size_t(vertexBegin) * dstStride;
+	int i = vertexBegin;
+	for (; i + 4 <= vertexEnd; i += 4)
+	{
+		__m128 y = _mm_loadu_ps(src.posY.data() + i);
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(src.sinPhaseX.data() + i), sinX));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(src.cosPhaseX.data() + i), cosX));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(src.sinPhaseZ.data() + i), sinZ));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(src.cosPhaseZ.data() + i), cosZ));
+		StoreMeshVertices4_SSE2(bufferPtr, dstStride, src, i, y);
+		bufferPtr += 4 * size_t(dstStride);
+	}
+	for (; i < vertexEnd; ++i)
+	{
+		StoreMeshVertex(src, i, DeformTablesY(src, i, scales), *(MeshVertex*)bufferPtr);
+		bufferPtr += dstStride;
+	}
+}
+
+// --------------------------------------------------------------------------
+// Source mesh copy
+
+// x, y and z of four float3 vectors loaded as three registers:
+// (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3)
+PLUGIN_TARGET_SSE2 static inline void Deinterleave3_SSE2(const float* src, __m128& x, __m128& y, __m128& z)
+{
+	const __m128 p0 = _mm_loadu_ps(src), p1 = _mm_loadu_ps(src + 4), p2 = _mm_loadu_ps(src + 8);
+	const __m128 x0x1y1z1 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 0, 3, 0));
+	const __m128 x2y2x3y3 = _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(2, 1, 3, 2));
+	x = _mm_shuffle_ps(x0x1y1z1, x2y2x3y3, _MM_SHUFFLE(2, 0, 1, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(p0, x0x1y1z1, _MM_SHUFFLE(2, 2, 1, 1)), x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(p0, p1, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// Vertices [i, i + 4) of the source arrays, which point at vertex i, into the streams, given
+// in the order of MeshVertexStreams::GetStreams
+PLUGIN_TARGET_SSE2 static inline void CopyMeshSource4_SSE2(float* const* streams, size_t i, const float* positions, const float* normals, const float* uvs)
+{
+	__m128 x, y, z;
+	Deinterleave3_SSE2(positions, x, y, z);
+	_mm_storeu_ps(streams[0] + i, x);
+	_mm_storeu_ps(streams[1] + i, y);
+	_mm_storeu_ps(streams[2] + i, z);
+	const __m128 phaseX = _mm_mul_ps(x, _mm_set1_ps(1.1f)), phaseZ = _mm_mul_ps(z, _mm_set1_ps(0.9f));
+	_mm_storeu_ps(streams[8] + i, PluginSin_SSE2<kPluginMathPrecision_Exact>(phaseX));
+	_mm_storeu_ps(streams[9] + i, PluginCos_SSE2<kPluginMathPrecision_Exact>(phaseX));
+	_mm_storeu_ps(streams[10] + i, PluginSin_SSE2<kPluginMathPrecision_Exact>(phaseZ));
+	_mm_storeu_ps(streams[11] + i, PluginCos_SSE2<kPluginMathPrecision_Exact>(phaseZ));
+
+	Deinterleave3_SSE2(normals, x, y, z);
+	_mm_storeu_ps(streams[3] + i, x);
+	_mm_storeu_ps(streams[4] + i, y);
+	_mm_storeu_ps(streams[5] + i, z);
+
+	const __m128 uv01 = _mm_loadu_ps(uvs), uv23 = _mm_loadu_ps(uvs + 4);
+	_mm_storeu_ps(streams[6] + i, _mm_shuffle_ps(uv01, uv23, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(streams[7] + i, _mm_shuffle_ps(uv01, uv23, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+// The last vertices go through zero padded groups of four, so that the phases come out the
+// same wherever a range ends
+PLUGIN_TARGET_SSE2 void CopyMeshSource_SSE2(MeshVertexStreams& dst, int vertexBegin, int vertexEnd, const float* positions, const float* normals, const float* uvs)
+{
+	MeshVertexStream* dstStreams[MeshVertexStreams::kStreamCount];
+	dst.GetStreams(dstStreams);
+	float* streams[MeshVertexStreams::kStreamCount];
+	for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+		streams[s] = dstStreams[s]->data();
+
+	int i = vertexBegin;
+	for (; i + 4 <= vertexEnd; i += 4)
+		CopyMeshSource4_SSE2(streams, i, positions + size_t(i) * 3, normals + size_t(i) * 3, uvs + size_t(i) * 2);
+	if (i < vertexEnd)
+	{
+		const int count = vertexEnd - i;
+		float tailPositions[12] = {}, tailNormals[12] = {}, tailUVs[8] = {};
+		memcpy(tailPositions, positions + size_t(i) * 3, count * 3 * sizeof(float));
+		memcpy(tailNormals, normals + size_t(i) * 3, count * 3 * sizeof(float));
+		memcpy(tailUVs, uvs + size_t(i) * 2, count * 2 * sizeof(float));
+
+		float tail[MeshVertexStreams::kStreamCount][4];
+		float* tailStreams[MeshVertexStreams::kStreamCount];
+		for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+			tailStreams[s] = tail[s];
+		CopyMeshSource4_SSE2(tailStreams, 0, tailPositions, tailNormals, tailUVs);
+		for (int s = 0; s < MeshVertexStreams::kStreamCount; ++s)
+			memcpy(streams[s] + i, tail[s], count * sizeof(float));
+	}
+}
+
+#endif // PLUGIN_KERNELS_X86
@@ -0,0 +1,116 @@
+#pragma once
+
+// Sine and cosine for the per-frame kernels, which evaluate several sines per pixel and
+// per vertex. Two precisions:
+//
+//   kPluginMathPrecision_Exact: what the kernels have always computed. The scalar forms
+//     call libm's sinf/cosf; the SIMD forms (PluginMath_SIMD.h) evaluate an odd Taylor
+//     polynomial up to r^11 and stay within kPluginMathExactMaxError of libm.
+//   kPluginMathPrecision_Fast: a degree 5 minimax polynomial, scalar and SIMD, within
+//     kPluginMathFastMaxError of libm. That is far below what the plasma (8 bit channels,
+//     127 * the sum of four sines / 4) or the vertex waves (0.4 units tall) can show.
+//
+// Both polynomials work on r = x - k * pi, |r| <= pi/2, with pi split in three parts
+// (Cody-Waite) so that r stays exact for large arguments: the plasma's grow with time.
+// The error bounds hold for |x| <= kPluginMathMaxArgument; KernelBench checks them against
+// libm over that range for every form.
+
+#include "PlatformBase.h"
+
+#include <math.h>
+
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define PLUGIN_KERNELS_X86 1
+#else
+#	define PLUGIN_KERNELS_X86 0
+#endif
+
+
+enum PluginMathPrecision
+{
+	kPluginMathPrecision_Exact,
+	kPluginMathPrecision_Fast,
+	kPluginMathPrecisionCount
+};
+
+const float kPluginMathExactMaxError = 3.0e-7f;
+const float kPluginMathFastMaxError = 7.5e-5f;
+const float kPluginMathMaxArgument = 16384.0f;
+
+
+const float kPluginMathInvPi = 0.318309886f;
+const float kPluginMathPiA = 3.140625f;				// exact times any k below 2^16
+const float kPluginMathPiB = 9.67502593994140625e-4f;
+const float kPluginMathPiC = 1.509957990978376432e-7f;
+
+// Taylor coefficients of sin(r), r^3 to r^11
+const float kPluginMathSin3 = -1.66666672e-1f;
+const float kPluginMathSin5 = 8.33333377e-3f;
+const float kPluginMathSin7 = -1.98412701e-4f;
+const float kPluginMathSin9 = 2.75573188e-6f;
+const float kPluginMathSin11 = -2.50521079e-8f;
+
+// Minimax fit of sin(r) on [-pi/2, pi/2] by r, r^3 and r^5; 6.8e-5 off at most
+const float kPluginMathFastSin1 = 9.99696773e-1f;
+const float kPluginMathFastSin3 = -1.65673079e-1f;
+const float kPluginMathFastSin5 = 7.51437718e-3f;
+
+
+// sin(r) for |r| <= pi/2
+template<PluginMathPrecision Precision>
+inline float PluginSinPolynomial(float r)
+{
+	const float r2 = r * r;
+	if (Precision == kPluginMathPrecision_Fast)
+		return r * (kPluginMathFastSin1 + r2 * (kPluginMathFastSin3 + r2 * kPluginMathFastSin5));
+	return r + r * r2 * (kPluginMathSin3 + r2 * (kPluginMathSin5 + r2 * (kPluginMathSin7 + r2 * (kPluginMathSin9 + r2 * kPluginMathSin11))));
+}
+
+// x - kf * pi, in three steps
+inline float PluginReduceByPi(float x, float kf)
+{
+	float r = x - kf * kPluginMathPiA;
+	r -= kf * kPluginMathPiB;
+	r -= kf * kPluginMathPiC;
+	return r;
+}
+
+
+// Nearest integer; a truncating conversion is much cheaper than floorf where that is a call
+inline int PluginRoundToInt(float v)
+{
+	return int(v + (v >= 0.0f ? 0.5f : -0.5f));
+}
+
+// The polynomial forms, for either precision. sin(x) = (-1)^k sin(r) with k the multiple
+// of pi nearest to x; cos(x) = -(-1)^k sin(r) with x = (k + 1/2) pi + r.
+template<PluginMathPrecision Precision>
+inline float PluginSinApprox(float x)
+{
+	const int k = PluginRoundToInt(x * kPluginMathInvPi);
+	const float s = PluginSinPolynomial<Precision>(PluginReduceByPi(x, float(k)));
+	return (k & 1) ? -s : s;
+}
+
+template<PluginMathPrecision Precision>
+inline float PluginCosApprox(float x)
+{
+	const int k = PluginRoundToInt(x * kPluginMathInvPi - 0.5f);
+	const float s = PluginSinPolynomial<Precision>(PluginReduceByPi(x, float(k) + 0.5f));
+	return (k & 1) ? s : -s;
+}
+
+
+// What the scalar kernels call: libm when exact, the polynomial when fast.
+template<PluginMathPrecision Precision>
+inline float PluginSin(float x)
+{
+	return Precision == kPluginMathPrecision_Fast ? PluginSinApprox<kPluginMathPrecision_Fast>(x) : sinf(x);
+}
+
+template<PluginMathPrecision Precision>
+inline float PluginCos(float x)
+{
+	return Precision == kPluginMathPrecision_Fast ? PluginCosApprox<kPluginMathPrecision_Fast>(x) : cosf(x);
+}
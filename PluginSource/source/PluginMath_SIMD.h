@@ -0,0 +1,115 @@
+#pragma once
+
+// SSE2 and AVX2 forms of the PluginMath.h polynomials, four or eight lanes at a time, for
+// the SIMD kernels. x86 only; like the kernels they use function level target attributes,
+// so any translation unit can include this without special compiler flags.
+
+#include "PluginMath.h"
+
+#if PLUGIN_KERNELS_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#	include <intrin.h>
+#	define PLUGIN_TARGET_SSE2
+#	define PLUGIN_TARGET_AVX2
+#else
+#	define PLUGIN_TARGET_SSE2 __attribute__((target("sse2")))
+#	define PLUGIN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static inline __m128 PluginSinPolynomial_SSE2(__m128 r)
+{
+	const __m128 r2 = _mm_mul_ps(r, r);
+	if (Precision == kPluginMathPrecision_Fast)
+	{
+		__m128 p = _mm_set1_ps(kPluginMathFastSin5);
+		p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(kPluginMathFastSin3));
+		p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(kPluginMathFastSin1));
+		return _mm_mul_ps(r, p);
+	}
+	__m128 p = _mm_set1_ps(kPluginMathSin11);
+	p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(kPluginMathSin9));
+	p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(kPluginMathSin7));
+	p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(kPluginMathSin5));
+	p = _mm_add_ps(_mm_mul_ps(p, r2), _mm_set1_ps(kPluginMathSin3));
+	return _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), p));
+}
+
+PLUGIN_TARGET_SSE2 static inline __m128 PluginReduceByPi_SSE2(__m128 x, __m128 kf)
+{
+	__m128 r = _mm_sub_ps(x, _mm_mul_ps(kf, _mm_set1_ps(kPluginMathPiA)));
+	r = _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(kPluginMathPiB)));
+	return _mm_sub_ps(r, _mm_mul_ps(kf, _mm_set1_ps(kPluginMathPiC)));
+}
+
+// The polynomial is odd, so flipping the sign of r for odd k flips the result
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static inline __m128 PluginSin_SSE2(__m128 x)
+{
+	const __m128i k = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(kPluginMathInvPi)));
+	__m128 r = PluginReduceByPi_SSE2(x, _mm_cvtepi32_ps(k));
+	r = _mm_xor_ps(r, _mm_castsi128_ps(_mm_slli_epi32(k, 31)));
+	return PluginSinPolynomial_SSE2<Precision>(r);
+}
+
+// k rounds x / pi - 1/2, and the sign flips for even k
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_SSE2 static inline __m128 PluginCos_SSE2(__m128 x)
+{
+	const __m128i k = _mm_cvtps_epi32(_mm_sub_ps(_mm_mul_ps(x, _mm_set1_ps(kPluginMathInvPi)), _mm_set1_ps(0.5f)));
+	__m128 r = PluginReduceByPi_SSE2(x, _mm_add_ps(_mm_cvtepi32_ps(k), _mm_set1_ps(0.5f)));
+	r = _mm_xor_ps(r, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(k, _mm_set1_epi32(1)), 31)));
+	return PluginSinPolynomial_SSE2<Precision>(r);
+}
+
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_AVX2 static inline __m256 PluginSinPolynomial_AVX2(__m256 r)
+{
+	const __m256 r2 = _mm256_mul_ps(r, r);
+	if (Precision == kPluginMathPrecision_Fast)
+	{
+		__m256 p = _mm256_set1_ps(kPluginMathFastSin5);
+		p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(kPluginMathFastSin3));
+		p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(kPluginMathFastSin1));
+		return _mm256_mul_ps(r, p);
+	}
+	__m256 p = _mm256_set1_ps(kPluginMathSin11);
+	p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(kPluginMathSin9));
+	p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(kPluginMathSin7));
+	p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(kPluginMathSin5));
+	p = _mm256_fmadd_ps(p, r2, _mm256_set1_ps(kPluginMathSin3));
+	return _mm256_fmadd_ps(_mm256_mul_ps(r, r2), p, r);
+}
+
+PLUGIN_TARGET_AVX2 static inline __m256 PluginReduceByPi_AVX2(__m256 x, __m256 kf)
+{
+	__m256 r = _mm256_fnmadd_ps(kf, _mm256_set1_ps(kPluginMathPiA), x);
+	r = _mm256_fnmadd_ps(kf, _mm256_set1_ps(kPluginMathPiB), r);
+	return _mm256_fnmadd_ps(kf, _mm256_set1_ps(kPluginMathPiC), r);
+}
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_AVX2 static inline __m256 PluginSin_AVX2(__m256 x)
+{
+	const __m256i k = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(kPluginMathInvPi)));
+	__m256 r = PluginReduceByPi_AVX2(x, _mm256_cvtepi32_ps(k));
+	r = _mm256_xor_ps(r, _mm256_castsi256_ps(_mm256_slli_epi32(k, 31)));
+	return PluginSinPolynomial_AVX2<Precision>(r);
+}
+
+template<PluginMathPrecision Precision>
+PLUGIN_TARGET_AVX2 static inline __m256 PluginCos_AVX2(__m256 x)
+{
+	const __m256i k = _mm256_cvtps_epi32(_mm256_fmsub_ps(x, _mm256_set1_ps(kPluginMathInvPi), _mm256_set1_ps(0.5f)));
+	__m256 r = PluginReduceByPi_AVX2(x, _mm256_add_ps(_mm256_cvtepi32_ps(k), _mm256_set1_ps(0.5f)));
+	r = _mm256_xor_ps(r, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(k, _mm256_set1_epi32(1)), 31)));
+	return PluginSinPolynomial_AVX2<Precision>(r);
+}
+
+#endif // PLUGIN_KERNELS_X86
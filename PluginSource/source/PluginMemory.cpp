@@ -0,0 +1,85 @@
+#include "PluginMemory.h"
+
+#include <algorithm>
+#include <atomic>
+
+
+static const char* const kPluginMemoryCategoryNames[kPluginMemoryCategoryCount] =
+{
+	"Staging",
+	"TransientVertex",
+	"PluginImages",
+	"DescriptorPools",
+	"KernelTables",
+};
+
+
+// Updated by the render thread and the threads the kernels run on, read from any thread. The
+// counters of a category are read one by one, so a snapshot taken during an update can be off
+// by that update.
+struct MemoryCounters
+{
+	std::atomic<unsigned long long> liveBytes;
+	std::atomic<unsigned long long> peakBytes;
+	std::atomic<unsigned long long> pendingDeletionBytes;
+	std::atomic<unsigned long long> allocationCount;
+	std::atomic<unsigned long long> liveAllocationCount;
+};
+
+static MemoryCounters s_Counters[kPluginMemoryCategoryCount];
+
+
+const char* PluginMemory_GetCategoryName(int category)
+{
+	return category >= 0 && category < kPluginMemoryCategoryCount ? kPluginMemoryCategoryNames[category] : NULL;
+}
+
+
+void PluginMemory_Allocate(PluginMemoryCategory category, unsigned long long bytes)
+{
+	MemoryCounters& counters = s_Counters[category];
+	const unsigned long long live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	unsigned long long peak = counters.peakBytes.load(std::memory_order_relaxed);
+	while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+	counters.allocationCount.fetch_add(1, std::memory_order_relaxed);
+	counters.liveAllocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+void PluginMemory_Free(PluginMemoryCategory category, unsigned long long bytes)
+{
+	MemoryCounters& counters = s_Counters[category];
+	counters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	counters.liveAllocationCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+void PluginMemory_QueueFree(PluginMemoryCategory category, unsigned long long bytes)
+{
+	s_Counters[category].pendingDeletionBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+
+void PluginMemory_DequeueFree(PluginMemoryCategory category, unsigned long long bytes)
+{
+	s_Counters[category].pendingDeletionBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+
+int PluginMemory_GetStats(PluginMemoryStats* outStats, int maxCategories)
+{
+	const int count = std::min(maxCategories, (int)kPluginMemoryCategoryCount);
+	for (int i = 0; i < count; ++i)
+	{
+		const MemoryCounters& counters = s_Counters[i];
+		PluginMemoryStats& stats = outStats[i];
+		stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+		stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+		stats.pendingDeletionBytes = counters.pendingDeletionBytes.load(std::memory_order_relaxed);
+		stats.allocationCount = counters.allocationCount.load(std::memory_order_relaxed);
+		stats.liveAllocationCount = counters.liveAllocationCount.load(std::memory_order_relaxed);
+	}
+	return count;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Accounting of the device memory the plugin allocates itself (Unity's own resources are
+// not included), plus the larger host-memory caches of the kernels. Backends report
+// allocations, frees and deferred deletions per category; scripts read the counters through
+// GetPluginMemoryStats (see RenderingPlugin.cpp) from any thread, to spot memory growth and
+// allocation churn in long sessions.
+
+#include "PlatformBase.h"
+
+
+enum PluginMemoryCategory
+{
+	kPluginMemory_Staging,				// upload buffers, the per-frame texture staging buffer
+	kPluginMemory_TransientVertex,		// per-draw vertex buffers
+	kPluginMemory_PluginImages,			// textures created by the plugin
+	kPluginMemory_DescriptorPools,		// owned by the driver, counted without bytes
+	kPluginMemory_KernelTables,			// host memory: the plasma table kernel's radial fields
+	kPluginMemoryCategoryCount
+};
+
+// Counters of one category. Keep in sync with the struct in UseRenderingPlugin.cs.
+struct PluginMemoryStats
+{
+	unsigned long long liveBytes;			// allocated and not freed yet, including pending deletion
+	unsigned long long peakBytes;			// highest liveBytes so far
+	unsigned long long pendingDeletionBytes;	// released by the plugin, waiting for the GPU to be done with it
+	unsigned long long allocationCount;		// allocations since the plugin was loaded
+	unsigned long long liveAllocationCount;
+};
+
+const char* PluginMemory_GetCategoryName(int category);
+
+void PluginMemory_Allocate(PluginMemoryCategory category, unsigned long long bytes);
+void PluginMemory_Free(PluginMemoryCategory category, unsigned long long bytes);
+// Deferred deletion: between these two the allocation counts as pending; Free it afterwards as usual.
+void PluginMemory_QueueFree(PluginMemoryCategory category, unsigned long long bytes);
+void PluginMemory_DequeueFree(PluginMemoryCategory category, unsigned long long bytes);
+
+// Fills up to 'maxCategories' entries of 'outStats' (indexed by PluginMemoryCategory) and
+// returns how many were filled.
+int PluginMemory_GetStats(PluginMemoryStats* outStats, int maxCategories);
@@ -0,0 +1,115 @@
+#include "PluginMeshes.h"
+
+#include <mutex>
+
+
+struct RegisteredMesh
+{
+	int id;
+	void* vertexBufferHandle;
+	VertexSourcePtr source;
+	PluginMeshDeformation deformation;
+};
+
+static std::mutex s_MeshesMutex;						// guards everything below
+static std::vector<RegisteredMesh> s_Meshes;			// in the order they were added
+static int s_NextMeshId = 1;
+
+// Held from PluginMeshes_AcquireUpdates to PluginMeshes_ReleaseUpdates; removing takes it once,
+// after dropping the mesh from the list, to wait for the render event that may still read it
+static std::mutex s_UpdatesMutex;
+
+
+static RegisteredMesh* FindMesh(int id)
+{
+	for (size_t i = 0; i < s_Meshes.size(); ++i)
+	{
+		if (s_Meshes[i].id == id)
+			return &s_Meshes[i];
+	}
+	return NULL;
+}
+
+
+int PluginMeshes_Add(void* vertexBufferHandle, const VertexSourcePtr& source)
+{
+	if (!vertexBufferHandle || !source || source->GetVertexCount() <= 0)
+		return 0;
+
+	std::lock_guard<std::mutex> lock(s_MeshesMutex);
+	RegisteredMesh mesh;
+	mesh.id = s_NextMeshId++;
+	mesh.vertexBufferHandle = vertexBufferHandle;
+	mesh.source = source;
+	mesh.deformation.speed = 1.0f;
+	mesh.deformation.timeOffset = 0.0f;
+	s_Meshes.push_back(mesh);
+	return mesh.id;
+}
+
+
+bool PluginMeshes_SetDeformation(int id, const PluginMeshDeformation& deformation)
+{
+	std::lock_guard<std::mutex> lock(s_MeshesMutex);
+	RegisteredMesh* mesh = FindMesh(id);
+	if (!mesh)
+		return false;
+	mesh->deformation = deformation;
+	return true;
+}
+
+
+bool PluginMeshes_Remove(int id)
+{
+	VertexSourcePtr source;
+	{
+		std::lock_guard<std::mutex> lock(s_MeshesMutex);
+		RegisteredMesh* mesh = FindMesh(id);
+		if (!mesh)
+			return false;
+		source.swap(mesh->source);
+		s_Meshes.erase(s_Meshes.begin() + (mesh - s_Meshes.data()));
+	}
+	std::lock_guard<std::mutex> wait(s_UpdatesMutex);
+	return true;
+}
+
+
+void PluginMeshes_RemoveAll()
+{
+	std::vector<RegisteredMesh> meshes;
+	{
+		std::lock_guard<std::mutex> lock(s_MeshesMutex);
+		meshes.swap(s_Meshes);
+	}
+	std::lock_guard<std::mutex> wait(s_UpdatesMutex);
+}
+
+
+int PluginMeshes_GetCount()
+{
+	std::lock_guard<std::mutex> lock(s_MeshesMutex);
+	return int(s_Meshes.size());
+}
+
+
+void PluginMeshes_AcquireUpdates(float time, std::vector<MeshBufferUpdate>& updates)
+{
+	s_UpdatesMutex.lock();
+	std::lock_guard<std::mutex> lock(s_MeshesMutex);
+	for (size_t i = 0; i < s_Meshes.size(); ++i)
+	{
+		const RegisteredMesh& mesh = s_Meshes[i];
+		MeshBufferUpdate update;
+		update.bufferHandle = mesh.vertexBufferHandle;
+		update.source = mesh.source.get();
+		update.time = time * mesh.deformation.speed + mesh.deformation.timeOffset;
+		updates.push_back(update);
+	}
+}
+
+
+void PluginMeshes_ReleaseUpdates()
+{
+	s_UpdatesMutex.unlock();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Registry of the meshes the render event deforms besides the one set with SetMeshBuffersFromUnity,
+// so that a script can animate any number of meshes with one plugin and one event. Every mesh has
+// its own source vertices and its own deformation timing; every render event deforms all of them
+// together with the script's mesh, spread over the worker threads as one job (DeformMeshBatch),
+// and writes them into their vertex buffers as one batch (ModifyVertexBufferBatch,
+// RenderAPI::BeginModifyVertexBuffers).
+//
+// Meshes are added, changed and removed by id from any thread; the render event takes a copy of
+// the list, so changes apply from the next event on. Removing a mesh returns once no render event
+// reads its source anymore.
+
+#include "PluginKernels.h"
+#include "PluginPipeline.h"
+
+#include <vector>
+
+
+// The time a mesh is deformed for: the frame's time * speed + timeOffset. Meshes start out at
+// speed 1 and offset 0, in step with the script's mesh.
+struct PluginMeshDeformation
+{
+	float speed;
+	float timeOffset;
+};
+
+// Returns the new mesh's id (> 0), or 0 if there is no buffer or no source vertices.
+int PluginMeshes_Add(void* vertexBufferHandle, const VertexSourcePtr& source);
+// False if the id is unknown.
+bool PluginMeshes_SetDeformation(int id, const PluginMeshDeformation& deformation);
+// False if the id is unknown. Waits for a render event in progress, so that memory the source
+// referenced (ReferenceMeshSource) can go away afterwards; the buffer may still be written by it.
+bool PluginMeshes_Remove(int id);
+void PluginMeshes_RemoveAll();
+int PluginMeshes_GetCount();
+
+// Render thread: appends an update of every registered mesh for the frame's time, in the order
+// they were added. The sources stay valid until PluginMeshes_ReleaseUpdates.
+void PluginMeshes_AcquireUpdates(float time, std::vector<MeshBufferUpdate>& updates);
+void PluginMeshes_ReleaseUpdates();
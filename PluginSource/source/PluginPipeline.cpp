@@ -0,0 +1,237 @@
+#include "PluginPipeline.h"
+#include "PluginTrace.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+struct Pipeline
+{
+	std::mutex callMutex;					// serializes starting and stopping the thread
+	std::mutex mutex;						// guards everything below
+	std::condition_variable workCondition;	// a frame was requested, or quit
+	std::condition_variable doneCondition;	// a frame was finished or released
+	std::thread thread;
+	bool enabled;
+	bool quit;
+	PipelineFrameDesc desc;					// of the newest request
+	VertexSourcePtr vertexSource;			// replaced, never modified, so the thread can keep using an old one
+	const MeshVertexStreams* generatingSource;	// the one of the frame in progress, NULL if none
+	unsigned int requestedGeneration;
+	unsigned int finishedGeneration;		// all requests up to here are done or dropped
+	unsigned int acquiredGeneration;		// of the last frame the render thread took
+	PipelineFrame frames[2];
+	int latestFrame;						// newest finished frame, -1 if none
+	int readingFrame;						// held by the render thread, -1 if none
+
+	Pipeline() : enabled(false), quit(false), generatingSource(NULL), requestedGeneration(0), finishedGeneration(0), acquiredGeneration(0),
+		latestFrame(-1), readingFrame(-1)
+	{
+		desc.time = 0.0f;
+		desc.textureWidth = desc.textureHeight = 0;
+		desc.textureFormat = kPluginTextureFormat_RGBA8;
+		frames[0].generation = frames[1].generation = 0;
+		frames[0].rowPitch = frames[1].rowPitch = 0;
+	}
+};
+
+// Never destroyed, like the worker pool: the thread may outlive static destruction when the
+// process exits without unloading the plugin
+static Pipeline& GetPipeline()
+{
+	static Pipeline* pipeline = new Pipeline();
+	return *pipeline;
+}
+
+
+static void GenerateFrame(PipelineFrame& frame, const PipelineFrameDesc& desc, const VertexSourcePtr& vertexSource)
+{
+	PLUGIN_TRACE_SCOPE("GeneratePipelineFrame");
+
+	frame.desc = desc;
+	if (desc.textureWidth > 0 && desc.textureHeight > 0)
+	{
+		const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(desc.textureFormat);
+		frame.rowPitch = desc.textureWidth * bytesPerPixel;
+		frame.pixels.resize(size_t(frame.rowPitch) * desc.textureHeight);
+		FillPlasmaPixels(&frame.pixels[0], desc.textureWidth, desc.textureHeight, frame.rowPitch, bytesPerPixel, desc.time);
+	}
+	else
+	{
+		frame.rowPitch = 0;
+		frame.pixels.clear();
+	}
+
+	const int vertexCount = vertexSource ? vertexSource->GetVertexCount() : 0;
+	frame.vertexSource = vertexSource;
+	frame.vertices.resize(vertexCount);
+	if (vertexCount > 0)
+		DeformMeshVertices(*vertexSource, &frame.vertices[0], sizeof(MeshVertex), desc.time);
+}
+
+
+static void PipelineMain()
+{
+	Pipeline& pipeline = GetPipeline();
+	std::unique_lock<std::mutex> lock(pipeline.mutex);
+	for (;;)
+	{
+		while (!pipeline.quit && pipeline.finishedGeneration == pipeline.requestedGeneration)
+			pipeline.workCondition.wait(lock);
+		if (pipeline.quit)
+			return;
+
+		// Requests that came in while the previous frame was generated collapse into the newest one.
+		// Write into the frame the render thread doesn't hold; if it holds none, keep the newest
+		// finished frame around for it and overwrite the older one.
+		const unsigned int generation = pipeline.requestedGeneration;
+		const PipelineFrameDesc desc = pipeline.desc;
+		const VertexSourcePtr vertexSource = pipeline.vertexSource;
+		int target;
+		if (pipeline.readingFrame >= 0)
+			target = 1 - pipeline.readingFrame;
+		else
+			target = pipeline.latestFrame >= 0 ? 1 - pipeline.latestFrame : 0;
+		if (pipeline.latestFrame == target)
+			pipeline.latestFrame = -1;
+
+		pipeline.generatingSource = vertexSource.get();
+		lock.unlock();
+		GenerateFrame(pipeline.frames[target], desc, vertexSource);
+		lock.lock();
+
+		pipeline.generatingSource = NULL;
+		pipeline.frames[target].generation = generation;
+		pipeline.latestFrame = target;
+		pipeline.finishedGeneration = generation;
+		pipeline.doneCondition.notify_all();
+	}
+}
+
+
+// Called with callMutex held. Waits for the frame in progress and for the render thread to release its frame.
+static void StopPipelineThread(Pipeline& pipeline, bool freeFrames)
+{
+	{
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		pipeline.quit = true;
+		pipeline.workCondition.notify_one();
+	}
+	if (pipeline.thread.joinable())
+		pipeline.thread.join();
+
+	std::unique_lock<std::mutex> lock(pipeline.mutex);
+	pipeline.quit = false;
+	// Requests the thread didn't get to are dropped, so AcquireFrame doesn't wait for them
+	pipeline.finishedGeneration = pipeline.requestedGeneration;
+	pipeline.doneCondition.notify_all();
+	if (!freeFrames)
+		return;
+
+	while (pipeline.readingFrame >= 0)
+		pipeline.doneCondition.wait(lock);
+	pipeline.latestFrame = -1;
+	for (int i = 0; i < 2; ++i)
+	{
+		std::vector<unsigned char>().swap(pipeline.frames[i].pixels);
+		std::vector<MeshVertex>().swap(pipeline.frames[i].vertices);
+		pipeline.frames[i].vertexSource.reset();
+		pipeline.frames[i].rowPitch = 0;
+	}
+}
+
+
+void PluginPipeline_SetEnabled(bool enabled)
+{
+	Pipeline& pipeline = GetPipeline();
+	std::lock_guard<std::mutex> callLock(pipeline.callMutex);
+	{
+		std::lock_guard<std::mutex> lock(pipeline.mutex);
+		if (pipeline.enabled == enabled)
+			return;
+		pipeline.enabled = enabled;
+	}
+	if (!enabled)
+		StopPipelineThread(pipeline, true);
+}
+
+
+bool PluginPipeline_IsEnabled()
+{
+	Pipeline& pipeline = GetPipeline();
+	std::lock_guard<std::mutex> lock(pipeline.mutex);
+	return pipeline.enabled;
+}
+
+
+void PluginPipeline_SetVertexSource(const VertexSourcePtr& source)
+{
+	VertexSourcePtr vertexSource;
+	if (source && source->GetVertexCount() > 0)
+		vertexSource = source;
+
+	Pipeline& pipeline = GetPipeline();
+	std::unique_lock<std::mutex> lock(pipeline.mutex);
+	pipeline.vertexSource.swap(vertexSource);
+	// vertexSource is the previous one now
+	while (vertexSource && pipeline.generatingSource == vertexSource.get())
+		pipeline.doneCondition.wait(lock);
+}
+
+
+void PluginPipeline_BeginFrame(const PipelineFrameDesc& desc)
+{
+	Pipeline& pipeline = GetPipeline();
+	std::lock_guard<std::mutex> callLock(pipeline.callMutex);
+	std::lock_guard<std::mutex> lock(pipeline.mutex);
+	if (!pipeline.enabled)
+		return;
+	if (!pipeline.thread.joinable())
+		pipeline.thread = std::thread(PipelineMain);
+
+	pipeline.desc = desc;
+	++pipeline.requestedGeneration;
+	pipeline.workCondition.notify_one();
+}
+
+
+const PipelineFrame* PluginPipeline_AcquireFrame()
+{
+	Pipeline& pipeline = GetPipeline();
+	std::unique_lock<std::mutex> lock(pipeline.mutex);
+	if (!pipeline.enabled)
+		return NULL;
+
+	for (;;)
+	{
+		const bool newFrame = pipeline.latestFrame >= 0 && pipeline.frames[pipeline.latestFrame].generation != pipeline.acquiredGeneration;
+		if (newFrame || pipeline.finishedGeneration == pipeline.requestedGeneration)
+			break;
+		pipeline.doneCondition.wait(lock);
+	}
+	if (pipeline.latestFrame < 0)
+		return NULL;
+
+	pipeline.readingFrame = pipeline.latestFrame;
+	pipeline.acquiredGeneration = pipeline.frames[pipeline.readingFrame].generation;
+	return &pipeline.frames[pipeline.readingFrame];
+}
+
+
+void PluginPipeline_ReleaseFrame()
+{
+	Pipeline& pipeline = GetPipeline();
+	std::lock_guard<std::mutex> lock(pipeline.mutex);
+	pipeline.readingFrame = -1;
+	pipeline.doneCondition.notify_all();
+}
+
+
+void PluginPipeline_Shutdown()
+{
+	Pipeline& pipeline = GetPipeline();
+	std::lock_guard<std::mutex> callLock(pipeline.callMutex);
+	StopPipelineThread(pipeline, true);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Pipelined generation of the per-frame CPU data: when the script sets the time of a frame,
+// a background thread starts computing that frame's texture pixels and deformed vertices into
+// host memory, so that the render event only has to map, copy and unmap. The generation
+// itself still spreads over the worker threads (PluginWorkers.h).
+//
+// There are two frame buffers: the render thread reads one while the next frame is generated
+// into the other. The render event takes the newest finished frame; it only waits when no
+// frame newer than the one it took last is finished yet, in which case it waits for the
+// frame in progress.
+
+#include "PlatformBase.h"
+#include "PluginKernels.h"
+
+#include <memory>
+#include <vector>
+
+
+typedef std::shared_ptr<const MeshVertexStreams> VertexSourcePtr;
+
+
+// What a frame generates; a texture size of 0 skips the texture. The vertices are deformed
+// from the source set with PluginPipeline_SetVertexSource, if any.
+struct PipelineFrameDesc
+{
+	float time;
+	int textureWidth;
+	int textureHeight;
+	PluginTextureFormat textureFormat;
+};
+
+// Data of one generated frame. The texture rows are tightly packed.
+struct PipelineFrame
+{
+	PipelineFrameDesc desc;
+	std::vector<unsigned char> pixels;
+	int rowPitch;
+	std::vector<MeshVertex> vertices;
+	// The source the vertices were deformed from, to tell them apart from another mesh's of the
+	// same size; held so that the pointer can't be reused by a newer source. Never read from.
+	VertexSourcePtr vertexSource;
+	unsigned int generation;	// of the PluginPipeline_BeginFrame call it was made for
+};
+
+
+// Turning the pipeline off waits for the frame in progress, stops the thread and frees the buffers.
+void PluginPipeline_SetEnabled(bool enabled);
+bool PluginPipeline_IsEnabled();
+
+// Source vertices DeformMeshVertices starts from. Shared, not copied: the caller must not
+// modify it anymore. Returns once a frame in progress is done with the previous source, so
+// that memory a previous source referenced (ReferenceMeshSource) can go away afterwards.
+void PluginPipeline_SetVertexSource(const VertexSourcePtr& source);
+
+// Starts generating a frame on the pipeline thread; a frame still in progress finishes first.
+// Does nothing while the pipeline is off. Any thread.
+void PluginPipeline_BeginFrame(const PipelineFrameDesc& desc);
+
+// Render thread: returns the newest finished frame, waiting for the one in progress if none is
+// newer than the last one acquired, or NULL if no frame was generated yet. The frame stays
+// valid until PluginPipeline_ReleaseFrame.
+const PipelineFrame* PluginPipeline_AcquireFrame();
+void PluginPipeline_ReleaseFrame();
+
+// Stops the pipeline thread; like PluginPipeline_SetEnabled(false), but the setting is kept
+// and the thread starts again with the next frame.
+void PluginPipeline_Shutdown();
@@ -0,0 +1,147 @@
+#include "PluginStats.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+
+static const char* const kPluginStageNames[kPluginStageCount] =
+{
+	"RenderEvent",
+	"drawToRenderTexture",
+	"DrawColoredTriangle",
+	"ModifyTexturePixels",
+	"ModifyVertexBuffer",
+	"WaitForPipelineFrame",
+	"DrawSimpleTriangles",
+	"BeginModifyTexture",
+	"EndModifyTexture",
+	"BeginModifyVertexBuffer",
+	"EndModifyVertexBuffer",
+	"GPU EndModifyTexture",
+	"GPU DrawSimpleTriangles",
+	"GPU ModifyVertexBuffer",
+};
+
+
+const char* PluginStats_GetStageName(int stage)
+{
+	return stage >= 0 && stage < kPluginStageCount ? kPluginStageNames[stage] : NULL;
+}
+
+
+#if PLUGIN_FRAME_STATS
+
+#include <atomic>
+
+
+// Frames are written by the render thread only and read by whoever polls the stats.
+// Each slot is guarded by a sequence number (odd while the slot is being written), so
+// the writer never waits and a reader skips slots that changed while it copied them.
+struct FrameSlot
+{
+	std::atomic<unsigned int> sequence;
+	std::atomic<unsigned int> nanoseconds[kPluginStageCount];
+	std::atomic<unsigned int> calls[kPluginStageCount];
+};
+
+static FrameSlot s_Frames[kPluginStatsFrameCount];
+static std::atomic<unsigned int> s_PublishedFrames(0);
+
+// Current frame, render thread only
+static unsigned long long s_CurrentNanoseconds[kPluginStageCount];
+static unsigned int s_CurrentCalls[kPluginStageCount];
+static unsigned int s_FrameIndex = 0;
+
+
+void PluginStats_BeginFrame()
+{
+	memset(s_CurrentNanoseconds, 0, sizeof(s_CurrentNanoseconds));
+	memset(s_CurrentCalls, 0, sizeof(s_CurrentCalls));
+}
+
+
+void PluginStats_AddSample(PluginStage stage, std::chrono::steady_clock::duration duration)
+{
+	s_CurrentNanoseconds[stage] += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+	++s_CurrentCalls[stage];
+}
+
+
+void PluginStats_EndFrame()
+{
+	FrameSlot& slot = s_Frames[s_FrameIndex % kPluginStatsFrameCount];
+	const unsigned int sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (int i = 0; i < kPluginStageCount; ++i)
+	{
+		const unsigned long long ns = std::min(s_CurrentNanoseconds[i], 0xFFFFFFFFull);
+		slot.nanoseconds[i].store((unsigned int)ns, std::memory_order_relaxed);
+		slot.calls[i].store(s_CurrentCalls[i], std::memory_order_relaxed);
+	}
+	slot.sequence.store(sequence + 2, std::memory_order_release);
+
+	++s_FrameIndex;
+	s_PublishedFrames.store(s_FrameIndex, std::memory_order_release);
+	PluginStats_BeginFrame();
+}
+
+
+int PluginStats_Summarize(PluginStageStats* outStats, int maxStages)
+{
+	const unsigned int published = s_PublishedFrames.load(std::memory_order_acquire);
+	const int available = (int)std::min<unsigned int>(published, kPluginStatsFrameCount);
+
+	// Copy out the consistent frames, per stage
+	std::vector<float> samples[kPluginStageCount];
+	int frameCount = 0;
+	for (int f = 0; f < available; ++f)
+	{
+		const FrameSlot& slot = s_Frames[f];
+		const unsigned int sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence & 1)
+			continue;
+		unsigned int nanoseconds[kPluginStageCount];
+		unsigned int calls[kPluginStageCount];
+		for (int i = 0; i < kPluginStageCount; ++i)
+		{
+			nanoseconds[i] = slot.nanoseconds[i].load(std::memory_order_relaxed);
+			calls[i] = slot.calls[i].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+			continue;
+
+		++frameCount;
+		for (int i = 0; i < kPluginStageCount; ++i)
+		{
+			if (calls[i] != 0)
+				samples[i].push_back(nanoseconds[i] * 0.001f);
+		}
+	}
+
+	const int stageCount = std::min(maxStages, (int)kPluginStageCount);
+	for (int i = 0; i < stageCount; ++i)
+	{
+		PluginStageStats& stats = outStats[i];
+		memset(&stats, 0, sizeof(stats));
+		std::vector<float>& values = samples[i];
+		if (values.empty())
+			continue;
+
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		for (size_t j = 0; j < values.size(); ++j)
+			sum += values[j];
+		const size_t p99 = std::min(values.size() - 1, (values.size() * 99 + 99) / 100 - 1);
+		stats.minMicroseconds = values.front();
+		stats.avgMicroseconds = float(sum / values.size());
+		stats.p99Microseconds = values[p99];
+		stats.maxMicroseconds = values.back();
+		stats.frameCount = (int)values.size();
+	}
+	return frameCount;
+}
+
+#endif // PLUGIN_FRAME_STATS
@@ -0,0 +1,101 @@
+#pragma once
+
+// Lightweight timers for the work the plugin does on the render thread: the stages of
+// the render event and every RenderAPI Begin/End call they make. The durations of each
+// frame go into a ring holding the last kPluginStatsFrameCount frames, which scripts
+// can poll through GetPluginFrameStats (see RenderingPlugin.cpp) from any thread.
+// Backends that support GPU timestamps also report the GPU time of the commands they
+// record, as the kPluginStage_Gpu* stages.
+//
+// Building with PLUGIN_FRAME_STATS=0 compiles the timers out entirely; the exported
+// functions then report no frames. The stages also show up in traces (PluginTrace.h).
+
+#include "PlatformBase.h"
+#include "PluginTrace.h"
+
+
+enum PluginStage
+{
+	kPluginStage_RenderEvent,				// whole of OnRenderEvent(1)
+	kPluginStage_DrawToRenderTexture,
+	kPluginStage_DrawColoredTriangle,
+	kPluginStage_ModifyTexturePixels,
+	kPluginStage_ModifyVertexBuffer,
+	kPluginStage_WaitForPipelineFrame,		// render event waiting for a frame generated ahead (PluginPipeline.h)
+	kPluginStage_DrawSimpleTriangles,		// RenderAPI calls, nested in the stages above
+	kPluginStage_BeginModifyTexture,
+	kPluginStage_EndModifyTexture,
+	kPluginStage_BeginModifyVertexBuffer,
+	kPluginStage_EndModifyVertexBuffer,
+	kPluginStage_GpuEndModifyTexture,		// GPU time of the commands the backend records, from
+	kPluginStage_GpuDrawSimpleTriangles,	// timestamp queries; reported a few frames late
+	kPluginStage_GpuModifyVertexBuffer,
+	kPluginStageCount
+};
+
+// Number of frames the statistics are computed over.
+const int kPluginStatsFrameCount = 256;
+
+// Summary of one stage over the frames in the ring. A stage that runs several times
+// in a frame counts with its total. Keep in sync with the struct in UseRenderingPlugin.cs.
+struct PluginStageStats
+{
+	float minMicroseconds;
+	float avgMicroseconds;
+	float p99Microseconds;
+	float maxMicroseconds;
+	int frameCount;							// frames in which the stage ran
+};
+
+const char* PluginStats_GetStageName(int stage);
+
+
+#if PLUGIN_FRAME_STATS
+
+#include <chrono>
+
+// Render thread: samples are summed into the current frame, which EndFrame publishes to the ring.
+void PluginStats_BeginFrame();
+void PluginStats_EndFrame();
+void PluginStats_AddSample(PluginStage stage, std::chrono::steady_clock::duration duration);
+
+// Render thread: GPU durations, added to the frame in which the backend read them back.
+inline void PluginStats_AddGpuSample(PluginStage stage, unsigned long long nanoseconds)
+{
+	PluginStats_AddSample(stage, std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(nanoseconds)));
+}
+
+// Any thread: fills up to 'maxStages' entries of 'outStats' (indexed by PluginStage)
+// and returns the number of frames they were computed over.
+int PluginStats_Summarize(PluginStageStats* outStats, int maxStages);
+
+
+class PluginStageTimer
+{
+public:
+	explicit PluginStageTimer(PluginStage stage) : m_Stage(stage), m_Start(std::chrono::steady_clock::now()) { }
+	~PluginStageTimer() { PluginStats_AddSample(m_Stage, std::chrono::steady_clock::now() - m_Start); }
+
+private:
+	PluginStage m_Stage;
+	std::chrono::steady_clock::time_point m_Start;
+};
+
+#define PLUGIN_STATS_CONCAT_(a, b) a##b
+#define PLUGIN_STATS_CONCAT(a, b) PLUGIN_STATS_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope as 'stage', and records it in a running trace.
+#define PLUGIN_STAGE_TIMER(stage) PluginStageTimer PLUGIN_STATS_CONCAT(pluginStageTimer, __LINE__)(stage); \
+	PLUGIN_TRACE_SCOPE(PluginStats_GetStageName(stage))
+#define PLUGIN_STATS_BEGIN_FRAME() PluginStats_BeginFrame()
+#define PLUGIN_STATS_END_FRAME() PluginStats_EndFrame()
+#define PLUGIN_STATS_ADD_GPU_SAMPLE(stage, nanoseconds) PluginStats_AddGpuSample(stage, nanoseconds)
+
+#else
+
+#define PLUGIN_STAGE_TIMER(stage) PLUGIN_TRACE_SCOPE(PluginStats_GetStageName(stage))
+#define PLUGIN_STATS_BEGIN_FRAME() do { } while (0)
+#define PLUGIN_STATS_END_FRAME() do { } while (0)
+#define PLUGIN_STATS_ADD_GPU_SAMPLE(stage, nanoseconds) do { (void)(stage); (void)(nanoseconds); } while (0)
+
+#endif // PLUGIN_FRAME_STATS
@@ -0,0 +1,103 @@
+#include "PluginTextures.h"
+
+#include <mutex>
+
+
+struct RegisteredTexture
+{
+	int id;
+	PluginTextureDesc desc;
+};
+
+static std::mutex s_TexturesMutex;						// guards everything below
+static std::vector<RegisteredTexture> s_Textures;		// in the order they were added
+static int s_NextTextureId = 1;
+
+
+static bool IsTextureUsable(const PluginTextureDesc& desc)
+{
+	return desc.textureHandle && desc.width > 0 && desc.height > 0 && desc.format >= 0 && desc.format < kPluginTextureFormatCount;
+}
+
+static RegisteredTexture* FindTexture(int id)
+{
+	for (size_t i = 0; i < s_Textures.size(); ++i)
+	{
+		if (s_Textures[i].id == id)
+			return &s_Textures[i];
+	}
+	return NULL;
+}
+
+
+int PluginTextures_Add(const PluginTextureDesc& desc)
+{
+	if (!IsTextureUsable(desc))
+		return 0;
+
+	std::lock_guard<std::mutex> lock(s_TexturesMutex);
+	RegisteredTexture texture;
+	texture.id = s_NextTextureId++;
+	texture.desc = desc;
+	s_Textures.push_back(texture);
+	return texture.id;
+}
+
+
+bool PluginTextures_Update(int id, const PluginTextureDesc& desc)
+{
+	if (!IsTextureUsable(desc))
+		return false;
+
+	std::lock_guard<std::mutex> lock(s_TexturesMutex);
+	RegisteredTexture* texture = FindTexture(id);
+	if (!texture)
+		return false;
+	texture->desc = desc;
+	return true;
+}
+
+
+bool PluginTextures_Remove(int id)
+{
+	std::lock_guard<std::mutex> lock(s_TexturesMutex);
+	RegisteredTexture* texture = FindTexture(id);
+	if (!texture)
+		return false;
+	s_Textures.erase(s_Textures.begin() + (texture - s_Textures.data()));
+	return true;
+}
+
+
+void PluginTextures_RemoveAll()
+{
+	std::lock_guard<std::mutex> lock(s_TexturesMutex);
+	s_Textures.clear();
+}
+
+
+int PluginTextures_GetCount()
+{
+	std::lock_guard<std::mutex> lock(s_TexturesMutex);
+	return int(s_Textures.size());
+}
+
+
+void PluginTextures_AppendUpdates(std::vector<PluginTextureUpdate>& updates)
+{
+	std::lock_guard<std::mutex> lock(s_TexturesMutex);
+	for (size_t i = 0; i < s_Textures.size(); ++i)
+	{
+		const PluginTextureDesc& desc = s_Textures[i].desc;
+		PluginTextureUpdate update;
+		update.textureHandle = desc.textureHandle;
+		update.textureWidth = desc.width;
+		update.textureHeight = desc.height;
+		update.format = desc.format;
+		update.rect.x = 0;
+		update.rect.y = 0;
+		update.rect.width = desc.width;
+		update.rect.height = desc.height;
+		updates.push_back(update);
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Registry of the textures the render event fills besides the one set with SetTextureFromUnity,
+// so that a script can drive any number of procedural textures with one plugin and one event.
+// Every render event regenerates all of them for the frame's time and uploads them together
+// with the script's texture, as one batch (ModifyTextureBatch, RenderAPI::BeginModifyTextures).
+//
+// Textures are added, updated and removed by id from any thread; the render event takes a copy
+// of the list, so changes apply from the next event on.
+
+#include "RenderAPI.h"
+
+#include <vector>
+
+
+struct PluginTextureDesc
+{
+	void* textureHandle;
+	int width, height;
+	PluginTextureFormat format;
+};
+
+// Returns the new texture's id (> 0), or 0 if the texture is unusable: no handle, an empty size
+// or an unknown format.
+int PluginTextures_Add(const PluginTextureDesc& desc);
+// Points an existing id at another texture, e.g. one Unity recreated; false if the id is unknown
+// or the texture unusable.
+bool PluginTextures_Update(int id, const PluginTextureDesc& desc);
+// False if the id is unknown. The texture may still be written by a render event already running.
+bool PluginTextures_Remove(int id);
+void PluginTextures_RemoveAll();
+int PluginTextures_GetCount();
+
+// Appends a whole-texture update of every registered texture, in the order they were added.
+void PluginTextures_AppendUpdates(std::vector<PluginTextureUpdate>& updates);
@@ -0,0 +1,135 @@
+#include "PluginTiles.h"
+#include "PluginKernels.h"
+
+#include <chrono>
+
+
+// Weight of the newest frame in the running time-per-pixel estimate
+static const double kTileTimeSmoothing = 0.25;
+
+
+TextureTileScheduler::TextureTileScheduler()
+	: m_Width(0)
+	, m_Height(0)
+	, m_Format(kPluginTextureFormat_RGBA8)
+	, m_Columns(0)
+	, m_Rows(0)
+	, m_NextTile(0)
+	, m_ScheduledPixels(0)
+	, m_MicrosecondsPerPixel(0.0)
+{
+	m_Settings.tileSize = 0;
+	m_Settings.maxBytesPerFrame = 0;
+	m_Settings.maxMillisecondsPerFrame = 0.0f;
+}
+
+
+void TextureTileScheduler::SetSettings(const TextureTileSettings& settings)
+{
+	TextureTileSettings clamped = settings;
+	if (clamped.tileSize < 0)
+		clamped.tileSize = 0;
+	if (clamped.maxBytesPerFrame < 0)
+		clamped.maxBytesPerFrame = 0;
+	if (!(clamped.maxMillisecondsPerFrame > 0.0f))
+		clamped.maxMillisecondsPerFrame = 0.0f;
+
+	if (clamped.tileSize != m_Settings.tileSize)
+	{
+		// Force the grid to be rebuilt by the next ScheduleTiles
+		m_Width = m_Height = 0;
+		m_Columns = m_Rows = 0;
+	}
+	m_Settings = clamped;
+}
+
+
+void TextureTileScheduler::GetTileRect(int tile, PluginTextureRect& rect) const
+{
+	const int tileSize = m_Settings.tileSize;
+	rect.x = (tile % m_Columns) * tileSize;
+	rect.y = (tile / m_Columns) * tileSize;
+	rect.width = m_Width - rect.x < tileSize ? m_Width - rect.x : tileSize;
+	rect.height = m_Height - rect.y < tileSize ? m_Height - rect.y : tileSize;
+}
+
+
+void TextureTileScheduler::ScheduleTiles(int width, int height, PluginTextureFormat format, std::vector<PluginTextureRect>& outRects)
+{
+	outRects.clear();
+	m_ScheduledPixels = 0;
+	if (!IsEnabled() || width <= 0 || height <= 0)
+		return;
+
+	if (width != m_Width || height != m_Height || format != m_Format || m_Columns == 0)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_Format = format;
+		m_Columns = (width + m_Settings.tileSize - 1) / m_Settings.tileSize;
+		m_Rows = (height + m_Settings.tileSize - 1) / m_Settings.tileSize;
+		m_NextTile = 0;
+	}
+
+	const int tileCount = GetTileCount();
+	const long long bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	const double budgetMicroseconds = m_Settings.maxMillisecondsPerFrame * 1000.0;
+	long long pixels = 0;
+	while (int(outRects.size()) < tileCount)
+	{
+		PluginTextureRect rect;
+		GetTileRect(m_NextTile, rect);
+		const long long total = pixels + (long long)rect.width * rect.height;
+
+		// The first tile always goes, so that the refresh makes progress on any budget.
+		// Without an estimate yet, a time budget only lets that one through.
+		if (!outRects.empty())
+		{
+			if (m_Settings.maxBytesPerFrame > 0 && total * bytesPerPixel > m_Settings.maxBytesPerFrame)
+				break;
+			if (budgetMicroseconds > 0.0 && (m_MicrosecondsPerPixel <= 0.0 || total * m_MicrosecondsPerPixel > budgetMicroseconds))
+				break;
+		}
+
+		outRects.push_back(rect);
+		pixels = total;
+		m_NextTile = m_NextTile + 1 < tileCount ? m_NextTile + 1 : 0;
+	}
+	m_ScheduledPixels = pixels;
+}
+
+
+void TextureTileScheduler::ReportUpdateTime(double microseconds)
+{
+	if (m_ScheduledPixels <= 0 || microseconds < 0.0)
+		return;
+	const double sample = microseconds / double(m_ScheduledPixels);
+	if (m_MicrosecondsPerPixel > 0.0)
+		m_MicrosecondsPerPixel += (sample - m_MicrosecondsPerPixel) * kTileTimeSmoothing;
+	else
+		m_MicrosecondsPerPixel = sample;
+}
+
+
+void ModifyTextureTiles(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	TextureTileScheduler& scheduler)
+{
+	if (!textureHandle)
+		return;
+
+	// Only ever used from the render thread; kept around so that frames don't reallocate it
+	static std::vector<PluginTextureRect> tiles;
+	scheduler.ScheduleTiles(width, height, format, tiles);
+	if (tiles.empty())
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!ModifyTextureRegion(api, textureHandle, width, height, format, time, tiles.data(), int(tiles.size())))
+	{
+		// A backend without partial updates can only refresh all of it, which is tiling off;
+		// that time says nothing about the tiles, so it doesn't go into the estimate
+		ModifyTexturePixels(api, textureHandle, width, height, format, time);
+		return;
+	}
+	scheduler.ReportUpdateTime(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Time-sliced texture updates: the texture is split into square tiles and each render event
+// regenerates and uploads only the tiles that are due, round-robin, so that a very large
+// procedural texture costs a bounded slice of every frame instead of a spike. A full refresh
+// takes as many frames as it takes to get through all tiles; until then neighbouring tiles
+// show the plasma at slightly different times.
+//
+// The tiles due in a frame are picked against a byte budget (the pixel data uploaded) and a
+// time budget. Since the tiles of a frame go out in one region update, the time budget is
+// checked against an estimate of the update time per pixel, averaged over earlier frames.
+// At least one tile is updated every frame whatever the budgets, so the refresh never stalls.
+
+#include "PlatformBase.h"
+#include "RenderAPI.h"
+
+#include <vector>
+
+
+struct TextureTileSettings
+{
+	int tileSize;					// in pixels; 0 turns tiling off (the whole texture is updated each frame)
+	int maxBytesPerFrame;			// 0 for no byte budget
+	float maxMillisecondsPerFrame;	// 0 for no time budget
+};
+
+
+class TextureTileScheduler
+{
+public:
+	TextureTileScheduler();
+
+	// Restarts the round-robin from the first tile if the settings differ from the current ones.
+	void SetSettings(const TextureTileSettings& settings);
+	const TextureTileSettings& GetSettings() const { return m_Settings; }
+	bool IsEnabled() const { return m_Settings.tileSize > 0; }
+
+	// Replaces 'outRects' with the tiles due this frame, in row-major order from where the
+	// previous frame stopped, and moves the schedule past them. A texture of another size
+	// or format than the last one starts over from the first tile.
+	void ScheduleTiles(int width, int height, PluginTextureFormat format, std::vector<PluginTextureRect>& outRects);
+
+	// Time the update of the tiles of the last ScheduleTiles took; feeds the time budget.
+	void ReportUpdateTime(double microseconds);
+
+	int GetTileCount() const { return m_Columns * m_Rows; }
+	double GetMicrosecondsPerPixel() const { return m_MicrosecondsPerPixel; }
+
+private:
+	void GetTileRect(int tile, PluginTextureRect& rect) const;
+
+	TextureTileSettings m_Settings;
+	int m_Width;
+	int m_Height;
+	PluginTextureFormat m_Format;
+	int m_Columns;
+	int m_Rows;
+	int m_NextTile;
+	long long m_ScheduledPixels;	// by the last ScheduleTiles, for ReportUpdateTime
+	double m_MicrosecondsPerPixel;	// 0 until the first report
+};
+
+
+// ModifyTexturePixels for the tiles 'scheduler' has due this frame, timed for its time budget.
+// Goes through ModifyTextureRegion, so region updates or a BeginModifyTextures batch (D3D12);
+// a backend with neither gets the whole texture every frame, as with tiling off.
+void ModifyTextureTiles(RenderAPI* api, void* textureHandle, int width, int height, PluginTextureFormat format, float time,
+	TextureTileScheduler& scheduler);
@@ -0,0 +1,188 @@
+#include "PluginTrace.h"
+
+#if PLUGIN_TRACE
+
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+
+struct TraceEvent
+{
+	const char* name;
+	long long startNs;				// since the start of the trace
+	long long durationNs;
+	unsigned int frame;
+};
+
+// Events of one thread. Only the flush thread ever competes for the mutex, briefly,
+// to swap the events out.
+struct ThreadBuffer
+{
+	std::mutex mutex;
+	std::vector<TraceEvent> events;
+	unsigned int threadID;			// small sequential number, used as "tid"
+};
+
+
+std::atomic<bool> g_PluginTraceRunning(false);
+
+static std::atomic<unsigned int> s_Frame(0);
+static std::atomic<long long> s_EpochNs(0);
+
+// Buffers stay alive for the lifetime of the process, threads may outlive a trace
+static std::mutex s_BuffersMutex;
+static std::vector<ThreadBuffer*> s_Buffers;
+static thread_local ThreadBuffer* t_Buffer = NULL;
+
+// Start/Stop and the flush thread
+static std::mutex s_ControlMutex;
+static std::mutex s_FlushMutex;
+static std::condition_variable s_FlushCondition;
+static bool s_StopRequested = false;
+static std::thread s_FlushThread;
+static FILE* s_File = NULL;
+
+static const int kFlushIntervalMs = 100;
+
+
+static long long ToNanoseconds(std::chrono::steady_clock::time_point time)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+
+static ThreadBuffer* GetThreadBuffer()
+{
+	if (!t_Buffer)
+	{
+		ThreadBuffer* buffer = new ThreadBuffer();
+		std::lock_guard<std::mutex> lock(s_BuffersMutex);
+		buffer->threadID = (unsigned int)s_Buffers.size() + 1;
+		s_Buffers.push_back(buffer);
+		t_Buffer = buffer;
+	}
+	return t_Buffer;
+}
+
+
+void PluginTrace_AddEvent(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	const long long epoch = s_EpochNs.load(std::memory_order_relaxed);
+	TraceEvent event;
+	event.name = name;
+	event.startNs = ToNanoseconds(start) - epoch;
+	event.durationNs = ToNanoseconds(end) - ToNanoseconds(start);
+	event.frame = s_Frame.load(std::memory_order_relaxed);
+	if (event.startNs < 0)
+		return;
+
+	ThreadBuffer* buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer->mutex);
+	buffer->events.push_back(event);
+}
+
+
+void PluginTrace_NextFrame()
+{
+	s_Frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// Flush thread only
+static void WriteBufferedEvents()
+{
+	std::vector<ThreadBuffer*> buffers;
+	{
+		std::lock_guard<std::mutex> lock(s_BuffersMutex);
+		buffers = s_Buffers;
+	}
+
+	std::vector<TraceEvent> events;
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		{
+			std::lock_guard<std::mutex> lock(buffers[i]->mutex);
+			events.swap(buffers[i]->events);
+		}
+		for (size_t j = 0; j < events.size(); ++j)
+		{
+			const TraceEvent& e = events[j];
+			fprintf(s_File, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+				e.name, buffers[i]->threadID, e.startNs * 0.001, e.durationNs * 0.001, e.frame);
+		}
+		// The cleared storage goes to the next thread's buffer with the swap, so
+		// buffers keep their capacity instead of reallocating every flush
+		events.clear();
+	}
+	fflush(s_File);
+}
+
+
+static void FlushThreadMain()
+{
+	bool stop = false;
+	while (!stop)
+	{
+		{
+			std::unique_lock<std::mutex> lock(s_FlushMutex);
+			s_FlushCondition.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs), [] { return s_StopRequested; });
+			stop = s_StopRequested;
+		}
+		WriteBufferedEvents();
+	}
+}
+
+
+bool PluginTrace_Start(const char* path)
+{
+	std::lock_guard<std::mutex> control(s_ControlMutex);
+	if (g_PluginTraceRunning || !path)
+		return false;
+	s_File = fopen(path, "w");
+	if (!s_File)
+		return false;
+
+	// Drop whatever was recorded after the previous trace stopped
+	{
+		std::lock_guard<std::mutex> lock(s_BuffersMutex);
+		for (size_t i = 0; i < s_Buffers.size(); ++i)
+		{
+			std::lock_guard<std::mutex> bufferLock(s_Buffers[i]->mutex);
+			s_Buffers[i]->events.clear();
+		}
+	}
+
+	fprintf(s_File, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(s_File, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"RenderingPlugin\"}}");
+
+	s_EpochNs.store(ToNanoseconds(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+	s_StopRequested = false;
+	s_FlushThread = std::thread(FlushThreadMain);
+	g_PluginTraceRunning = true;
+	return true;
+}
+
+
+void PluginTrace_Stop()
+{
+	std::lock_guard<std::mutex> control(s_ControlMutex);
+	if (!g_PluginTraceRunning)
+		return;
+	g_PluginTraceRunning = false;
+
+	{
+		std::lock_guard<std::mutex> lock(s_FlushMutex);
+		s_StopRequested = true;
+	}
+	s_FlushCondition.notify_one();
+	s_FlushThread.join();
+
+	fprintf(s_File, "\n]}\n");
+	fclose(s_File);
+	s_File = NULL;
+}
+
+#endif // PLUGIN_TRACE
@@ -0,0 +1,69 @@
+#pragma once
+
+// Opt-in timeline of what the plugin does, written in the Chrome trace event format that
+// chrome://tracing and ui.perfetto.dev open. While a trace is running (StartPluginTrace,
+// see RenderingPlugin.cpp) every PLUGIN_TRACE_SCOPE records one event with its thread
+// and the plugin frame it belongs to. Events are buffered per thread and written to the
+// file by a background thread, so the threads being traced never wait for file I/O.
+//
+// When no trace is running a scope costs one relaxed atomic load. Building with
+// PLUGIN_TRACE=0 compiles the scopes out entirely.
+
+#include "PlatformBase.h"
+
+
+#if PLUGIN_TRACE
+
+#include <atomic>
+#include <chrono>
+
+// Control, from any thread. Start fails if a trace is already running or the file can't be created.
+bool PluginTrace_Start(const char* path);
+void PluginTrace_Stop();
+
+// Advances the frame number recorded with the events; called at the start of the render event.
+void PluginTrace_NextFrame();
+
+extern std::atomic<bool> g_PluginTraceRunning;
+
+inline bool PluginTrace_IsRunning()
+{
+	return g_PluginTraceRunning.load(std::memory_order_relaxed);
+}
+
+// Records a complete event. 'name' is not copied: pass a string literal.
+void PluginTrace_AddEvent(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+
+class PluginTraceScope
+{
+public:
+	explicit PluginTraceScope(const char* name) : m_Name(PluginTrace_IsRunning() ? name : NULL)
+	{
+		if (m_Name)
+			m_Start = std::chrono::steady_clock::now();
+	}
+	~PluginTraceScope()
+	{
+		if (m_Name)
+			PluginTrace_AddEvent(m_Name, m_Start, std::chrono::steady_clock::now());
+	}
+
+private:
+	const char* m_Name;
+	std::chrono::steady_clock::time_point m_Start;
+};
+
+#define PLUGIN_TRACE_CONCAT_(a, b) a##b
+#define PLUGIN_TRACE_CONCAT(a, b) PLUGIN_TRACE_CONCAT_(a, b)
+
+// Records the rest of the enclosing scope as an event called 'name'.
+#define PLUGIN_TRACE_SCOPE(name) PluginTraceScope PLUGIN_TRACE_CONCAT(pluginTraceScope, __LINE__)(name)
+#define PLUGIN_TRACE_NEXT_FRAME() PluginTrace_NextFrame()
+
+#else
+
+#define PLUGIN_TRACE_SCOPE(name) do { } while (0)
+#define PLUGIN_TRACE_NEXT_FRAME() do { } while (0)
+
+#endif // PLUGIN_TRACE
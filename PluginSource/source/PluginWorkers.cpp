@@ -0,0 +1,203 @@
+#include "PluginWorkers.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+struct WorkerJob
+{
+	PluginWorkerFunc func;
+	void* userData;
+	int count;
+	int rangeCount;
+};
+
+struct WorkerPool
+{
+	std::mutex callMutex;					// held by the ParallelFor using the workers, SetThreadCount and Shutdown
+	std::mutex mutex;						// guards everything below
+	std::condition_variable workCondition;
+	std::condition_variable doneCondition;
+	std::vector<std::thread> threads;
+	unsigned int generation;				// bumped for every job handed out
+	bool quit;
+	WorkerJob job;
+	int pendingRanges;						// ranges of the current job the workers haven't finished
+
+	WorkerPool() : generation(0), quit(false), pendingRanges(0) {}
+};
+
+// Never destroyed: worker threads may still be blocked on it while the process exits
+// without the plugin having been unloaded (the host tools do that)
+static WorkerPool& GetPool()
+{
+	static WorkerPool* pool = new WorkerPool();
+	return *pool;
+}
+
+// 0 until first resolved to the default; read from any thread
+static std::atomic<int> s_ThreadCount(0);
+
+
+static void GetRange(const WorkerJob& job, int index, int& begin, int& end)
+{
+	begin = int((long long)job.count * index / job.rangeCount);
+	end = int((long long)job.count * (index + 1) / job.rangeCount);
+}
+
+
+// Worker 'index' always takes range index + 1 of a job, range 0 is the calling thread's
+static void WorkerMain(int index, unsigned int generation)
+{
+	WorkerPool& pool = GetPool();
+	for (;;)
+	{
+		WorkerJob job;
+		{
+			std::unique_lock<std::mutex> lock(pool.mutex);
+			while (!pool.quit && pool.generation == generation)
+				pool.workCondition.wait(lock);
+			if (pool.quit)
+				return;
+			generation = pool.generation;
+			job = pool.job;
+		}
+
+		const int range = index + 1;
+		if (range >= job.rangeCount)
+			continue;
+		int begin, end;
+		GetRange(job, range, begin, end);
+		job.func(begin, end, job.userData);
+
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		if (--pool.pendingRanges == 0)
+			pool.doneCondition.notify_one();
+	}
+}
+
+
+// Both expect callMutex to be held
+static void StopWorkers(WorkerPool& pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.quit = true;
+	}
+	pool.workCondition.notify_all();
+	for (size_t i = 0; i < pool.threads.size(); ++i)
+		pool.threads[i].join();
+	pool.threads.clear();
+	pool.quit = false;
+}
+
+static void StartWorkers(WorkerPool& pool, int workerCount)
+{
+	StopWorkers(pool);
+	pool.threads.reserve(workerCount);
+	for (int i = 0; i < workerCount; ++i)
+		pool.threads.push_back(std::thread(WorkerMain, i, pool.generation));
+}
+
+
+// One per hardware thread, capped: the fill and the deformation are mostly bound by memory
+// bandwidth past a few threads, and the render thread shares the cores with Unity's own
+// threads. Provisional: the cap of 8 has not been measured on a multi-core machine yet (the
+// KernelBench thread sweep only ever ran on one core); tune it from that sweep, the "/Nt"
+// rows of KernelBench --threads N, on the target hardware.
+static int GetDefaultThreadCount()
+{
+	const int hardwareThreads = int(std::thread::hardware_concurrency());
+	if (hardwareThreads < 1)
+		return 1;
+	return hardwareThreads < kPluginWorkersMaxDefaultThreads ? hardwareThreads : kPluginWorkersMaxDefaultThreads;
+}
+
+
+void PluginWorkers_SetThreadCount(int count)
+{
+	if (count <= 0)
+		count = GetDefaultThreadCount();
+	if (count > kPluginWorkersMaxThreads)
+		count = kPluginWorkersMaxThreads;
+
+	WorkerPool& pool = GetPool();
+	std::lock_guard<std::mutex> callLock(pool.callMutex);
+	s_ThreadCount.store(count, std::memory_order_relaxed);
+	// Started again with the new count by the next ParallelFor that needs them
+	if (int(pool.threads.size()) != count - 1)
+		StopWorkers(pool);
+}
+
+
+int PluginWorkers_GetThreadCount()
+{
+	int count = s_ThreadCount.load(std::memory_order_relaxed);
+	if (count == 0)
+	{
+		int expected = 0;
+		s_ThreadCount.compare_exchange_strong(expected, GetDefaultThreadCount(), std::memory_order_relaxed);
+		count = s_ThreadCount.load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+
+void PluginWorkers_ParallelFor(int count, int minRangeSize, PluginWorkerFunc func, void* userData)
+{
+	if (count <= 0)
+		return;
+
+	// While another thread's job has the workers (the pipeline thread's fill and the render
+	// thread's extra textures, say), run this one inline instead of waiting for all of it
+	WorkerPool& pool = GetPool();
+	std::unique_lock<std::mutex> callLock(pool.callMutex, std::try_to_lock);
+	if (!callLock.owns_lock())
+	{
+		func(0, count, userData);
+		return;
+	}
+
+	const int threadCount = PluginWorkers_GetThreadCount();
+	int rangeCount = threadCount;
+	if (minRangeSize > 1 && count / minRangeSize < rangeCount)
+		rangeCount = count / minRangeSize;
+	if (rangeCount > count)
+		rangeCount = count;
+	if (rangeCount <= 1)
+	{
+		func(0, count, userData);
+		return;
+	}
+
+	if (int(pool.threads.size()) != threadCount - 1)
+		StartWorkers(pool, threadCount - 1);
+
+	WorkerJob job = { func, userData, count, rangeCount };
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.job = job;
+		pool.pendingRanges = rangeCount - 1;
+		++pool.generation;
+	}
+	pool.workCondition.notify_all();
+
+	int begin, end;
+	GetRange(job, 0, begin, end);
+	func(begin, end, userData);
+
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	while (pool.pendingRanges > 0)
+		pool.doneCondition.wait(lock);
+}
+
+
+void PluginWorkers_Shutdown()
+{
+	WorkerPool& pool = GetPool();
+	std::lock_guard<std::mutex> callLock(pool.callMutex);
+	StopWorkers(pool);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Persistent worker threads for splitting the plugin's per-frame CPU work (the texture
+// fill, the deformation of large meshes) across cores. The threads are started on first use and then sleep between frames,
+// so a frame only pays for waking them up, never for creating them.
+//
+// The render thread takes part in the work itself: with a thread count of N there are
+// N - 1 workers, and a count of 1 runs everything inline on the caller.
+
+#include "PlatformBase.h"
+
+
+// Called with a contiguous range [begin, end) of the items; may run on any thread.
+typedef void (*PluginWorkerFunc)(int begin, int end, void* userData);
+
+// Number of threads PluginWorkers_ParallelFor spreads work over, including the calling one.
+// 0 picks the default: the number of hardware threads, at most kPluginWorkersMaxDefaultThreads
+// (a provisional cap, see GetDefaultThreadCount).
+// Can be called from any thread; waits for a ParallelFor in progress to finish.
+void PluginWorkers_SetThreadCount(int count);
+int PluginWorkers_GetThreadCount();
+
+const int kPluginWorkersMaxDefaultThreads = 8;
+const int kPluginWorkersMaxThreads = 64;
+
+// Splits [0, count) into one range per thread, each at least 'minRangeSize' items (so small
+// jobs use fewer threads), runs 'func' on them and returns once all of them are done.
+// A call made while another thread's call is using the workers runs all of [0, count) inline
+// on the calling thread rather than waiting for it.
+void PluginWorkers_ParallelFor(int count, int minRangeSize, PluginWorkerFunc func, void* userData);
+
+// Stops and joins the worker threads; they are started again by the next ParallelFor.
+void PluginWorkers_Shutdown();
@@ -45,6 +45,49 @@ RenderAPI* CreateRenderAPI(UnityGfxRenderer apiType)
 	}
 #	endif // if SUPPORT_VULKAN
 
+#	if SUPPORT_NULL
+	if (apiType == kUnityGfxRendererNull)
+	{
+		extern RenderAPI* CreateRenderAPI_Null();
+		return CreateRenderAPI_Null();
+	}
+#	endif // if SUPPORT_NULL
+
 	// Unknown or unsupported graphics API
 	return NULL;
 }
+
+
+size_t LayoutPluginTextureRects(const PluginTextureRect* rects, int rectCount, int bytesPerPixel, int rowAlignment, int rectAlignment,
+	unsigned char* base, PluginTextureRectMemory* outMemory)
+{
+	size_t size = 0;
+	for (int i = 0; i < rectCount; ++i)
+	{
+		const int rowPitch = (rects[i].width * bytesPerPixel + rowAlignment - 1) & ~(rowAlignment - 1);
+		size = (size + rectAlignment - 1) & ~size_t(rectAlignment - 1);
+		if (outMemory)
+		{
+			outMemory[i].pixels = base ? base + size : NULL;
+			outMemory[i].rowPitch = rowPitch;
+		}
+		size += size_t(rowPitch) * rects[i].height;
+	}
+	return size;
+}
+
+
+size_t LayoutPluginTextureUpdates(const PluginTextureUpdate* updates, int updateCount, int rowAlignment, int rectAlignment,
+	unsigned char* base, PluginTextureRectMemory* outMemory)
+{
+	size_t size = 0;
+	for (int i = 0; i < updateCount; ++i)
+	{
+		const PluginTextureRect& rect = updates[i].rect;
+		size = (size + rectAlignment - 1) & ~size_t(rectAlignment - 1);
+		const size_t rectSize = LayoutPluginTextureRects(&rect, 1, GetPluginTextureFormatBytesPerPixel(updates[i].format), rowAlignment, 1,
+			base ? base + size : NULL, outMemory ? outMemory + i : NULL);
+		size += rectSize;
+	}
+	return size;
+}
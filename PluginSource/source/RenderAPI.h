@@ -6,6 +6,76 @@
 
 struct IUnityInterfaces;
 
+
+// Pixel formats the texture passed to SetTextureFromUnityWithFormat can have; values match
+// the TextureFormat enum in UseRenderingPlugin.cs. BeginModifyTexture hands out rows of
+// tightly packed pixels of that many bytes (plus whatever row padding the API needs).
+enum PluginTextureFormat
+{
+	kPluginTextureFormat_RGBA8,
+	kPluginTextureFormat_BGRA8,
+	kPluginTextureFormat_R8,
+	kPluginTextureFormat_RG8,
+	kPluginTextureFormatCount
+};
+
+inline int GetPluginTextureFormatBytesPerPixel(PluginTextureFormat format)
+{
+	switch (format)
+	{
+	case kPluginTextureFormat_R8: return 1;
+	case kPluginTextureFormat_RG8: return 2;
+	default: return 4;
+	}
+}
+
+
+// A rectangle of texture pixels; always inside the texture and not empty when passed to
+// BeginModifyTextureRegion.
+struct PluginTextureRect
+{
+	int x, y;
+	int width, height;
+};
+
+// Where the pixels of one rectangle go between BeginModifyTextureRegion and EndModifyTextureRegion.
+struct PluginTextureRectMemory
+{
+	unsigned char* pixels;		// first pixel of the rectangle
+	int rowPitch;
+};
+
+// Lays the rectangles out one after another from 'base', each with rows of its width rounded
+// up to rowAlignment bytes and starting at a multiple of rectAlignment bytes (both powers of
+// two), and fills outMemory. Returns the bytes needed in total; call with a NULL base first
+// to size the staging memory. Backends use it so that EndModifyTextureRegion finds the rects
+// where BeginModifyTextureRegion put them.
+size_t LayoutPluginTextureRects(const PluginTextureRect* rects, int rectCount, int bytesPerPixel, int rowAlignment, int rectAlignment,
+	unsigned char* base, PluginTextureRectMemory* outMemory);
+
+// One rectangle of one texture in a batch of texture updates, see RenderAPI::BeginModifyTextures.
+// The rectangle is inside the texture and not empty; a texture can have several, which then
+// follow each other in the batch.
+struct PluginTextureUpdate
+{
+	void* textureHandle;
+	int textureWidth, textureHeight;
+	PluginTextureFormat format;
+	PluginTextureRect rect;
+};
+
+// Same as LayoutPluginTextureRects, for the rectangles of a batch, each with the pixel size of its texture's format.
+size_t LayoutPluginTextureUpdates(const PluginTextureUpdate* updates, int updateCount, int rowAlignment, int rectAlignment,
+	unsigned char* base, PluginTextureRectMemory* outMemory);
+
+// Where the contents of one vertex buffer go in a batch of vertex buffer updates, see
+// RenderAPI::BeginModifyVertexBuffers.
+struct PluginVertexBufferMemory
+{
+	void* data;			// NULL if this buffer can't be modified
+	size_t size;		// of the buffer, in bytes
+};
+
 // Super-simple "graphics abstraction". This is nothing like how a proper platform abstraction layer would look like;
 // all this does is a base interface for whatever our plugin sample needs. Which is only "draw some triangles"
 // and "modify a texture" at this point.
@@ -32,13 +102,30 @@ public:
 	virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4) = 0;
 
 
-	// Begin modifying texture data. You need to pass texture width/height too, since some graphics APIs
+	// Begin modifying texture data. You need to pass texture width/height and format too, since some graphics APIs
 	// (e.g. OpenGL ES) do not have a good way to query that from the texture itself...
 	//
 	// Returns pointer into the data buffer to write into (or NULL on failure), and pitch in bytes of a single texture row.
-	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch) = 0;
+	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch) = 0;
 	// End modifying texture data.
-	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr) = 0;
+	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr) = 0;
+	// Same for only the given rectangles of the texture, all uploaded by one EndModifyTextureRegion:
+	// fills outMemory[i] with where to write the pixels of rects[i], and returns the staging memory
+	// to pass on to EndModifyTextureRegion (or NULL on failure). Returns NULL in backends that can
+	// only update whole textures; callers then fall back to BeginModifyTexture.
+	virtual void* BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory) { return NULL; }
+	virtual void EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, void* dataPtr) { }
+	// Same for any number of textures at once: fills outMemory[i] with where to write the pixels of
+	// updates[i], all in one staging memory, and EndModifyTextures records the copies into all of
+	// the textures as one batch. Returns NULL in backends that can't; callers then update the
+	// textures one by one.
+	virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory) { return NULL; }
+	virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr) { }
+	// Whether the memory the last BeginModifyTexture* call returned is write-combined (uncached, like a mapped
+	// upload heap): it should then be written in whole cache lines, and never read back.
+	virtual bool IsTextureMemoryWriteCombined() { return false; }
 
 
 	// Begin modifying vertex buffer data.
@@ -46,6 +133,11 @@ public:
 	virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize) = 0;
 	// End modifying vertex buffer data.
 	virtual void EndModifyVertexBuffer(void* bufferHandle) = 0;
+	// Same for any number of buffers at once: fills outMemory[i] for bufferHandles[i], all of them
+	// writable at the same time, and EndModifyVertexBuffers (with the same arguments) uploads them
+	// as one batch. Returns false in backends that can't; callers then update the buffers one by one.
+	virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory) { return false; }
+	virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory) { }
 
 	// Get the texture that's created natively
 	virtual void* getNativeTexture() { return nullptr; }
@@ -6,6 +6,7 @@
 #if SUPPORT_D3D11
 
 #include <assert.h>
+#include <vector>
 #include <d3d11.h>
 #include "Unity/IUnityGraphicsD3D11.h"
 
@@ -22,11 +23,19 @@ public:
 
 	virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4);
 
-	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch);
-	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch);
+	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, void* dataPtr);
+	virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr);
 
 	virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize);
 	virtual void EndModifyVertexBuffer(void* bufferHandle);
+	virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory);
+	virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory);
 
 private:
 	void CreateResources();
@@ -243,9 +252,9 @@ void RenderAPI_D3D11::DrawSimpleTriangles(const float worldMatrix[16], int trian
 }
 
 
-void* RenderAPI_D3D11::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch)
+void* RenderAPI_D3D11::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch)
 {
-	const int rowPitch = textureWidth * 4;
+	const int rowPitch = textureWidth * GetPluginTextureFormatBytesPerPixel(format);
 	// Just allocate a system memory buffer here for simplicity
 	unsigned char* data = new unsigned char[rowPitch * textureHeight];
 	*outRowPitch = rowPitch;
@@ -253,7 +262,7 @@ void* RenderAPI_D3D11::BeginModifyTexture(void* textureHandle, int textureWidth,
 }
 
 
-void RenderAPI_D3D11::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr)
+void RenderAPI_D3D11::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr)
 {
 	ID3D11Texture2D* d3dtex = (ID3D11Texture2D*)textureHandle;
 	assert(d3dtex);
@@ -267,6 +276,68 @@ void RenderAPI_D3D11::EndModifyTexture(void* textureHandle, int textureWidth, in
 }
 
 
+void* RenderAPI_D3D11::BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory)
+{
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	unsigned char* data = new unsigned char[LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, NULL, NULL)];
+	LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, data, outMemory);
+	return data;
+}
+
+
+void RenderAPI_D3D11::EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, void* dataPtr)
+{
+	ID3D11Texture2D* d3dtex = (ID3D11Texture2D*)textureHandle;
+	assert(d3dtex);
+
+	std::vector<PluginTextureRectMemory> memory(rectCount);
+	LayoutPluginTextureRects(rects, rectCount, GetPluginTextureFormatBytesPerPixel(format), 1, 4, (unsigned char*)dataPtr, memory.data());
+
+	ID3D11DeviceContext* ctx = NULL;
+	m_Device->GetImmediateContext(&ctx);
+	// One UpdateSubresource per rect, and free the memory buffer
+	for (int i = 0; i < rectCount; ++i)
+	{
+		const PluginTextureRect& rect = rects[i];
+		const D3D11_BOX box = { UINT(rect.x), UINT(rect.y), 0, UINT(rect.x + rect.width), UINT(rect.y + rect.height), 1 };
+		ctx->UpdateSubresource(d3dtex, 0, &box, memory[i].pixels, memory[i].rowPitch, 0);
+	}
+	delete[] (unsigned char*)dataPtr;
+	ctx->Release();
+}
+
+
+void* RenderAPI_D3D11::BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory)
+{
+	unsigned char* data = new unsigned char[LayoutPluginTextureUpdates(updates, updateCount, 1, 4, NULL, NULL)];
+	LayoutPluginTextureUpdates(updates, updateCount, 1, 4, data, outMemory);
+	return data;
+}
+
+
+void RenderAPI_D3D11::EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr)
+{
+	std::vector<PluginTextureRectMemory> memory(updateCount);
+	LayoutPluginTextureUpdates(updates, updateCount, 1, 4, (unsigned char*)dataPtr, memory.data());
+
+	ID3D11DeviceContext* ctx = NULL;
+	m_Device->GetImmediateContext(&ctx);
+	// One UpdateSubresource per rect on the same context, and free the memory buffer
+	for (int i = 0; i < updateCount; ++i)
+	{
+		ID3D11Texture2D* d3dtex = (ID3D11Texture2D*)updates[i].textureHandle;
+		assert(d3dtex);
+		const PluginTextureRect& rect = updates[i].rect;
+		const D3D11_BOX box = { UINT(rect.x), UINT(rect.y), 0, UINT(rect.x + rect.width), UINT(rect.y + rect.height), 1 };
+		ctx->UpdateSubresource(d3dtex, 0, &box, memory[i].pixels, memory[i].rowPitch, 0);
+	}
+	delete[] (unsigned char*)dataPtr;
+	ctx->Release();
+}
+
+
 void* RenderAPI_D3D11::BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize)
 {
 	ID3D11Buffer* d3dbuf = (ID3D11Buffer*)bufferHandle;
@@ -296,4 +367,37 @@ void RenderAPI_D3D11::EndModifyVertexBuffer(void* bufferHandle)
 	ctx->Release();
 }
 
+
+bool RenderAPI_D3D11::BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory)
+{
+	// Any number of buffers can be mapped at once; one context reference for all of them
+	ID3D11DeviceContext* ctx = NULL;
+	m_Device->GetImmediateContext(&ctx);
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		ID3D11Buffer* d3dbuf = (ID3D11Buffer*)bufferHandles[i];
+		D3D11_BUFFER_DESC desc;
+		d3dbuf->GetDesc(&desc);
+		outMemory[i].size = desc.ByteWidth;
+
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		outMemory[i].data = SUCCEEDED(ctx->Map(d3dbuf, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)) ? mapped.pData : NULL;
+	}
+	ctx->Release();
+	return true;
+}
+
+
+void RenderAPI_D3D11::EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory)
+{
+	ID3D11DeviceContext* ctx = NULL;
+	m_Device->GetImmediateContext(&ctx);
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		if (memory[i].data)
+			ctx->Unmap((ID3D11Buffer*)bufferHandles[i], 0);
+	}
+	ctx->Release();
+}
+
 #endif // #if SUPPORT_D3D11
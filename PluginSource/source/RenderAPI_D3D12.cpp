@@ -24,7 +24,9 @@
 #define D3D12_DEFAULT_HEAP_TRIANGLE_BUFFER_NAME L"Native Plugin Default Heap Triangle Vertex Buffer"
 #define D3D12_UPLOAD_HEAP_TRIANGLE_BUFFER_NAME L"Native Plugin Upload Heap Triangle Vertex Buffer"
 #define D3D12_UPLOAD_HEAP_TEXTURE_BUFFER_NAME L"Native Plugin Upload Heap Texture"
+#define D3D12_UPLOAD_HEAP_TEXTURE_BATCH_BUFFER_NAME L"Native Plugin Upload Heap Texture Batch"
 #define D3D12_UPLOAD_HEAP_VERTEX_BUFFER_NAME L"Native Plugin Upload Heap Vertex Buffer"
+#define D3D12_UPLOAD_HEAP_VERTEX_BATCH_BUFFER_NAME L"Native Plugin Upload Heap Vertex Buffer Batch"
 
 // Compiled from:
 /*
@@ -321,10 +323,18 @@ public:
     virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4) override;
 
     // These demonstrate how to submit work via ExecuteCommandList
-    virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch) override;
-    virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr) override;
+    virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch) override;
+    virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr) override;
+    // All textures of a batch in one command list, with its own upload heap and fence
+    virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory) override;
+    virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr) override;
+    // The upload heap is write-combined CPU memory
+    virtual bool IsTextureMemoryWriteCombined() override { return true; }
     virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize) override;
     virtual void EndModifyVertexBuffer(void* bufferHandle) override;
+    // All buffers of a batch in one upload heap and one command list, with its own fence
+    virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory) override;
+    virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory) override;
     virtual void drawToRenderTexture() override;
     //-----------------------------------------------------------
 
@@ -393,6 +403,9 @@ private:
 
     void transition_barrier(ID3D12GraphicsCommandList* cmd, ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
 
+    // Offsets of the buffers in the vertex batch upload heap, each on a kVertexBatchAlignment boundary; returns the heap size needed
+    UINT64 layout_vertex_batch(void* const* bufferHandles, int bufferCount, std::vector<UINT64>& offsets);
+
     // When unity frame fence changes we can be sure that previously submitted command lists have finished executing
     void wait_for_unity_frame_fence(UINT64 fence_value);
 
@@ -408,7 +421,9 @@ private:
     IUnityGraphicsD3D12v7*         s_d3d12;
 
     ID3D12Resource*                s_upload_texture;
+    ID3D12Resource*                s_upload_texture_batch;
     ID3D12Resource*                s_upload_buffer;
+    ID3D12Resource*                s_upload_vertex_batch;
     ID3D12PipelineState*           m_triangle_pso;
     D3D12_INPUT_ELEMENT_DESC       m_triangle_layout[2];
     ID3D12RootSignature*           m_triangle_rootsig;
@@ -445,8 +460,16 @@ private:
     ID3D12CommandAllocator*        m_texture_copy_cmd_allocator;
     ID3D12GraphicsCommandList*     m_texture_copy_cmd_list;
 
+    ID3D12CommandAllocator*        m_texture_batch_cmd_allocator;
+    ID3D12GraphicsCommandList*     m_texture_batch_cmd_list;
+
+    ID3D12CommandAllocator*        m_vertex_batch_cmd_allocator;
+    ID3D12GraphicsCommandList*     m_vertex_batch_cmd_list;
+
     UINT64                         m_vertex_copy_fence = 0;
     UINT64                         m_texture_copy_fence = 0;
+    UINT64                         m_texture_batch_fence = 0;
+    UINT64                         m_vertex_batch_fence = 0;
     UINT64                         m_render_texture_draw_fence = 0;
 
     HANDLE                         m_fence_event;
@@ -464,7 +487,9 @@ const UINT kNodeMask = 0;
 RenderAPI_D3D12::RenderAPI_D3D12()
     : s_d3d12(NULL)
     , s_upload_texture(NULL)
+    , s_upload_texture_batch(NULL)
     , s_upload_buffer(NULL)
+    , s_upload_vertex_batch(NULL)
     , m_triangle_pso(NULL)
     , m_triangle_rootsig(NULL)
     , m_triangle_rtv_desc_heap(NULL)
@@ -1068,19 +1093,37 @@ void RenderAPI_D3D12::initialize_and_create_resources()
     handle_hr(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_vertex_copy_cmd_allocator, nullptr, IID_PPV_ARGS(&m_vertex_copy_cmd_list)),
               "Failed to create vertex copy cmd list\n");
 
+    handle_hr(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_texture_batch_cmd_allocator)),
+              "Failed to create cmd allocator for texture batch\n");
+
+    handle_hr(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_texture_batch_cmd_allocator, nullptr, IID_PPV_ARGS(&m_texture_batch_cmd_list)),
+              "Failed to create texture batch cmd list\n");
+
+    handle_hr(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_vertex_batch_cmd_allocator)),
+              "Failed to create cmd allocator for vertex batch\n");
+
+    handle_hr(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_vertex_batch_cmd_allocator, nullptr, IID_PPV_ARGS(&m_vertex_batch_cmd_list)),
+              "Failed to create vertex batch cmd list\n");
+
     handle_hr(device->CreateFence(m_plugin_texture_fence_value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_plugin_texture_fence)),
              "Failed to create fence for plugin texture");
 
     m_texture_copy_cmd_allocator->SetName(L"texture copy cmd allocator");
+    m_texture_batch_cmd_allocator->SetName(L"texture batch cmd allocator");
     m_vertex_copy_cmd_allocator->SetName(L"vertex copy cmd allocator");
+    m_vertex_batch_cmd_allocator->SetName(L"vertex batch cmd allocator");
     m_render_texture_cmd_allocator->SetName(L"render texture cmd allocator");
 
     m_vertex_copy_cmd_list->SetName(L"vertex copy cmd list");
+    m_vertex_batch_cmd_list->SetName(L"vertex batch cmd list");
     m_texture_copy_cmd_list->SetName(L"texture copy cmd list");
+    m_texture_batch_cmd_list->SetName(L"texture batch cmd list");
     m_render_texture_cmd_list->SetName(L"render texture cmd list");
 
     handle_hr(m_vertex_copy_cmd_list->Close(), "Failed to close cmd list for vertex copy\n");
     handle_hr(m_texture_copy_cmd_list->Close(), "Failed to close cmd list for texture copy\n");
+    handle_hr(m_texture_batch_cmd_list->Close(), "Failed to close cmd list for texture batch\n");
+    handle_hr(m_vertex_batch_cmd_list->Close(), "Failed to close cmd list for vertex batch\n");
     handle_hr(m_render_texture_cmd_list->Close(), "Failed to close cmd list for render texture\n");
     handle_hr(m_plugin_texture_cmd_list->Close(), "Failed to close cmd list for plugin texture\n");
 
@@ -1133,11 +1176,17 @@ void RenderAPI_D3D12::release_resources()
     SAFE_RELEASE(m_triangle_rtv_desc_heap);
     SAFE_RELEASE(m_triangle_dsv_desc_heap);
     SAFE_RELEASE(s_upload_texture);
+    SAFE_RELEASE(s_upload_texture_batch);
     SAFE_RELEASE(s_upload_buffer);
+    SAFE_RELEASE(s_upload_vertex_batch);
     SAFE_RELEASE(m_vertex_copy_cmd_list);
     SAFE_RELEASE(m_texture_copy_cmd_list);
+    SAFE_RELEASE(m_texture_batch_cmd_list);
+    SAFE_RELEASE(m_vertex_batch_cmd_list);
     SAFE_RELEASE(m_vertex_copy_cmd_allocator);
     SAFE_RELEASE(m_texture_copy_cmd_allocator);
+    SAFE_RELEASE(m_texture_batch_cmd_allocator);
+    SAFE_RELEASE(m_vertex_batch_cmd_allocator);
 
     if (ID3D12Resource* plugin_texture = m_plugin_texture.load())
     {
@@ -1362,14 +1411,16 @@ DXGI_FORMAT RenderAPI_D3D12::typeless_fmt_to_typed(DXGI_FORMAT format)
      }
 }
 
-void* RenderAPI_D3D12::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch)
+void* RenderAPI_D3D12::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch)
 {
     wait_for_unity_frame_fence(m_texture_copy_fence);
 
     // Fill data
-    // Clamp to minimum rowPitch of RGBA32
-    *outRowPitch = static_cast<int>(max(align_pow2(textureWidth * 4), 256));
-    const UINT64 kDataSize = get_aligned_size(textureWidth, textureHeight, 4, *outRowPitch);
+    // Rows of the copy source have to start D3D12_TEXTURE_DATA_PITCH_ALIGNMENT bytes apart
+    const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+    const int pitchAlignment = D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+    *outRowPitch = (textureWidth * bytesPerPixel + pitchAlignment - 1) / pitchAlignment * pitchAlignment;
+    const UINT64 kDataSize = get_aligned_size(textureWidth, textureHeight, bytesPerPixel, *outRowPitch);
     if (!get_upload_resource(&s_upload_texture, kDataSize, D3D12_UPLOAD_HEAP_TEXTURE_BUFFER_NAME))
         return NULL;
 
@@ -1378,11 +1429,11 @@ void* RenderAPI_D3D12::BeginModifyTexture(void* textureHandle, int textureWidth,
     return mapped;
 }
 
-void RenderAPI_D3D12::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr)
+void RenderAPI_D3D12::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr)
 {
     ID3D12Device* device = s_d3d12->GetDevice();
 
-    const UINT64 kDataSize = get_aligned_size(textureWidth, textureHeight, 4, rowPitch);
+    const UINT64 kDataSize = get_aligned_size(textureWidth, textureHeight, GetPluginTextureFormatBytesPerPixel(format), rowPitch);
     if (!get_upload_resource(&s_upload_texture, kDataSize, D3D12_UPLOAD_HEAP_TEXTURE_BUFFER_NAME))
         return;
 
@@ -1397,6 +1448,8 @@ void RenderAPI_D3D12::EndModifyTexture(void* textureHandle, int textureWidth, in
     srcLoc.pResource = s_upload_texture;
     srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
     device->GetCopyableFootprints(&desc, 0, 1, 0, &srcLoc.PlacedFootprint, nullptr, nullptr, nullptr);
+    // The footprint's format comes from the texture, the row pitch is the one BeginModifyTexture handed out
+    srcLoc.PlacedFootprint.Footprint.RowPitch = rowPitch;
 
     D3D12_TEXTURE_COPY_LOCATION dstLoc = {};
     dstLoc.pResource = resource;
@@ -1418,6 +1471,97 @@ void RenderAPI_D3D12::EndModifyTexture(void* textureHandle, int textureWidth, in
     m_texture_copy_fence = submit_cmd_to_unity_worker(m_texture_copy_cmd_list, &resource_states, 1);
 }
 
+void* RenderAPI_D3D12::BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory)
+{
+    wait_for_unity_frame_fence(m_texture_batch_fence);
+
+    // Every rect starts D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT bytes into the upload heap, with
+    // rows D3D12_TEXTURE_DATA_PITCH_ALIGNMENT bytes apart
+    const int pitchAlignment = D3D12_TEXTURE_DATA_PITCH_ALIGNMENT;
+    const int placementAlignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+    const UINT64 kDataSize = LayoutPluginTextureUpdates(updates, updateCount, pitchAlignment, placementAlignment, NULL, NULL);
+    if (kDataSize == 0)
+        return NULL;
+
+    // The heap only grows, to the next power of two; the last copy out of it is done (see above)
+    if (s_upload_texture_batch && s_upload_texture_batch->GetDesc().Width < kDataSize)
+    {
+        SAFE_RELEASE(s_upload_texture_batch);
+    }
+    if (!s_upload_texture_batch && !get_upload_resource(&s_upload_texture_batch, align_pow2(kDataSize), D3D12_UPLOAD_HEAP_TEXTURE_BATCH_BUFFER_NAME))
+        return NULL;
+
+    void* mapped = NULL;
+    s_upload_texture_batch->Map(0, NULL, &mapped);
+    if (mapped)
+        LayoutPluginTextureUpdates(updates, updateCount, pitchAlignment, placementAlignment, (unsigned char*)mapped, outMemory);
+    return mapped;
+}
+
+void RenderAPI_D3D12::EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr)
+{
+    ID3D12Device* device = s_d3d12->GetDevice();
+    s_upload_texture_batch->Unmap(0, 0);
+
+    std::vector<PluginTextureRectMemory> memory(updateCount);
+    LayoutPluginTextureUpdates(updates, updateCount, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT,
+        (unsigned char*)dataPtr, memory.data());
+
+    // Each texture once, for the barriers and for Unity's resource state tracking
+    std::vector<UnityGraphicsD3D12ResourceState> resource_states;
+    for (int i = 0; i < updateCount; ++i)
+    {
+        ID3D12Resource* resource = (ID3D12Resource*)updates[i].textureHandle;
+        bool listed = false;
+        for (size_t j = 0; j < resource_states.size() && !listed; ++j)
+            listed = resource_states[j].resource == resource;
+        if (listed)
+            continue;
+
+        UnityGraphicsD3D12ResourceState state = {};
+        state.resource = resource;
+        state.expected = D3D12_RESOURCE_STATE_COMMON;
+        state.current = D3D12_RESOURCE_STATE_COMMON;
+        resource_states.push_back(state);
+    }
+
+    m_texture_batch_cmd_allocator->Reset();
+    m_texture_batch_cmd_list->Reset(m_texture_batch_cmd_allocator, nullptr);
+    for (size_t i = 0; i < resource_states.size(); ++i)
+        transition_barrier(m_texture_batch_cmd_list, resource_states[i].resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    for (int i = 0; i < updateCount; ++i)
+    {
+        ID3D12Resource* resource = (ID3D12Resource*)updates[i].textureHandle;
+        const PluginTextureRect& rect = updates[i].rect;
+        D3D12_RESOURCE_DESC desc = resource->GetDesc();
+
+        // The footprint's format comes from the texture; its size, pitch and offset are the rect's in the upload heap
+        D3D12_TEXTURE_COPY_LOCATION srcLoc = {};
+        srcLoc.pResource = s_upload_texture_batch;
+        srcLoc.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        device->GetCopyableFootprints(&desc, 0, 1, 0, &srcLoc.PlacedFootprint, nullptr, nullptr, nullptr);
+        srcLoc.PlacedFootprint.Offset = UINT64(memory[i].pixels - (unsigned char*)dataPtr);
+        srcLoc.PlacedFootprint.Footprint.Width = rect.width;
+        srcLoc.PlacedFootprint.Footprint.Height = rect.height;
+        srcLoc.PlacedFootprint.Footprint.Depth = 1;
+        srcLoc.PlacedFootprint.Footprint.RowPitch = memory[i].rowPitch;
+
+        D3D12_TEXTURE_COPY_LOCATION dstLoc = {};
+        dstLoc.pResource = resource;
+        dstLoc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        dstLoc.SubresourceIndex = 0;
+
+        m_texture_batch_cmd_list->CopyTextureRegion(&dstLoc, rect.x, rect.y, 0, &srcLoc, nullptr);
+    }
+
+    for (size_t i = 0; i < resource_states.size(); ++i)
+        transition_barrier(m_texture_batch_cmd_list, resource_states[i].resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
+    m_texture_batch_cmd_list->Close();
+
+    m_texture_batch_fence = submit_cmd_to_unity_worker(m_texture_batch_cmd_list, resource_states.data(), int(resource_states.size()));
+}
+
 void* RenderAPI_D3D12::BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize)
 {
     wait_for_unity_frame_fence(m_vertex_copy_fence);
@@ -1488,6 +1632,91 @@ void RenderAPI_D3D12::EndModifyVertexBuffer(void* bufferHandle)
     m_vertex_copy_fence = submit_cmd_to_unity_worker(m_vertex_copy_cmd_list, &resource_states, 1);
 }
 
+// Cache line multiple, so that the plugin's threads writing neighbouring buffers never share a line
+static const UINT64 kVertexBatchAlignment = 256;
+
+UINT64 RenderAPI_D3D12::layout_vertex_batch(void* const* bufferHandles, int bufferCount, std::vector<UINT64>& offsets)
+{
+    offsets.resize(bufferCount);
+    UINT64 size = 0;
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        offsets[i] = size;
+        size += (reinterpret_cast<ID3D12Resource*>(bufferHandles[i])->GetDesc().Width + kVertexBatchAlignment - 1) & ~(kVertexBatchAlignment - 1);
+    }
+    return size;
+}
+
+bool RenderAPI_D3D12::BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory)
+{
+    wait_for_unity_frame_fence(m_vertex_batch_fence);
+
+    std::vector<UINT64> offsets;
+    const UINT64 kDataSize = layout_vertex_batch(bufferHandles, bufferCount, offsets);
+    if (kDataSize == 0)
+        return false;
+
+    // The heap only grows, to the next power of two; the last copy out of it is done (see above)
+    if (s_upload_vertex_batch && s_upload_vertex_batch->GetDesc().Width < kDataSize)
+    {
+        SAFE_RELEASE(s_upload_vertex_batch);
+    }
+    if (!s_upload_vertex_batch && !get_upload_resource(&s_upload_vertex_batch, align_pow2(kDataSize), D3D12_UPLOAD_HEAP_VERTEX_BATCH_BUFFER_NAME))
+        return false;
+
+    void* mapped = NULL;
+    s_upload_vertex_batch->Map(0, NULL, &mapped);
+    if (!mapped)
+        return false;
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        outMemory[i].data = static_cast<unsigned char*>(mapped) + offsets[i];
+        outMemory[i].size = static_cast<size_t>(reinterpret_cast<ID3D12Resource*>(bufferHandles[i])->GetDesc().Width);
+    }
+    return true;
+}
+
+void RenderAPI_D3D12::EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory)
+{
+    s_upload_vertex_batch->Unmap(0, 0);
+
+    std::vector<UINT64> offsets;
+    layout_vertex_batch(bufferHandles, bufferCount, offsets);
+
+    // Only buffers in a default heap need the barriers and Unity's resource state tracking, see EndModifyVertexBuffer
+    std::vector<UnityGraphicsD3D12ResourceState> resource_states;
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        ID3D12Resource* buffer = reinterpret_cast<ID3D12Resource*>(bufferHandles[i]);
+        D3D12_HEAP_PROPERTIES heap_props;
+        if (!memory[i].data || FAILED(buffer->GetHeapProperties(&heap_props, nullptr)) || heap_props.Type != D3D12_HEAP_TYPE_DEFAULT)
+            continue;
+
+        UnityGraphicsD3D12ResourceState state = {};
+        state.resource = buffer;
+        state.expected = D3D12_RESOURCE_STATE_COMMON;
+        state.current = D3D12_RESOURCE_STATE_COMMON;
+        resource_states.push_back(state);
+    }
+
+    m_vertex_batch_cmd_allocator->Reset();
+    m_vertex_batch_cmd_list->Reset(m_vertex_batch_cmd_allocator, nullptr);
+    for (size_t i = 0; i < resource_states.size(); ++i)
+        transition_barrier(m_vertex_batch_cmd_list, resource_states[i].resource, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        if (memory[i].data)
+            m_vertex_batch_cmd_list->CopyBufferRegion(reinterpret_cast<ID3D12Resource*>(bufferHandles[i]), 0, s_upload_vertex_batch, offsets[i], memory[i].size);
+    }
+
+    for (size_t i = 0; i < resource_states.size(); ++i)
+        transition_barrier(m_vertex_batch_cmd_list, resource_states[i].resource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON);
+    handle_hr(m_vertex_batch_cmd_list->Close(), "Failed to close vertex batch cmd list");
+
+    m_vertex_batch_fence = submit_cmd_to_unity_worker(m_vertex_batch_cmd_list, resource_states.data(), int(resource_states.size()));
+}
+
 void RenderAPI_D3D12::drawToPluginTexture()
 {
     if (!m_plugin_texture)
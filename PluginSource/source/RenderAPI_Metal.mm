@@ -10,6 +10,7 @@
 
 #include "Unity/IUnityGraphicsMetal.h"
 #import <Metal/Metal.h>
+#include <vector>
 
 
 class RenderAPI_Metal : public RenderAPI
@@ -24,11 +25,19 @@ public:
 
 	virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4);
 
-	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch);
-	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch);
+	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, void* dataPtr);
+	virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr);
 
 	virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize);
 	virtual void EndModifyVertexBuffer(void* bufferHandle);
+	virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory);
+	virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory);
 
 private:
 	void CreateResources();
@@ -219,9 +228,9 @@ void RenderAPI_Metal::DrawSimpleTriangles(const float worldMatrix[16], int trian
 }
 
 
-void* RenderAPI_Metal::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch)
+void* RenderAPI_Metal::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch)
 {
-	const int rowPitch = textureWidth * 4;
+	const int rowPitch = textureWidth * GetPluginTextureFormatBytesPerPixel(format);
 	// Just allocate a system memory buffer here for simplicity
 	unsigned char* data = new unsigned char[rowPitch * textureHeight];
 	*outRowPitch = rowPitch;
@@ -229,7 +238,7 @@ void* RenderAPI_Metal::BeginModifyTexture(void* textureHandle, int textureWidth,
 }
 
 
-void RenderAPI_Metal::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr)
+void RenderAPI_Metal::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr)
 {
 	id<MTLTexture> tex = (__bridge id<MTLTexture>)textureHandle;
 	// Update texture data, and free the memory buffer
@@ -238,6 +247,55 @@ void RenderAPI_Metal::EndModifyTexture(void* textureHandle, int textureWidth, in
 }
 
 
+void* RenderAPI_Metal::BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory)
+{
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	unsigned char* data = new unsigned char[LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, NULL, NULL)];
+	LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, data, outMemory);
+	return data;
+}
+
+
+void RenderAPI_Metal::EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, void* dataPtr)
+{
+	id<MTLTexture> tex = (__bridge id<MTLTexture>)textureHandle;
+	std::vector<PluginTextureRectMemory> memory(rectCount);
+	LayoutPluginTextureRects(rects, rectCount, GetPluginTextureFormatBytesPerPixel(format), 1, 4, (unsigned char*)dataPtr, memory.data());
+	// One replaceRegion per rect, and free the memory buffer
+	for (int i = 0; i < rectCount; ++i)
+	{
+		const PluginTextureRect& rect = rects[i];
+		[tex replaceRegion:MTLRegionMake3D(rect.x,rect.y,0, rect.width,rect.height,1) mipmapLevel:0 withBytes:memory[i].pixels bytesPerRow:memory[i].rowPitch];
+	}
+	delete[](unsigned char*)dataPtr;
+}
+
+
+void* RenderAPI_Metal::BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory)
+{
+	unsigned char* data = new unsigned char[LayoutPluginTextureUpdates(updates, updateCount, 1, 4, NULL, NULL)];
+	LayoutPluginTextureUpdates(updates, updateCount, 1, 4, data, outMemory);
+	return data;
+}
+
+
+void RenderAPI_Metal::EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr)
+{
+	std::vector<PluginTextureRectMemory> memory(updateCount);
+	LayoutPluginTextureUpdates(updates, updateCount, 1, 4, (unsigned char*)dataPtr, memory.data());
+	// One replaceRegion per rect, and free the memory buffer
+	for (int i = 0; i < updateCount; ++i)
+	{
+		id<MTLTexture> tex = (__bridge id<MTLTexture>)updates[i].textureHandle;
+		const PluginTextureRect& rect = updates[i].rect;
+		[tex replaceRegion:MTLRegionMake3D(rect.x,rect.y,0, rect.width,rect.height,1) mipmapLevel:0 withBytes:memory[i].pixels bytesPerRow:memory[i].rowPitch];
+	}
+	delete[](unsigned char*)dataPtr;
+}
+
+
 void* RenderAPI_Metal::BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize)
 {
 	id<MTLBuffer> buf = (__bridge id<MTLBuffer>)bufferHandle;
@@ -255,4 +313,26 @@ void RenderAPI_Metal::EndModifyVertexBuffer(void* bufferHandle)
 }
 
 
+bool RenderAPI_Metal::BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory)
+{
+	// Shared / managed buffers are always mapped, all of them at once
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		outMemory[i].size = 0;
+		outMemory[i].data = BeginModifyVertexBuffer(bufferHandles[i], &outMemory[i].size);
+	}
+	return true;
+}
+
+
+void RenderAPI_Metal::EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory)
+{
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		if (memory[i].data)
+			EndModifyVertexBuffer(bufferHandles[i]);
+	}
+}
+
+
 #endif // #if SUPPORT_METAL
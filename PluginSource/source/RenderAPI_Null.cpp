@@ -0,0 +1,258 @@
+#include "RenderAPI.h"
+#include "PlatformBase.h"
+
+// CPU-only implementation of RenderAPI for the "null" graphics device.
+// All texture and buffer updates go to host memory (see RenderAPI_Null.h),
+// which lets the plugin's CPU work run and be measured without any GPU.
+
+
+#if SUPPORT_NULL
+
+#include "RenderAPI_Null.h"
+
+#include <string.h>
+
+
+class RenderAPI_Null : public RenderAPI
+{
+public:
+	RenderAPI_Null();
+	virtual ~RenderAPI_Null() { }
+
+	virtual void ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityInterfaces* interfaces);
+
+	virtual bool GetUsesReverseZ() { return false; }
+
+	virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4);
+
+	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch);
+	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, void* dataPtr);
+	virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr);
+
+	virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize);
+	virtual void EndModifyVertexBuffer(void* bufferHandle);
+	virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory);
+	virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory);
+
+private:
+	// Stands in for the upload heap / staging buffer of the real backends
+	std::vector<unsigned char> m_TextureStaging;
+	// "Vertex shader" output of DrawSimpleTriangles, float4 clip space position per vertex
+	std::vector<float> m_TransformedVertices;
+};
+
+
+RenderAPI* CreateRenderAPI_Null()
+{
+	return new RenderAPI_Null();
+}
+
+
+RenderAPI_Null::RenderAPI_Null()
+{
+}
+
+
+void RenderAPI_Null::ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityInterfaces* interfaces)
+{
+	if (type == kUnityGfxDeviceEventShutdown)
+	{
+		m_TextureStaging.clear();
+		m_TransformedVertices.clear();
+	}
+}
+
+
+void RenderAPI_Null::DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4)
+{
+	// Nothing to rasterize into; just do the vertex transform a GPU would do, so
+	// the data passed in is actually consumed.
+	const int kVertexSize = 12 + 4 + 8;
+	const int vertexCount = triangleCount * 3;
+	m_TransformedVertices.resize(vertexCount * 4);
+
+	const unsigned char* src = (const unsigned char*)verticesFloat3Byte4;
+	float* dst = m_TransformedVertices.data();
+	for (int i = 0; i < vertexCount; ++i)
+	{
+		float pos[3];
+		memcpy(pos, src, sizeof(pos));
+		for (int row = 0; row < 4; ++row)
+			dst[row] = worldMatrix[row] * pos[0] + worldMatrix[4 + row] * pos[1] + worldMatrix[8 + row] * pos[2] + worldMatrix[12 + row];
+		src += kVertexSize;
+		dst += 4;
+	}
+}
+
+
+void* RenderAPI_Null::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch)
+{
+	NullTexture* texture = (NullTexture*)textureHandle;
+	if (!texture || textureWidth <= 0 || textureHeight <= 0)
+		return NULL;
+
+	const int rowPitch = textureWidth * GetPluginTextureFormatBytesPerPixel(format);
+	m_TextureStaging.resize(size_t(rowPitch) * textureHeight);
+	*outRowPitch = rowPitch;
+	return m_TextureStaging.data();
+}
+
+
+// Makes the texture match the size and format of an update
+static void PrepareNullTexture(NullTexture* texture, int width, int height, int bytesPerPixel)
+{
+	if (texture->width != width || texture->height != height || texture->bytesPerPixel != bytesPerPixel)
+	{
+		texture->width = width;
+		texture->height = height;
+		texture->bytesPerPixel = bytesPerPixel;
+		texture->pixels.resize(size_t(width) * height * bytesPerPixel);
+	}
+}
+
+// "Uploads" a width x height rectangle of staging data to (x, y) of the texture
+static void CopyToNullTexture(NullTexture* texture, int x, int y, int width, int height, const unsigned char* src, int srcPitch)
+{
+	const size_t dstPitch = size_t(texture->width) * texture->bytesPerPixel;
+	const size_t rowSize = size_t(width) * texture->bytesPerPixel;
+	unsigned char* dst = texture->pixels.data() + size_t(y) * dstPitch + size_t(x) * texture->bytesPerPixel;
+	for (int row = 0; row < height; ++row)
+	{
+		memcpy(dst, src, rowSize);
+		src += srcPitch;
+		dst += dstPitch;
+	}
+}
+
+static void FinishNullTextureUpdate(NullTexture* texture)
+{
+	++texture->updateCount;
+	if (texture->computeChecksum)
+		texture->checksum = NullChecksum(texture->pixels.data(), texture->pixels.size());
+}
+
+
+void RenderAPI_Null::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr)
+{
+	NullTexture* texture = (NullTexture*)textureHandle;
+	if (!texture || !dataPtr || textureWidth <= 0 || textureHeight <= 0)
+		return;
+
+	PrepareNullTexture(texture, textureWidth, textureHeight, GetPluginTextureFormatBytesPerPixel(format));
+	CopyToNullTexture(texture, 0, 0, textureWidth, textureHeight, (const unsigned char*)dataPtr, rowPitch);
+	FinishNullTextureUpdate(texture);
+}
+
+
+// Rects start 4 byte aligned, like in the Vulkan staging buffer
+static const int kNullRectAlignment = 4;
+
+void* RenderAPI_Null::BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory)
+{
+	NullTexture* texture = (NullTexture*)textureHandle;
+	if (!texture || textureWidth <= 0 || textureHeight <= 0 || rectCount <= 0)
+		return NULL;
+
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	m_TextureStaging.resize(LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, kNullRectAlignment, NULL, NULL));
+	LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, kNullRectAlignment, m_TextureStaging.data(), outMemory);
+	return m_TextureStaging.data();
+}
+
+
+void RenderAPI_Null::EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, void* dataPtr)
+{
+	NullTexture* texture = (NullTexture*)textureHandle;
+	if (!texture || !dataPtr || textureWidth <= 0 || textureHeight <= 0 || rectCount <= 0)
+		return;
+
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	PrepareNullTexture(texture, textureWidth, textureHeight, bytesPerPixel);
+
+	std::vector<PluginTextureRectMemory> memory(rectCount);
+	LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, kNullRectAlignment, (unsigned char*)dataPtr, memory.data());
+	for (int i = 0; i < rectCount; ++i)
+		CopyToNullTexture(texture, rects[i].x, rects[i].y, rects[i].width, rects[i].height, memory[i].pixels, memory[i].rowPitch);
+	FinishNullTextureUpdate(texture);
+}
+
+
+void* RenderAPI_Null::BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory)
+{
+	if (updateCount <= 0)
+		return NULL;
+
+	m_TextureStaging.resize(LayoutPluginTextureUpdates(updates, updateCount, 1, kNullRectAlignment, NULL, NULL));
+	LayoutPluginTextureUpdates(updates, updateCount, 1, kNullRectAlignment, m_TextureStaging.data(), outMemory);
+	return m_TextureStaging.data();
+}
+
+
+void RenderAPI_Null::EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr)
+{
+	std::vector<PluginTextureRectMemory> memory(updateCount);
+	LayoutPluginTextureUpdates(updates, updateCount, 1, kNullRectAlignment, (unsigned char*)dataPtr, memory.data());
+
+	// Each texture counts as updated once, however many rects it had in the batch
+	for (int begin = 0, end; begin < updateCount; begin = end)
+	{
+		NullTexture* texture = (NullTexture*)updates[begin].textureHandle;
+		PrepareNullTexture(texture, updates[begin].textureWidth, updates[begin].textureHeight, GetPluginTextureFormatBytesPerPixel(updates[begin].format));
+		for (end = begin; end < updateCount && updates[end].textureHandle == updates[begin].textureHandle; ++end)
+		{
+			const PluginTextureRect& rect = updates[end].rect;
+			CopyToNullTexture(texture, rect.x, rect.y, rect.width, rect.height, memory[end].pixels, memory[end].rowPitch);
+		}
+		FinishNullTextureUpdate(texture);
+	}
+}
+
+
+void* RenderAPI_Null::BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize)
+{
+	NullBuffer* buffer = (NullBuffer*)bufferHandle;
+	if (!buffer || buffer->data.empty())
+		return NULL;
+
+	*outBufferSize = buffer->data.size();
+	return buffer->data.data();
+}
+
+
+void RenderAPI_Null::EndModifyVertexBuffer(void* bufferHandle)
+{
+	NullBuffer* buffer = (NullBuffer*)bufferHandle;
+	++buffer->updateCount;
+	if (buffer->computeChecksum)
+		buffer->checksum = NullChecksum(buffer->data.data(), buffer->data.size());
+}
+
+
+bool RenderAPI_Null::BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory)
+{
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		outMemory[i].size = 0;
+		outMemory[i].data = BeginModifyVertexBuffer(bufferHandles[i], &outMemory[i].size);
+	}
+	return true;
+}
+
+
+void RenderAPI_Null::EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory)
+{
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		if (memory[i].data)
+			EndModifyVertexBuffer(bufferHandles[i]);
+	}
+}
+
+#endif // #if SUPPORT_NULL
@@ -0,0 +1,49 @@
+#pragma once
+
+// Native resources of the CPU-only "null" RenderAPI implementation.
+//
+// There is no graphics device behind the null renderer, so whoever drives the plugin
+// (the host tools) passes pointers to these wherever Unity would pass a native texture
+// or vertex buffer pointer. The plugin's texture and vertex updates then land in plain
+// host memory, where they can be inspected or checksummed.
+
+#include <stddef.h>
+#include <vector>
+
+
+struct NullTexture
+{
+	NullTexture() : width(0), height(0), bytesPerPixel(4), computeChecksum(false), checksum(0), updateCount(0) { }
+
+	int width;
+	int height;
+	int bytesPerPixel;					// of the format of the last update
+	std::vector<unsigned char> pixels; // width * height * bytesPerPixel bytes, tightly packed rows
+
+	bool computeChecksum;				// hash 'pixels' after every update?
+	unsigned int checksum;				// FNV-1a of the last update, when computeChecksum is set
+	unsigned int updateCount;
+};
+
+
+struct NullBuffer
+{
+	NullBuffer() : computeChecksum(false), checksum(0), updateCount(0) { }
+
+	std::vector<unsigned char> data;
+
+	bool computeChecksum;
+	unsigned int checksum;
+	unsigned int updateCount;
+};
+
+
+// FNV-1a hash, continuing from 'hash' (start with kNullChecksumSeed).
+const unsigned int kNullChecksumSeed = 2166136261u;
+inline unsigned int NullChecksum(const void* data, size_t size, unsigned int hash = kNullChecksumSeed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 16777619u;
+	return hash;
+}
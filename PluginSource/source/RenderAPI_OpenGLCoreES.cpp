@@ -1,5 +1,7 @@
 #include "RenderAPI.h"
 #include "PlatformBase.h"
+#include "PluginStats.h"
+#include "PluginTrace.h"
 
 // OpenGL Core profile (desktop) or OpenGL ES (mobile) implementation of RenderAPI.
 // Supports several flavors: Core, ES2, ES3
@@ -9,6 +11,7 @@
 
 
 #include <assert.h>
+#include <vector>
 #if UNITY_IOS || UNITY_TVOS
 #	include <OpenGLES/ES2/gl.h>
 #elif UNITY_ANDROID || UNITY_WEBGL
@@ -35,6 +38,47 @@
 #	error Unknown platform
 #endif
 
+// One and two channel upload formats: the GLES2 headers lack the GL 3 / ES 3 ones, the core
+// profile headers (OpenGL/gl3.h, gl3w) the ES 2 ones
+#ifndef GL_RED
+#	define GL_RED 0x1903
+#endif
+#ifndef GL_RG
+#	define GL_RG 0x8227
+#endif
+#ifndef GL_LUMINANCE
+#	define GL_LUMINANCE 0x1909
+#endif
+#ifndef GL_LUMINANCE_ALPHA
+#	define GL_LUMINANCE_ALPHA 0x190A
+#endif
+
+// GPU timers use GL_TIME_ELAPSED queries (GL 3.3 / ARB_timer_query), so only the core profile has them
+#define SUPPORT_GL_TIMERS (SUPPORT_OPENGL_CORE && PLUGIN_FRAME_STATS)
+
+
+// The plugin operations timed on the GPU. Map and unmap both count towards the vertex buffer stage.
+enum GLTimer
+{
+	kGLTimer_TexSubImage,
+	kGLTimer_Draw,
+	kGLTimer_MapBuffer,
+	kGLTimer_UnmapBuffer,
+	kGLTimerCount
+};
+
+// Queries of one timer that are in flight, oldest first. They are only read once
+// GL_QUERY_RESULT_AVAILABLE is set, so reading never waits for the GPU; when all of them
+// are still in flight, the operation goes untimed.
+const int kGLTimerQueryCount = 8;
+
+struct GLTimerRing
+{
+	GLuint queries[kGLTimerQueryCount];
+	int first;
+	int count;
+};
+
 
 class RenderAPI_OpenGLCoreES : public RenderAPI
 {
@@ -48,14 +92,27 @@ public:
 
 	virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4);
 
-	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch);
-	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch);
+	virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr);
+	virtual void* BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+		const PluginTextureRect* rects, int rectCount, void* dataPtr);
+	virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory);
+	virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr);
 
 	virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize);
 	virtual void EndModifyVertexBuffer(void* bufferHandle);
+	virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory);
+	virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory);
 
 private:
 	void CreateResources();
+	void CreateTimers();
+	void DestroyTimers();
+	void ReadTimers();
+	void BeginTimer(GLTimer timer);
+	void EndTimer();
 
 private:
 	UnityGfxRenderer m_APIType;
@@ -66,6 +123,9 @@ private:
 	GLuint m_VertexBuffer;
 	int m_UniformWorldMatrix;
 	int m_UniformProjMatrix;
+	GLTimerRing m_Timers[kGLTimerCount];
+	bool m_TimersCreated;
+	int m_ActiveTimer;		// only one GL_TIME_ELAPSED query can be active at a time, -1 if none
 };
 
 
@@ -191,15 +251,108 @@ void RenderAPI_OpenGLCoreES::CreateResources()
 	glBufferData(GL_ARRAY_BUFFER, 1024, NULL, GL_STREAM_DRAW);
 
 	assert(glGetError() == GL_NO_ERROR);
+
+	CreateTimers();
 }
 
 
 RenderAPI_OpenGLCoreES::RenderAPI_OpenGLCoreES(UnityGfxRenderer apiType)
 	: m_APIType(apiType)
+	, m_TimersCreated(false)
+	, m_ActiveTimer(-1)
 {
 }
 
 
+void RenderAPI_OpenGLCoreES::CreateTimers()
+{
+#	if SUPPORT_GL_TIMERS
+	if (m_APIType != kUnityGfxRendererOpenGLCore)
+		return;
+	for (int i = 0; i < kGLTimerCount; ++i)
+	{
+		glGenQueries(kGLTimerQueryCount, m_Timers[i].queries);
+		m_Timers[i].first = 0;
+		m_Timers[i].count = 0;
+	}
+	m_TimersCreated = true;
+#	endif
+}
+
+
+void RenderAPI_OpenGLCoreES::DestroyTimers()
+{
+#	if SUPPORT_GL_TIMERS
+	if (!m_TimersCreated)
+		return;
+	for (int i = 0; i < kGLTimerCount; ++i)
+		glDeleteQueries(kGLTimerQueryCount, m_Timers[i].queries);
+	m_TimersCreated = false;
+#	endif
+}
+
+
+// Hands the results that are ready over to the frame stats
+void RenderAPI_OpenGLCoreES::ReadTimers()
+{
+#	if SUPPORT_GL_TIMERS
+	static const PluginStage kTimerStages[kGLTimerCount] =
+	{
+		kPluginStage_GpuEndModifyTexture,
+		kPluginStage_GpuDrawSimpleTriangles,
+		kPluginStage_GpuModifyVertexBuffer,
+		kPluginStage_GpuModifyVertexBuffer,
+	};
+
+	for (int i = 0; i < kGLTimerCount; ++i)
+	{
+		GLTimerRing& ring = m_Timers[i];
+		while (ring.count > 0)
+		{
+			// Results become available in order, stop at the first one that isn't
+			const GLuint query = ring.queries[ring.first];
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				break;
+			GLuint64 nanoseconds = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+			PLUGIN_STATS_ADD_GPU_SAMPLE(kTimerStages[i], nanoseconds);
+			ring.first = (ring.first + 1) % kGLTimerQueryCount;
+			--ring.count;
+		}
+	}
+#	endif
+}
+
+
+void RenderAPI_OpenGLCoreES::BeginTimer(GLTimer timer)
+{
+#	if SUPPORT_GL_TIMERS
+	if (!m_TimersCreated || m_ActiveTimer >= 0)
+		return;
+	ReadTimers();
+	GLTimerRing& ring = m_Timers[timer];
+	if (ring.count == kGLTimerQueryCount)
+		return;
+	glBeginQuery(GL_TIME_ELAPSED, ring.queries[(ring.first + ring.count) % kGLTimerQueryCount]);
+	++ring.count;
+	m_ActiveTimer = timer;
+#	endif
+}
+
+
+void RenderAPI_OpenGLCoreES::EndTimer()
+{
+#	if SUPPORT_GL_TIMERS
+	if (m_ActiveTimer < 0)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	m_ActiveTimer = -1;
+#	endif
+}
+
+
 void RenderAPI_OpenGLCoreES::ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityInterfaces* interfaces)
 {
 	if (type == kUnityGfxDeviceEventInitialize)
@@ -209,6 +362,7 @@ void RenderAPI_OpenGLCoreES::ProcessDeviceEvent(UnityGfxDeviceEventType type, IU
 	else if (type == kUnityGfxDeviceEventShutdown)
 	{
 		//@TODO: release resources
+		DestroyTimers();
 	}
 }
 
@@ -248,7 +402,10 @@ void RenderAPI_OpenGLCoreES::DrawSimpleTriangles(const float worldMatrix[16], in
 	const int kVertexSize = 12 + 4;
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, kVertexSize * triangleCount * 3, verticesFloat3Byte4);
+	{
+		PLUGIN_TRACE_SCOPE("glBufferSubData");
+		glBufferSubData(GL_ARRAY_BUFFER, 0, kVertexSize * triangleCount * 3, verticesFloat3Byte4);
+	}
 
 	// Setup vertex layout
 	glEnableVertexAttribArray(kVertexInputPosition);
@@ -257,7 +414,9 @@ void RenderAPI_OpenGLCoreES::DrawSimpleTriangles(const float worldMatrix[16], in
 	glVertexAttribPointer(kVertexInputColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, kVertexSize, (char*)NULL + 12);
 
 	// Draw
+	BeginTimer(kGLTimer_Draw);
 	glDrawArrays(GL_TRIANGLES, 0, triangleCount * 3);
+	EndTimer();
 
 	// Cleanup VAO
 #	if SUPPORT_OPENGL_CORE
@@ -269,9 +428,9 @@ void RenderAPI_OpenGLCoreES::DrawSimpleTriangles(const float worldMatrix[16], in
 }
 
 
-void* RenderAPI_OpenGLCoreES::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch)
+void* RenderAPI_OpenGLCoreES::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch)
 {
-	const int rowPitch = textureWidth * 4;
+	const int rowPitch = textureWidth * GetPluginTextureFormatBytesPerPixel(format);
 	// Just allocate a system memory buffer here for simplicity
 	unsigned char* data = new unsigned char[rowPitch * textureHeight];
 	*outRowPitch = rowPitch;
@@ -279,15 +438,115 @@ void* RenderAPI_OpenGLCoreES::BeginModifyTexture(void* textureHandle, int textur
 }
 
 
-void RenderAPI_OpenGLCoreES::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr)
+// The plugin writes the same value into every channel, so BGRA8 data can go up as GL_RGBA
+// too (GL_BGRA is an extension on GLES). Unity creates R8 and RG8 textures as GL_R8 and GL_RG8
+// on core and ES 3 contexts, which only take GL_RED and GL_RG; only an ES 2 context, where
+// one and two channel textures are luminance ones, gets the luminance formats.
+static GLenum GetGLUploadFormat(UnityGfxRenderer apiType, PluginTextureFormat format)
+{
+	const bool redGreenFormats = apiType == kUnityGfxRendererOpenGLCore || apiType == kUnityGfxRendererOpenGLES30;
+	if (format == kPluginTextureFormat_R8)
+		return redGreenFormats ? GL_RED : GL_LUMINANCE;
+	if (format == kPluginTextureFormat_RG8)
+		return redGreenFormats ? GL_RG : GL_LUMINANCE_ALPHA;
+	return GL_RGBA;
+}
+
+
+void RenderAPI_OpenGLCoreES::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr)
 {
 	GLuint gltex = (GLuint)(size_t)(textureHandle);
+	// Rows of one and two byte pixels are tightly packed, not 4 byte aligned
+	const bool packedRows = (rowPitch & 3) != 0;
+
 	// Update texture data, and free the memory buffer
 	glBindTexture(GL_TEXTURE_2D, gltex);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureWidth, textureHeight, GL_RGBA, GL_UNSIGNED_BYTE, dataPtr);
+	if (packedRows)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	{
+		PLUGIN_TRACE_SCOPE("glTexSubImage2D");
+		BeginTimer(kGLTimer_TexSubImage);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, textureWidth, textureHeight, GetGLUploadFormat(m_APIType, format), GL_UNSIGNED_BYTE, dataPtr);
+		EndTimer();
+	}
+	if (packedRows)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	delete[](unsigned char*)dataPtr;
+}
+
+
+void* RenderAPI_OpenGLCoreES::BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory)
+{
+	// Like BeginModifyTexture, one system memory buffer, just with only the rects in it
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	unsigned char* data = new unsigned char[LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, NULL, NULL)];
+	LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, data, outMemory);
+	return data;
+}
+
+
+void RenderAPI_OpenGLCoreES::EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+	const PluginTextureRect* rects, int rectCount, void* dataPtr)
+{
+	GLuint gltex = (GLuint)(size_t)(textureHandle);
+	const GLenum glFormat = GetGLUploadFormat(m_APIType, format);
+	const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+	std::vector<PluginTextureRectMemory> memory(rectCount);
+	LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, 4, (unsigned char*)dataPtr, memory.data());
+
+	// One glTexSubImage2D per rect; the rows of each are tightly packed
+	glBindTexture(GL_TEXTURE_2D, gltex);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	{
+		PLUGIN_TRACE_SCOPE("glTexSubImage2D");
+		BeginTimer(kGLTimer_TexSubImage);
+		for (int i = 0; i < rectCount; ++i)
+		{
+			const PluginTextureRect& rect = rects[i];
+			glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, glFormat, GL_UNSIGNED_BYTE, memory[i].pixels);
+		}
+		EndTimer();
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	delete[](unsigned char*)dataPtr;
 }
 
+
+void* RenderAPI_OpenGLCoreES::BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory)
+{
+	// One system memory buffer for all of them
+	unsigned char* data = new unsigned char[LayoutPluginTextureUpdates(updates, updateCount, 1, 4, NULL, NULL)];
+	LayoutPluginTextureUpdates(updates, updateCount, 1, 4, data, outMemory);
+	return data;
+}
+
+
+void RenderAPI_OpenGLCoreES::EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr)
+{
+	std::vector<PluginTextureRectMemory> memory(updateCount);
+	LayoutPluginTextureUpdates(updates, updateCount, 1, 4, (unsigned char*)dataPtr, memory.data());
+
+	// One glTexSubImage2D per rect, binding each texture once
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	{
+		PLUGIN_TRACE_SCOPE("glTexSubImage2D");
+		BeginTimer(kGLTimer_TexSubImage);
+		for (int i = 0; i < updateCount; ++i)
+		{
+			const PluginTextureUpdate& update = updates[i];
+			if (i == 0 || update.textureHandle != updates[i - 1].textureHandle)
+				glBindTexture(GL_TEXTURE_2D, (GLuint)(size_t)update.textureHandle);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, update.rect.x, update.rect.y, update.rect.width, update.rect.height, GetGLUploadFormat(m_APIType, update.format),
+				GL_UNSIGNED_BYTE, memory[i].pixels);
+		}
+		EndTimer();
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	delete[](unsigned char*)dataPtr;
+}
+
+
 void* RenderAPI_OpenGLCoreES::BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize)
 {
 #	if SUPPORT_OPENGL_ES
@@ -297,7 +556,9 @@ void* RenderAPI_OpenGLCoreES::BeginModifyVertexBuffer(void* bufferHandle, size_t
 	GLint size = 0;
 	glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
 	*outBufferSize = size;
+	BeginTimer(kGLTimer_MapBuffer);
 	void* mapped = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+	EndTimer();
 	return mapped;
 #	endif
 }
@@ -306,8 +567,44 @@ void* RenderAPI_OpenGLCoreES::BeginModifyVertexBuffer(void* bufferHandle, size_t
 void RenderAPI_OpenGLCoreES::EndModifyVertexBuffer(void* bufferHandle)
 {
 #	if !SUPPORT_OPENGL_ES
+	PLUGIN_TRACE_SCOPE("glUnmapBuffer");
 	glBindBuffer(GL_ARRAY_BUFFER, (GLuint)(size_t)bufferHandle);
+	BeginTimer(kGLTimer_UnmapBuffer);
 	glUnmapBuffer(GL_ARRAY_BUFFER);
+	EndTimer();
+#	endif
+}
+
+
+bool RenderAPI_OpenGLCoreES::BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory)
+{
+#	if SUPPORT_OPENGL_ES
+	return false;
+#	else
+	// Every buffer stays mapped until EndModifyVertexBuffers, so that they can all be written at once
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		outMemory[i].size = 0;
+		outMemory[i].data = BeginModifyVertexBuffer(bufferHandles[i], &outMemory[i].size);
+	}
+	return true;
+#	endif
+}
+
+
+void RenderAPI_OpenGLCoreES::EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory)
+{
+#	if !SUPPORT_OPENGL_ES
+	PLUGIN_TRACE_SCOPE("glUnmapBuffer");
+	BeginTimer(kGLTimer_UnmapBuffer);
+	for (int i = 0; i < bufferCount; ++i)
+	{
+		if (!memory[i].data)
+			continue;
+		glBindBuffer(GL_ARRAY_BUFFER, (GLuint)(size_t)bufferHandles[i]);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	EndTimer();
 #	endif
 }
 
@@ -1,5 +1,8 @@
 #include "RenderAPI.h"
 #include "PlatformBase.h"
+#include "PluginMemory.h"
+#include "PluginStats.h"
+#include "PluginTrace.h"
 
 #if SUPPORT_VULKAN
 
@@ -32,6 +35,7 @@
     apply(vkDestroySampler); \
     apply(vkGetPhysicalDeviceMemoryProperties); \
     apply(vkGetPhysicalDeviceProperties); \
+    apply(vkGetPhysicalDeviceQueueFamilyProperties); \
     apply(vkGetBufferMemoryRequirements); \
     apply(vkGetImageMemoryRequirements); \
     apply(vkMapMemory); \
@@ -69,7 +73,12 @@
     apply(vkCmdBindDescriptorSets); \
     apply(vkCmdBindVertexBuffers); \
     apply(vkDestroyPipeline); \
-    apply(vkDestroyPipelineLayout);
+    apply(vkDestroyPipelineLayout); \
+    apply(vkCreateQueryPool); \
+    apply(vkDestroyQueryPool); \
+    apply(vkCmdResetQueryPool); \
+    apply(vkCmdWriteTimestamp); \
+    apply(vkGetQueryPoolResults);
     
 #define VULKAN_DEFINE_API_FUNCPTR(func) static PFN_##func func
 VULKAN_DEFINE_API_FUNCPTR(vkGetInstanceProcAddr);
@@ -178,6 +187,7 @@ struct VulkanBuffer
     VkDeviceSize sizeInBytes;
     VkDeviceSize deviceMemorySize;
     VkMemoryPropertyFlags deviceMemoryFlags;
+    PluginMemoryCategory memoryCategory;
 };
 
 struct VulkanImage
@@ -193,6 +203,7 @@ struct VulkanImage
 	VkImageLayout imageLayout;
 	VkImageAspectFlags aspectMask;
 	VkMemoryPropertyFlags deviceMemoryFlags;
+	VkDeviceSize deviceMemorySize;
 };
 
 static VkPipelineLayout CreateTrianglePipelineLayout(VkDevice device, VkDescriptorSetLayout& descriptorSetLayout)
@@ -572,10 +583,20 @@ public:
     virtual void ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityInterfaces* interfaces);
     virtual bool GetUsesReverseZ() { return true; }
     virtual void DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4);
-    virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch);
-    virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr);
+    virtual void* BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch);
+    virtual void EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr);
+    virtual void* BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+        const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory);
+    virtual void EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+        const PluginTextureRect* rects, int rectCount, void* dataPtr);
+    virtual void* BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory);
+    virtual void EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr);
+    // Host visible memory without HOST_CACHED is write-combined on the common drivers
+    virtual bool IsTextureMemoryWriteCombined() { return m_TextureStagingBuffer.mapped && !(m_TextureStagingBuffer.deviceMemoryFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT); }
     virtual void* BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize);
     virtual void EndModifyVertexBuffer(void* bufferHandle);
+    virtual bool BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory);
+    virtual void EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory);
     virtual void drawToRenderTexture();
     virtual void drawToPluginTexture();
     virtual void* getNativeTexture();
@@ -583,10 +604,41 @@ public:
 
 private:
     typedef std::vector<VulkanBuffer> VulkanBuffers;
+
+    // Regions of the texture staging buffer to copy into one texture
+    struct TextureCopy
+    {
+        void* textureHandle;
+        const VkBufferImageCopy* regions;
+        uint32_t regionCount;
+    };
     typedef std::map<unsigned long long, VulkanBuffers> DeleteQueue;
 
+    // GPU timers: a begin/end timestamp pair per pass, in a ring of frames. A frame's queries
+    // are read back once Unity reports the frame as safe, and reset (which has to happen
+    // outside of a render pass) the next time the plugin records outside of one.
+    enum GpuPass
+    {
+        kGpuPass_EndModifyTexture,
+        kGpuPass_DrawSimpleTriangles,
+        kGpuPassCount
+    };
+    enum GpuTimerState
+    {
+        kGpuTimer_NeedsReset,
+        kGpuTimer_Ready,
+        kGpuTimer_Recording
+    };
+    struct GpuTimerFrame
+    {
+        GpuTimerState state;
+        unsigned long long frameNumber;
+        uint32_t writtenPasses;         // bit per GpuPass
+    };
+    static const int kGpuTimerFrameCount = 4;
+
 private:
-    bool CreateVulkanBuffer(size_t bytes, VulkanBuffer* buffer, VkBufferUsageFlags usage);
+    bool CreateVulkanBuffer(size_t bytes, VulkanBuffer* buffer, VkBufferUsageFlags usage, PluginMemoryCategory memoryCategory);
     void ImmediateDestroyVulkanBuffer(const VulkanBuffer& buffer);
 	void ImmediateDestroyVulkanImage(const VulkanImage& image);
     void SafeDestroy(unsigned long long frameNumber, const VulkanBuffer& buffer);
@@ -602,6 +654,12 @@ private:
     void CreateDescriptorPool();
     void CreateDescriptorSets();
     void CopyFromBuffer(VulkanBuffer& buffer, VkImage& image, uint32_t width, uint32_t height);
+    void* CreateTextureStagingBuffer(size_t bytes);
+    void CopyTextureStagingBuffer(const TextureCopy* copies, int copyCount);
+    void CreateTimestampQueryPool();
+    void UpdateGpuTimers(const UnityVulkanRecordingState& recordingState);
+    bool BeginGpuTimer(const UnityVulkanRecordingState& recordingState, GpuPass pass, uint32_t* outQuery);
+    void EndGpuTimer(const UnityVulkanRecordingState& recordingState, uint32_t query);
 
 
 private:
@@ -621,6 +679,11 @@ private:
     VkDescriptorSetLayout m_DescriptorSetLayout;
     VkDescriptorPool m_DescriptorPool;
     std::vector<VkDescriptorSet> m_DescriptorSets;
+
+    VkQueryPool m_TimestampQueryPool;
+    double m_TimestampPeriod;           // nanoseconds per tick
+    uint64_t m_TimestampMask;
+    GpuTimerFrame m_GpuTimerFrames[kGpuTimerFrameCount];
 };
 
 
@@ -641,6 +704,9 @@ RenderAPI_Vulkan::RenderAPI_Vulkan()
     , m_DescriptorPool(VK_NULL_HANDLE)
     , m_Image1()
     , m_Image2()
+    , m_TimestampQueryPool(VK_NULL_HANDLE)
+    , m_TimestampPeriod(0.0)
+    , m_TimestampMask(0)
 {
 }
 
@@ -666,6 +732,10 @@ void RenderAPI_Vulkan::ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityIn
 
         // alternative way to intercept API
         m_UnityVulkan->InterceptVulkanAPI("vkCmdBeginRenderPass", (PFN_vkVoidFunction)Hook_vkCmdBeginRenderPass);
+
+#if PLUGIN_FRAME_STATS
+        CreateTimestampQueryPool();
+#endif
         
         break;
     case kUnityGfxDeviceEventShutdown:
@@ -683,11 +753,21 @@ void RenderAPI_Vulkan::ProcessDeviceEvent(UnityGfxDeviceEventType type, IUnityIn
                 vkDestroyPipelineLayout(m_Instance.device, m_TrianglePipelineLayout, NULL);
                 m_TrianglePipelineLayout = VK_NULL_HANDLE;
             }
+            ImmediateDestroyVulkanBuffer(m_TextureStagingBuffer);
+            m_TextureStagingBuffer = VulkanBuffer();
 			ImmediateDestroyVulkanImage(m_Image1);
 			ImmediateDestroyVulkanImage(m_Image2);
+            m_Image1 = VulkanImage();
+            m_Image2 = VulkanImage();
+            if (m_TimestampQueryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(m_Instance.device, m_TimestampQueryPool, NULL);
+                m_TimestampQueryPool = VK_NULL_HANDLE;
+            }
             if (m_DescriptorPool != VK_NULL_HANDLE)
             {
                 vkDestroyDescriptorPool(m_Instance.device, m_DescriptorPool, NULL);
+                PluginMemory_Free(kPluginMemory_DescriptorPools, 0);
                 m_DescriptorPool = VK_NULL_HANDLE;
             }
             if (m_DescriptorSetLayout != VK_NULL_HANDLE)
@@ -794,6 +874,7 @@ void RenderAPI_Vulkan::CreateDescriptorPool()
     if (vkCreateDescriptorPool(m_Instance.device, &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create descriptor pool");
     }
+    PluginMemory_Allocate(kPluginMemory_DescriptorPools, 0);
 }
 
 void RenderAPI_Vulkan::CreateDescriptorSets()
@@ -942,6 +1023,8 @@ void RenderAPI_Vulkan::CreateVulkanImage(VulkanImage& image)
     if (vkAllocateMemory(m_Instance.device, &allocInfo, nullptr, &image.deviceMemory) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate image memory.");
     }
+    image.deviceMemorySize = allocInfo.allocationSize;
+    PluginMemory_Allocate(kPluginMemory_PluginImages, image.deviceMemorySize);
 
     vkBindImageMemory(m_Instance.device, image.image, image.deviceMemory, 0);
 }
@@ -1087,6 +1170,8 @@ void RenderAPI_Vulkan::CopyFromBuffer(VulkanBuffer& buffer, VkImage& image, uint
 
 void RenderAPI_Vulkan::CreateTextureImage(const unsigned char* pixels, const uint32_t width, const uint32_t height, VulkanImage& image)
 {
+    PLUGIN_TRACE_SCOPE("CreateTextureImage");
+
     image.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     image.format = VK_FORMAT_R8G8B8A8_SRGB;
     image.width = width;
@@ -1094,7 +1179,7 @@ void RenderAPI_Vulkan::CreateTextureImage(const unsigned char* pixels, const uin
 
     VkDeviceSize imageSize = width * height * 4;
     VulkanBuffer stagingBuffer;
-    if (!CreateVulkanBuffer(imageSize, &stagingBuffer, VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+    if (!CreateVulkanBuffer(imageSize, &stagingBuffer, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, kPluginMemory_Staging))
         throw std::runtime_error("Failed to create staging buffer");
 
     memcpy(stagingBuffer.mapped, pixels, static_cast<size_t>(stagingBuffer.sizeInBytes));
@@ -1120,8 +1205,14 @@ void RenderAPI_Vulkan::CreateTextureImage(const unsigned char* pixels, const uin
 
 void RenderAPI_Vulkan::CreateTextureImage(const char* filename, VulkanImage& image)
 {
+    PLUGIN_TRACE_SCOPE("CreateTextureImage");
+
     int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(filename, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    stbi_uc* pixels;
+    {
+        PLUGIN_TRACE_SCOPE("stbi_load");
+        pixels = stbi_load(filename, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    }
     if (!pixels) {
         throw std::runtime_error(filename);
     }
@@ -1133,7 +1224,7 @@ void RenderAPI_Vulkan::CreateTextureImage(const char* filename, VulkanImage& ima
 
     VkDeviceSize imageSize = texWidth * texHeight * 4;
     VulkanBuffer stagingBuffer;
-    if (!CreateVulkanBuffer(imageSize, &stagingBuffer, VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+    if (!CreateVulkanBuffer(imageSize, &stagingBuffer, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, kPluginMemory_Staging))
         throw std::runtime_error("Failed to create staging buffer");
 
     memcpy(stagingBuffer.mapped, pixels, static_cast<size_t>(stagingBuffer.sizeInBytes));
@@ -1159,7 +1250,7 @@ void RenderAPI_Vulkan::CreateTextureImage(const char* filename, VulkanImage& ima
 }
 
 
-bool RenderAPI_Vulkan::CreateVulkanBuffer(size_t sizeInBytes, VulkanBuffer* buffer, VkBufferUsageFlags usage)
+bool RenderAPI_Vulkan::CreateVulkanBuffer(size_t sizeInBytes, VulkanBuffer* buffer, VkBufferUsageFlags usage, PluginMemoryCategory memoryCategory)
 {
     if (sizeInBytes == 0)
         return false;
@@ -1175,6 +1266,7 @@ bool RenderAPI_Vulkan::CreateVulkanBuffer(size_t sizeInBytes, VulkanBuffer* buff
     bufferCreateInfo.size = sizeInBytes;
 
     *buffer = VulkanBuffer();
+    buffer->memoryCategory = memoryCategory;
 
     if (vkCreateBuffer(m_Instance.device, &bufferCreateInfo, NULL, &buffer->buffer) != VK_SUCCESS)
         return false;
@@ -1203,6 +1295,8 @@ bool RenderAPI_Vulkan::CreateVulkanBuffer(size_t sizeInBytes, VulkanBuffer* buff
         ImmediateDestroyVulkanBuffer(*buffer);
         return false;
     }
+    buffer->deviceMemorySize = memoryAllocateInfo.allocationSize;
+    PluginMemory_Allocate(memoryCategory, buffer->deviceMemorySize);
 
     if (vkMapMemory(m_Instance.device, buffer->deviceMemory, 0, VK_WHOLE_SIZE, 0, &buffer->mapped) != VK_SUCCESS)
     {
@@ -1218,7 +1312,6 @@ bool RenderAPI_Vulkan::CreateVulkanBuffer(size_t sizeInBytes, VulkanBuffer* buff
 
     buffer->sizeInBytes = sizeInBytes;
     buffer->deviceMemoryFlags = physicalDeviceProperties.memoryTypes[memoryTypeIndex].propertyFlags;
-    buffer->deviceMemorySize = memoryAllocateInfo.allocationSize;
 
     return true;
 }
@@ -1228,7 +1321,10 @@ void RenderAPI_Vulkan::ImmediateDestroyVulkanImage(const VulkanImage& image)
 	if (image.image != VK_NULL_HANDLE)
 		vkDestroyImage(m_Instance.device, image.image, NULL);
 	if (image.deviceMemory != VK_NULL_HANDLE)
+	{
 		vkFreeMemory(m_Instance.device, image.deviceMemory, NULL);
+		PluginMemory_Free(kPluginMemory_PluginImages, image.deviceMemorySize);
+	}
 	if (image.imageView != VK_NULL_HANDLE)
 		vkDestroyImageView(m_Instance.device, image.imageView, NULL);
 	if (image.sampler != VK_NULL_HANDLE)
@@ -1244,12 +1340,17 @@ void RenderAPI_Vulkan::ImmediateDestroyVulkanBuffer(const VulkanBuffer& buffer)
         vkUnmapMemory(m_Instance.device, buffer.deviceMemory);
 
     if (buffer.deviceMemory != VK_NULL_HANDLE)
+    {
         vkFreeMemory(m_Instance.device, buffer.deviceMemory, NULL);
+        PluginMemory_Free(buffer.memoryCategory, buffer.deviceMemorySize);
+    }
 }
 
 
 void RenderAPI_Vulkan::SafeDestroy(unsigned long long frameNumber, const VulkanBuffer& buffer)
 {
+    if (buffer.deviceMemory != VK_NULL_HANDLE)
+        PluginMemory_QueueFree(buffer.memoryCategory, buffer.deviceMemorySize);
     m_DeleteQueue[frameNumber].push_back(buffer);
 }
 
@@ -1268,7 +1369,11 @@ void RenderAPI_Vulkan::GarbageCollect(bool force /*= false*/)
         if (it->first <= recordingState.safeFrameNumber)
         {
             for (size_t i = 0; i < it->second.size(); ++i)
+            {
+                if (it->second[i].deviceMemory != VK_NULL_HANDLE)
+                    PluginMemory_DequeueFree(it->second[i].memoryCategory, it->second[i].deviceMemorySize);
                 ImmediateDestroyVulkanBuffer(it->second[i]);
+            }
             m_DeleteQueue.erase(it++);
         }
         else
@@ -1276,6 +1381,116 @@ void RenderAPI_Vulkan::GarbageCollect(bool force /*= false*/)
     }
 }
 
+void RenderAPI_Vulkan::CreateTimestampQueryPool()
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_Instance.physicalDevice, &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_Instance.physicalDevice, &queueFamilyCount, NULL);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_Instance.physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    // The GPU timers are optional, quietly go without them if the queue can't write timestamps
+    if (m_Instance.queueFamilyIndex >= queueFamilyCount || properties.limits.timestampPeriod <= 0.0f)
+        return;
+    const uint32_t validBits = queueFamilies[m_Instance.queueFamilyIndex].timestampValidBits;
+    if (validBits == 0)
+        return;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = kGpuTimerFrameCount * kGpuPassCount * 2;
+    if (vkCreateQueryPool(m_Instance.device, &poolInfo, NULL, &m_TimestampQueryPool) != VK_SUCCESS)
+    {
+        m_TimestampQueryPool = VK_NULL_HANDLE;
+        return;
+    }
+
+    m_TimestampPeriod = properties.limits.timestampPeriod;
+    m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    for (int i = 0; i < kGpuTimerFrameCount; ++i)
+    {
+        m_GpuTimerFrames[i].state = kGpuTimer_NeedsReset;
+        m_GpuTimerFrames[i].frameNumber = 0;
+        m_GpuTimerFrames[i].writtenPasses = 0;
+    }
+}
+
+void RenderAPI_Vulkan::UpdateGpuTimers(const UnityVulkanRecordingState& recordingState)
+{
+    if (m_TimestampQueryPool == VK_NULL_HANDLE)
+        return;
+
+    static const PluginStage kPassStages[kGpuPassCount] = { kPluginStage_GpuEndModifyTexture, kPluginStage_GpuDrawSimpleTriangles };
+
+    for (int i = 0; i < kGpuTimerFrameCount; ++i)
+    {
+        GpuTimerFrame& frame = m_GpuTimerFrames[i];
+        if (frame.state == kGpuTimer_Recording && frame.frameNumber <= recordingState.safeFrameNumber && frame.frameNumber < recordingState.currentFrameNumber)
+        {
+            // The GPU is done with the frame, so its results are available without waiting
+            for (int pass = 0; pass < kGpuPassCount; ++pass)
+            {
+                if (!(frame.writtenPasses & (1u << pass)))
+                    continue;
+                uint64_t timestamps[2];
+                const uint32_t firstQuery = (i * kGpuPassCount + pass) * 2;
+                if (vkGetQueryPoolResults(m_Instance.device, m_TimestampQueryPool, firstQuery, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+                    continue;
+                const uint64_t ticks = (timestamps[1] - timestamps[0]) & m_TimestampMask;
+                PLUGIN_STATS_ADD_GPU_SAMPLE(kPassStages[pass], (unsigned long long)(ticks * m_TimestampPeriod));
+            }
+            frame.state = kGpuTimer_NeedsReset;
+        }
+
+        if (frame.state == kGpuTimer_NeedsReset && recordingState.subPassIndex < 0)
+        {
+            vkCmdResetQueryPool(recordingState.commandBuffer, m_TimestampQueryPool, i * kGpuPassCount * 2, kGpuPassCount * 2);
+            frame.state = kGpuTimer_Ready;
+        }
+    }
+}
+
+bool RenderAPI_Vulkan::BeginGpuTimer(const UnityVulkanRecordingState& recordingState, GpuPass pass, uint32_t* outQuery)
+{
+    if (m_TimestampQueryPool == VK_NULL_HANDLE)
+        return false;
+
+    // Use the frame's slot, or claim a reset one. Without either this pass goes untimed
+    // this frame, e.g. when the GPU is more than kGpuTimerFrameCount frames behind.
+    int slot = -1;
+    for (int i = 0; i < kGpuTimerFrameCount && slot < 0; ++i)
+    {
+        if (m_GpuTimerFrames[i].state == kGpuTimer_Recording && m_GpuTimerFrames[i].frameNumber == recordingState.currentFrameNumber)
+            slot = i;
+    }
+    for (int i = 0; i < kGpuTimerFrameCount && slot < 0; ++i)
+    {
+        if (m_GpuTimerFrames[i].state == kGpuTimer_Ready)
+        {
+            m_GpuTimerFrames[i].state = kGpuTimer_Recording;
+            m_GpuTimerFrames[i].frameNumber = recordingState.currentFrameNumber;
+            m_GpuTimerFrames[i].writtenPasses = 0;
+            slot = i;
+        }
+    }
+    // A query can only be written once between resets
+    if (slot < 0 || (m_GpuTimerFrames[slot].writtenPasses & (1u << pass)))
+        return false;
+
+    m_GpuTimerFrames[slot].writtenPasses |= 1u << pass;
+    *outQuery = (slot * kGpuPassCount + pass) * 2;
+    vkCmdWriteTimestamp(recordingState.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampQueryPool, *outQuery);
+    return true;
+}
+
+void RenderAPI_Vulkan::EndGpuTimer(const UnityVulkanRecordingState& recordingState, uint32_t query)
+{
+    vkCmdWriteTimestamp(recordingState.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampQueryPool, query + 1);
+}
+
 void RenderAPI_Vulkan::DrawSimpleTriangles(const float worldMatrix[16], int triangleCount, const void* verticesFloat3Byte4)
 {
      // not needed, we already configured the event to be inside a render pass
@@ -1285,6 +1500,8 @@ void RenderAPI_Vulkan::DrawSimpleTriangles(const float worldMatrix[16], int tria
     if (!m_UnityVulkan->CommandRecordingState(&recordingState, kUnityVulkanGraphicsQueueAccess_DontCare))
         return;
 
+    UpdateGpuTimers(recordingState);
+
     // Unity does not destroy render passes, so this is safe regarding ABA-problem
     if (recordingState.renderPass != m_TrianglePipelineRenderPass)
     {
@@ -1298,28 +1515,35 @@ void RenderAPI_Vulkan::DrawSimpleTriangles(const float worldMatrix[16], int tria
     if (m_TrianglePipeline != VK_NULL_HANDLE && m_TrianglePipelineLayout != VK_NULL_HANDLE)
     {
         VulkanBuffer buffer;
-        if (!CreateVulkanBuffer(24 * 3 * triangleCount, &buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+        if (!CreateVulkanBuffer(24 * 3 * triangleCount, &buffer, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, kPluginMemory_TransientVertex))
             return;
 
-        memcpy(buffer.mapped, verticesFloat3Byte4, static_cast<size_t>(buffer.sizeInBytes));
-        if (!(buffer.deviceMemoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
         {
-            VkMappedMemoryRange range;
-            range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-            range.pNext = NULL;
-            range.memory = buffer.deviceMemory;
-            range.offset = 0;
-            range.size = buffer.deviceMemorySize;
-            vkFlushMappedMemoryRanges(m_Instance.device, 1, &range);
+            PLUGIN_TRACE_SCOPE("triangle vertex upload");
+            memcpy(buffer.mapped, verticesFloat3Byte4, static_cast<size_t>(buffer.sizeInBytes));
+            if (!(buffer.deviceMemoryFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+            {
+                VkMappedMemoryRange range;
+                range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+                range.pNext = NULL;
+                range.memory = buffer.deviceMemory;
+                range.offset = 0;
+                range.size = buffer.deviceMemorySize;
+                vkFlushMappedMemoryRanges(m_Instance.device, 1, &range);
+            }
         }
 
         // Record a series of commands that will be submitted to the queue
+        uint32_t timerQuery;
+        const bool timed = BeginGpuTimer(recordingState, kGpuPass_DrawSimpleTriangles, &timerQuery);
         const VkDeviceSize offset = 0;
         vkCmdBindPipeline(recordingState.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_TrianglePipeline);
         vkCmdBindVertexBuffers(recordingState.commandBuffer, 0, 1, &buffer.buffer, &offset);
         vkCmdPushConstants(recordingState.commandBuffer, m_TrianglePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, 64, (const void*)worldMatrix);
         vkCmdBindDescriptorSets(recordingState.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_TrianglePipelineLayout, 0, 1, m_DescriptorSets.data(), 0, nullptr);
         vkCmdDraw(recordingState.commandBuffer, triangleCount * 3, 1, 0, 0);
+        if (timed)
+            EndGpuTimer(recordingState, timerQuery);
 
         SafeDestroy(recordingState.currentFrameNumber, buffer);
     }
@@ -1327,52 +1551,151 @@ void RenderAPI_Vulkan::DrawSimpleTriangles(const float worldMatrix[16], int tria
     GarbageCollect();
 }
 
-void* RenderAPI_Vulkan::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int* outRowPitch)
+void* RenderAPI_Vulkan::CreateTextureStagingBuffer(size_t bytes)
 {
-    *outRowPitch = textureWidth * 4;
-    const size_t stagingBufferSizeRequirements = *outRowPitch * textureHeight;
-
     UnityVulkanRecordingState recordingState;
     if (!m_UnityVulkan->CommandRecordingState(&recordingState, kUnityVulkanGraphicsQueueAccess_DontCare))
         return NULL;
 
     SafeDestroy(recordingState.currentFrameNumber, m_TextureStagingBuffer);
     m_TextureStagingBuffer = VulkanBuffer();
-    if (!CreateVulkanBuffer(stagingBufferSizeRequirements, &m_TextureStagingBuffer, VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+    if (!CreateVulkanBuffer(bytes, &m_TextureStagingBuffer, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, kPluginMemory_Staging))
         return NULL;
 
     return m_TextureStagingBuffer.mapped;
 }
 
-void RenderAPI_Vulkan::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, int rowPitch, void* dataPtr)
+// Records the copies of regions of the staging buffer into the textures, all in one run of vkCmdCopyBufferToImage
+void RenderAPI_Vulkan::CopyTextureStagingBuffer(const TextureCopy* copies, int copyCount)
 {
     // cannot do resource uploads inside renderpass
     m_UnityVulkan->EnsureOutsideRenderPass();
 
-    UnityVulkanImage image;
-    if (!m_UnityVulkan->AccessTexture(textureHandle, UnityVulkanWholeImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, kUnityVulkanResourceAccess_PipelineBarrier, &image))
-        return;
+    // Access every texture first, so that Unity's layout barriers are all recorded ahead of the copies
+    std::vector<VkImage> images(copyCount, VK_NULL_HANDLE);
+    for (int i = 0; i < copyCount; ++i)
+    {
+        UnityVulkanImage image;
+        if (m_UnityVulkan->AccessTexture(copies[i].textureHandle, UnityVulkanWholeImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, kUnityVulkanResourceAccess_PipelineBarrier, &image))
+            images[i] = image.image;
+    }
 
     UnityVulkanRecordingState recordingState;
     if (!m_UnityVulkan->CommandRecordingState(&recordingState, kUnityVulkanGraphicsQueueAccess_DontCare))
         return;
 
+    // Outside of the render pass, the GPU timers can be reset here
+    UpdateGpuTimers(recordingState);
+    uint32_t timerQuery;
+    const bool timed = BeginGpuTimer(recordingState, kGpuPass_EndModifyTexture, &timerQuery);
+    {
+        PLUGIN_TRACE_SCOPE("vkCmdCopyBufferToImage");
+        for (int i = 0; i < copyCount; ++i)
+        {
+            if (images[i] != VK_NULL_HANDLE)
+                vkCmdCopyBufferToImage(recordingState.commandBuffer, m_TextureStagingBuffer.buffer, images[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    copies[i].regionCount, copies[i].regions);
+        }
+    }
+    if (timed)
+        EndGpuTimer(recordingState, timerQuery);
+}
+
+static VkBufferImageCopy MakeTextureCopyRegion(VkDeviceSize bufferOffset, uint32_t bufferRowLength, int x, int y, int width, int height)
+{
     VkBufferImageCopy region;
     region.bufferImageHeight = 0;
-    region.bufferRowLength = 0;
-    region.bufferOffset = 0;
-    region.imageOffset.x = 0;
-    region.imageOffset.y = 0;
+    region.bufferRowLength = bufferRowLength; // in texels of the image format
+    region.bufferOffset = bufferOffset;
+    region.imageOffset.x = x;
+    region.imageOffset.y = y;
     region.imageOffset.z = 0;
-    region.imageExtent.width = textureWidth;
-    region.imageExtent.height = textureHeight;
+    region.imageExtent.width = width;
+    region.imageExtent.height = height;
     region.imageExtent.depth = 1;
     region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
     region.imageSubresource.mipLevel = 0;
-    vkCmdCopyBufferToImage(recordingState.commandBuffer, m_TextureStagingBuffer.buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    return region;
+}
+
+void* RenderAPI_Vulkan::BeginModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int* outRowPitch)
+{
+    *outRowPitch = textureWidth * GetPluginTextureFormatBytesPerPixel(format);
+    return CreateTextureStagingBuffer(size_t(*outRowPitch) * textureHeight);
+}
+
+void RenderAPI_Vulkan::EndModifyTexture(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format, int rowPitch, void* dataPtr)
+{
+    const VkBufferImageCopy region = MakeTextureCopyRegion(0, rowPitch / GetPluginTextureFormatBytesPerPixel(format), 0, 0, textureWidth, textureHeight);
+    const TextureCopy copy = { textureHandle, &region, 1 };
+    CopyTextureStagingBuffer(&copy, 1);
+}
+
+// bufferOffset has to be a multiple of 4 and of the texel size
+static const int kTextureRectAlignment = 4;
+
+void* RenderAPI_Vulkan::BeginModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+    const PluginTextureRect* rects, int rectCount, PluginTextureRectMemory* outMemory)
+{
+    const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+    void* mapped = CreateTextureStagingBuffer(LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, kTextureRectAlignment, NULL, NULL));
+    if (mapped)
+        LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, kTextureRectAlignment, (unsigned char*)mapped, outMemory);
+    return mapped;
+}
+
+void RenderAPI_Vulkan::EndModifyTextureRegion(void* textureHandle, int textureWidth, int textureHeight, PluginTextureFormat format,
+    const PluginTextureRect* rects, int rectCount, void* dataPtr)
+{
+    // All rects in one vkCmdCopyBufferToImage
+    const int bytesPerPixel = GetPluginTextureFormatBytesPerPixel(format);
+    std::vector<PluginTextureRectMemory> memory(rectCount);
+    LayoutPluginTextureRects(rects, rectCount, bytesPerPixel, 1, kTextureRectAlignment, (unsigned char*)dataPtr, memory.data());
+    std::vector<VkBufferImageCopy> regions(rectCount);
+    for (int i = 0; i < rectCount; ++i)
+    {
+        const VkDeviceSize offset = VkDeviceSize(memory[i].pixels - (unsigned char*)dataPtr);
+        regions[i] = MakeTextureCopyRegion(offset, memory[i].rowPitch / bytesPerPixel, rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+    }
+    const TextureCopy copy = { textureHandle, regions.data(), uint32_t(rectCount) };
+    CopyTextureStagingBuffer(&copy, 1);
+}
+
+void* RenderAPI_Vulkan::BeginModifyTextures(const PluginTextureUpdate* updates, int updateCount, PluginTextureRectMemory* outMemory)
+{
+    void* mapped = CreateTextureStagingBuffer(LayoutPluginTextureUpdates(updates, updateCount, 1, kTextureRectAlignment, NULL, NULL));
+    if (mapped)
+        LayoutPluginTextureUpdates(updates, updateCount, 1, kTextureRectAlignment, (unsigned char*)mapped, outMemory);
+    return mapped;
+}
+
+void RenderAPI_Vulkan::EndModifyTextures(const PluginTextureUpdate* updates, int updateCount, void* dataPtr)
+{
+    std::vector<PluginTextureRectMemory> memory(updateCount);
+    LayoutPluginTextureUpdates(updates, updateCount, 1, kTextureRectAlignment, (unsigned char*)dataPtr, memory.data());
+    std::vector<VkBufferImageCopy> regions(updateCount);
+    for (int i = 0; i < updateCount; ++i)
+    {
+        const PluginTextureRect& rect = updates[i].rect;
+        const VkDeviceSize offset = VkDeviceSize(memory[i].pixels - (unsigned char*)dataPtr);
+        regions[i] = MakeTextureCopyRegion(offset, memory[i].rowPitch / GetPluginTextureFormatBytesPerPixel(updates[i].format), rect.x, rect.y, rect.width, rect.height);
+    }
+
+    // One vkCmdCopyBufferToImage per texture, with all of its rects
+    std::vector<TextureCopy> copies;
+    for (int i = 0; i < updateCount; ++i)
+    {
+        if (copies.empty() || copies.back().textureHandle != updates[i].textureHandle)
+        {
+            const TextureCopy copy = { updates[i].textureHandle, &regions[i], 0 };
+            copies.push_back(copy);
+        }
+        ++copies.back().regionCount;
+    }
+    CopyTextureStagingBuffer(copies.data(), int(copies.size()));
 }
 
 void* RenderAPI_Vulkan::BeginModifyVertexBuffer(void* bufferHandle, size_t* outBufferSize)
@@ -1411,6 +1734,7 @@ void RenderAPI_Vulkan::EndModifyVertexBuffer(void* bufferHandle)
 
     if (!(buffer.memory.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
     {
+        PLUGIN_TRACE_SCOPE("vkFlushMappedMemoryRanges");
         VkMappedMemoryRange range;
         range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
         range.pNext = NULL;
@@ -1421,4 +1745,42 @@ void RenderAPI_Vulkan::EndModifyVertexBuffer(void* bufferHandle)
     }
 }
 
+bool RenderAPI_Vulkan::BeginModifyVertexBuffers(void* const* bufferHandles, int bufferCount, PluginVertexBufferMemory* outMemory)
+{
+    // Every buffer is recreated and mapped on its own; they stay writable until EndModifyVertexBuffers
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        outMemory[i].size = 0;
+        outMemory[i].data = BeginModifyVertexBuffer(bufferHandles[i], &outMemory[i].size);
+    }
+    return true;
+}
+
+void RenderAPI_Vulkan::EndModifyVertexBuffers(void* const* bufferHandles, int bufferCount, const PluginVertexBufferMemory* memory)
+{
+    // The non-coherent ones all in one vkFlushMappedMemoryRanges
+    std::vector<VkMappedMemoryRange> ranges;
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        UnityVulkanBuffer buffer;
+        if (!memory[i].data || !m_UnityVulkan->AccessBuffer(bufferHandles[i], 0, 0, kUnityVulkanResourceAccess_ObserveOnly, &buffer))
+            continue;
+        if (buffer.memory.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+            continue;
+
+        VkMappedMemoryRange range;
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.pNext = NULL;
+        range.memory = buffer.memory.memory;
+        range.offset = buffer.memory.offset;
+        range.size = buffer.memory.size;
+        ranges.push_back(range);
+    }
+    if (!ranges.empty())
+    {
+        PLUGIN_TRACE_SCOPE("vkFlushMappedMemoryRanges");
+        vkFlushMappedMemoryRanges(m_Instance.device, uint32_t(ranges.size()), ranges.data());
+    }
+}
+
 #endif // #if SUPPORT_VULKAN
@@ -2,9 +2,19 @@
 
 #include "PlatformBase.h"
 #include "RenderAPI.h"
+#include "PluginKernels.h"
+#include "PluginMemory.h"
+#include "PluginMeshes.h"
+#include "PluginPipeline.h"
+#include "PluginStats.h"
+#include "PluginTextures.h"
+#include "PluginTiles.h"
+#include "PluginTrace.h"
+#include "PluginWorkers.h"
 
 #include <assert.h>
 #include <math.h>
+#include <mutex>
 #include <vector>
 
 
@@ -13,7 +23,14 @@
 
 static float g_Time;
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTimeFromUnity (float t) { g_Time = t; }
+static void BeginPipelinedFrame(float time);
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTimeFromUnity (float t)
+{
+	g_Time = t;
+	if (PluginPipeline_IsEnabled())
+		BeginPipelinedFrame(t);
+}
 
 
 
@@ -23,6 +40,7 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTimeFromUnity (flo
 static void* g_TextureHandle = NULL;
 static int   g_TextureWidth  = 0;
 static int   g_TextureHeight = 0;
+static PluginTextureFormat g_TextureFormat = kPluginTextureFormat_RGBA8;
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureFromUnity(void* textureHandle, int w, int h)
 {
@@ -32,23 +50,116 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureFromUnity(v
 	g_TextureHandle = textureHandle;
 	g_TextureWidth = w;
 	g_TextureHeight = h;
+	g_TextureFormat = kPluginTextureFormat_RGBA8;
+}
+
+// Same, for a texture of one of the PluginTextureFormat formats (RGBA8 for unknown values).
+// R8 and RG8 textures take a quarter and a half of the upload bandwidth of RGBA8 ones.
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureFromUnityWithFormat(void* textureHandle, int w, int h, int format)
+{
+	SetTextureFromUnity(textureHandle, w, h);
+	if (format >= 0 && format < kPluginTextureFormatCount)
+		g_TextureFormat = PluginTextureFormat(format);
+}
+
+
+// --------------------------------------------------------------------------
+// AddTextureFromUnity / UpdateTextureFromUnity / RemoveTextureFromUnity: more textures for the
+// render event to fill, by id. All of them are regenerated every event and uploaded together
+// with the texture above, as one batch. Add returns the new id, or 0 if the texture can't be
+// used; Update points an id at another texture, e.g. after the script recreated it. Formats
+// are PluginTextureFormat values, RGBA8 for unknown ones. See PluginTextures.h.
+
+static PluginTextureDesc MakeTextureDesc(void* textureHandle, int w, int h, int format)
+{
+	PluginTextureDesc desc;
+	desc.textureHandle = textureHandle;
+	desc.width = w;
+	desc.height = h;
+	desc.format = format >= 0 && format < kPluginTextureFormatCount ? PluginTextureFormat(format) : kPluginTextureFormat_RGBA8;
+	return desc;
+}
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API AddTextureFromUnity(void* textureHandle, int w, int h, int format)
+{
+	return PluginTextures_Add(MakeTextureDesc(textureHandle, w, h, format));
+}
+
+extern "C" UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API UpdateTextureFromUnity(int id, void* textureHandle, int w, int h, int format)
+{
+	return PluginTextures_Update(id, MakeTextureDesc(textureHandle, w, h, format));
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RemoveTextureFromUnity(int id)
+{
+	PluginTextures_Remove(id);
+}
+
+
+// --------------------------------------------------------------------------
+// SetTextureDirtyRectsFromUnity: limits the texture update of each render event to the given
+// rects, passed as x, y, width, height ints each. They stay in effect until the next call;
+// a count of 0 goes back to updating the whole texture.
+
+static std::mutex g_TextureDirtyRectsMutex;
+static std::vector<PluginTextureRect> g_TextureDirtyRects;
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureDirtyRectsFromUnity(const int* rects, int rectCount)
+{
+	std::lock_guard<std::mutex> lock(g_TextureDirtyRectsMutex);
+	g_TextureDirtyRects.resize(rects && rectCount > 0 ? rectCount : 0);
+	for (size_t i = 0; i < g_TextureDirtyRects.size(); ++i)
+	{
+		PluginTextureRect& rect = g_TextureDirtyRects[i];
+		rect.x = rects[i * 4 + 0];
+		rect.y = rects[i * 4 + 1];
+		rect.width = rects[i * 4 + 2];
+		rect.height = rects[i * 4 + 3];
+	}
+}
+
+
+// --------------------------------------------------------------------------
+// SetTextureTileUpdateFromUnity: spreads the texture update over several frames. The texture
+// is split into tileSize x tileSize tiles and each render event updates the next ones in
+// turn, as many as fit into maxBytesPerFrame of pixel data and maxMillisecondsPerFrame of
+// update time (0 for no limit; at least one tile per frame). A tileSize of 0 goes back to
+// updating the whole texture every frame. While tiling is on, the dirty rects are not used.
+// See PluginTiles.h.
+
+static std::mutex g_TextureTileSettingsMutex;
+static TextureTileSettings g_TextureTileSettings = { 0, 0, 0.0f };
+static TextureTileScheduler s_TextureTileScheduler;
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetTextureTileUpdateFromUnity(int tileSize, int maxBytesPerFrame, float maxMillisecondsPerFrame)
+{
+	std::lock_guard<std::mutex> lock(g_TextureTileSettingsMutex);
+	g_TextureTileSettings.tileSize = tileSize;
+	g_TextureTileSettings.maxBytesPerFrame = maxBytesPerFrame;
+	g_TextureTileSettings.maxMillisecondsPerFrame = maxMillisecondsPerFrame;
 }
 
 
 // --------------------------------------------------------------------------
 // SetMeshBuffersFromUnity, an example function we export which is called by one of the scripts.
 
+// The render event deforms the source while holding g_VertexSourceMutex, so replacing it
+// waits until no render event uses the previous one anymore
+static std::mutex g_VertexSourceMutex;
 static void* g_VertexBufferHandle = NULL;
 static int g_VertexBufferVertexCount;
+static VertexSourcePtr g_VertexSource;
 
-struct MeshVertex
+static void SetVertexSource(void* vertexBufferHandle, int vertexCount, const VertexSourcePtr& source)
 {
-	float pos[3];
-	float normal[3];
-	float color[4];
-	float uv[2];
-};
-static std::vector<MeshVertex> g_VertexSource;
+	{
+		std::lock_guard<std::mutex> lock(g_VertexSourceMutex);
+		g_VertexBufferHandle = vertexBufferHandle;
+		g_VertexBufferVertexCount = vertexCount;
+		g_VertexSource = source;
+	}
+	PluginPipeline_SetVertexSource(source);
+}
 
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetMeshBuffersFromUnity(void* vertexBufferHandle, int vertexCount, float* sourceVertices, float* sourceNormals, float* sourceUV)
@@ -56,29 +167,106 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetMeshBuffersFromUni
 	// A script calls this at initialization time; just remember the pointer here.
 	// Will update buffer data each frame from the plugin rendering event (buffer update
 	// needs to happen on the rendering thread).
-	g_VertexBufferHandle = vertexBufferHandle;
-	g_VertexBufferVertexCount = vertexCount;
 
 	// The script also passes original source mesh data. The reason is that the vertex buffer we'll be modifying
 	// will be marked as "dynamic", and on many platforms this means we can only write into it, but not read its previous
 	// contents. In this example we're not creating meshes from scratch, but are just altering original mesh data --
 	// so remember it. The script just passes pointers to regular C# array contents.
-	g_VertexSource.resize(vertexCount);
-	for (int i = 0; i < vertexCount; ++i)
+	std::shared_ptr<MeshVertexStreams> source = std::make_shared<MeshVertexStreams>();
+	CopyMeshSource(*source, vertexCount, sourceVertices, sourceNormals, sourceUV);
+	SetVertexSource(vertexBufferHandle, vertexCount, source);
+}
+
+
+// --------------------------------------------------------------------------
+// SetMeshVertexArrayFromUnity: like SetMeshBuffersFromUnity, but the source mesh is one
+// interleaved array of MeshSourceVertex (float3 position, float3 normal, float2 uv), e.g. a
+// NativeArray's GetUnsafeReadOnlyPtr(), and the plugin only keeps a pointer to it: nothing
+// is copied, however large the mesh. The script keeps the array alive and unchanged until it
+// sets another source (or a NULL one); that call returns once the plugin has stopped reading
+// the array, so it can be disposed right after.
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetMeshVertexArrayFromUnity(void* vertexBufferHandle, int vertexCount, void* sourceVertices)
+{
+	std::shared_ptr<MeshVertexStreams> source = std::make_shared<MeshVertexStreams>();
+	ReferenceMeshSource(*source, vertexCount, (const MeshSourceVertex*)sourceVertices);
+	SetVertexSource(vertexBufferHandle, vertexCount, source);
+}
+
+
+// --------------------------------------------------------------------------
+// AddMeshFromUnity / AddMeshVertexArrayFromUnity / SetMeshDeformationFromUnity / RemoveMeshFromUnity:
+// more meshes for the render event to deform, by id, each from its own source like the mesh above
+// (copied from separate arrays, or referenced as one MeshSourceVertex array). All of them are
+// deformed every event, together with the mesh above, and written as one batch. Add returns the
+// new id, or 0 if the mesh can't be used. A mesh is deformed for the time * speed + timeOffset;
+// SetMeshDeformationFromUnity returns false for unknown ids. Removing a mesh returns once the
+// plugin has stopped reading its source. See PluginMeshes.h.
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API AddMeshFromUnity(void* vertexBufferHandle, int vertexCount, float* sourceVertices, float* sourceNormals, float* sourceUV)
+{
+	if (!vertexBufferHandle || vertexCount <= 0 || !sourceVertices || !sourceNormals || !sourceUV)
+		return 0;
+	std::shared_ptr<MeshVertexStreams> source = std::make_shared<MeshVertexStreams>();
+	CopyMeshSource(*source, vertexCount, sourceVertices, sourceNormals, sourceUV);
+	return PluginMeshes_Add(vertexBufferHandle, source);
+}
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API AddMeshVertexArrayFromUnity(void* vertexBufferHandle, int vertexCount, void* sourceVertices)
+{
+	if (!sourceVertices)
+		return 0;
+	std::shared_ptr<MeshVertexStreams> source = std::make_shared<MeshVertexStreams>();
+	ReferenceMeshSource(*source, vertexCount, (const MeshSourceVertex*)sourceVertices);
+	return PluginMeshes_Add(vertexBufferHandle, source);
+}
+
+extern "C" UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API SetMeshDeformationFromUnity(int id, float speed, float timeOffset)
+{
+	const PluginMeshDeformation deformation = { speed, timeOffset };
+	return PluginMeshes_SetDeformation(id, deformation);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API RemoveMeshFromUnity(int id)
+{
+	PluginMeshes_Remove(id);
+}
+
+
+// --------------------------------------------------------------------------
+// SetPluginPipelinedGeneration: with a non-zero value, SetTimeFromUnity starts generating that
+// frame's texture pixels and deformed vertices on a background thread, and the render event
+// only copies them into the texture and vertex buffer. Dirty rects and tiled updates keep
+// generating their parts of the texture in the render event. See PluginPipeline.h.
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API SetPluginPipelinedGeneration(int enabled)
+{
+	PluginPipeline_SetEnabled(enabled != 0);
+}
+
+static void BeginPipelinedFrame(float time)
+{
+	PipelineFrameDesc desc;
+	desc.time = time;
+	desc.textureWidth = 0;
+	desc.textureHeight = 0;
+	desc.textureFormat = g_TextureFormat;
+
+	bool wholeTexture;
+	{
+		std::lock_guard<std::mutex> lock(g_TextureDirtyRectsMutex);
+		wholeTexture = g_TextureDirtyRects.empty();
+	}
+	{
+		std::lock_guard<std::mutex> lock(g_TextureTileSettingsMutex);
+		wholeTexture = wholeTexture && g_TextureTileSettings.tileSize <= 0;
+	}
+	if (g_TextureHandle && wholeTexture)
 	{
-		MeshVertex& v = g_VertexSource[i];
-		v.pos[0] = sourceVertices[0];
-		v.pos[1] = sourceVertices[1];
-		v.pos[2] = sourceVertices[2];
-		v.normal[0] = sourceNormals[0];
-		v.normal[1] = sourceNormals[1];
-		v.normal[2] = sourceNormals[2];
-		v.uv[0] = sourceUV[0];
-		v.uv[1] = sourceUV[1];
-		sourceVertices += 3;
-		sourceNormals += 3;
-		sourceUV += 2;
+		desc.textureWidth = g_TextureWidth;
+		desc.textureHeight = g_TextureHeight;
 	}
+	PluginPipeline_BeginFrame(desc);
 }
 
 
@@ -111,6 +299,10 @@ extern "C" void	UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnit
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
 	s_Graphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
+	PluginPipeline_Shutdown();
+	PluginWorkers_Shutdown();
+	PluginTextures_RemoveAll();
+	PluginMeshes_RemoveAll();
 }
 
 #if UNITY_WEBGL
@@ -155,6 +347,7 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 		delete s_CurrentAPI;
 		s_CurrentAPI = NULL;
 		s_DeviceType = kUnityGfxRendererNull;
+		ReleasePlasmaTables();
 	}
 }
 
@@ -167,135 +360,6 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 // that value.
 
 
-static void DrawColoredTriangle()
-{
-	// Draw a colored triangle. Note that colors will come out differently
-	// in D3D and OpenGL, for example, since they expect color bytes
-	// in different ordering.
-	struct MyVertex
-	{
-		float x, y, z;
-		unsigned int color;
-		float u, v;
-
-	};
-	MyVertex verts[6] =
-	{
-		{ -0.5f, -0.5f,  0, 0xFFff0000, 0.f, 0.f},
-		{  0.5f, -0.5f,  0, 0xFF00ff00, 1.f, 0.f},
-		{  0.5f,  0.5f,  0, 0xFF0000ff, 1.f, 1.f},
-		{ -0.5f, -0.5f,  0, 0xFFff0000, 0.f, 0.f},
-		{  0.5f,  0.5f,  0, 0xFF0000ff, 1.f, 1.f},
-		{ -0.5f,  0.5f,  0, 0xFF00ff00, 0.f, 1.f},
-	};
-
-	// Transformation matrix: rotate around Z axis based on time.
-	float phi = g_Time; // time set externally from Unity script
-	float cosPhi = cosf(phi);
-	float sinPhi = sinf(phi);
-	float depth = 0.7f;
-	float finalDepth = s_CurrentAPI->GetUsesReverseZ() ? 1.0f - depth : depth;
-	float worldMatrix[16] = {
-		cosPhi,-sinPhi,0,0,
-		sinPhi,cosPhi,0,0,
-		0,0,1,0,
-		0,0,finalDepth,1,
-	};
-
-	s_CurrentAPI->DrawSimpleTriangles(worldMatrix, 2, verts);
-}
-
-
-static void ModifyTexturePixels()
-{
-	void* textureHandle = g_TextureHandle;
-	int width = g_TextureWidth;
-	int height = g_TextureHeight;
-	if (!textureHandle)
-		return;
-
-	int textureRowPitch;
-	void* textureDataPtr = s_CurrentAPI->BeginModifyTexture(textureHandle, width, height, &textureRowPitch);
-	if (!textureDataPtr)
-		return;
-
-	const float t = g_Time * 4.0f;
-
-	unsigned char* dst = (unsigned char*)textureDataPtr;
-	for (int y = 0; y < height; ++y)
-	{
-		unsigned char* ptr = dst;
-		for (int x = 0; x < width; ++x)
-		{
-			// Simple "plasma effect": several combined sine waves
-			int vv = int(
-				(127.0f + (127.0f * sinf(x / 7.0f + t))) +
-				(127.0f + (127.0f * sinf(y / 5.0f - t))) +
-				(127.0f + (127.0f * sinf((x + y) / 6.0f - t))) +
-				(127.0f + (127.0f * sinf(sqrtf(float(x*x + y*y)) / 4.0f - t)))
-				) / 4;
-
-			// Write the texture pixel
-			ptr[0] = vv;
-			ptr[1] = vv;
-			ptr[2] = vv;
-			ptr[3] = vv;
-
-			// To next pixel (our pixels are 4 bpp)
-			ptr += 4;
-		}
-
-		// To next image row
-		dst += textureRowPitch;
-	}
-
-	s_CurrentAPI->EndModifyTexture(textureHandle, width, height, textureRowPitch, textureDataPtr);
-}
-
-
-static void ModifyVertexBuffer()
-{
-	void* bufferHandle = g_VertexBufferHandle;
-	int vertexCount = g_VertexBufferVertexCount;
-	if (!bufferHandle)
-		return;
-
-	size_t bufferSize;
-	void* bufferDataPtr = s_CurrentAPI->BeginModifyVertexBuffer(bufferHandle, &bufferSize);
-	if (!bufferDataPtr)
-		return;
-	int vertexStride = int(bufferSize / vertexCount);
-
-	// Unity should return us a buffer that is the size of `vertexCount * sizeof(MeshVertex)`
-	// If that's not the case then we should quit to avoid unexpected results.
-	// This can happen if https://docs.unity3d.com/ScriptReference/Mesh.GetNativeVertexBufferPtr.html returns
-	// a pointer to a buffer with an unexpected layout.
-	if (static_cast<unsigned int>(vertexStride) != sizeof(MeshVertex))
-		return;
-
-	const float t = g_Time * 3.0f;
-
-	char* bufferPtr = (char*)bufferDataPtr;
-	// modify vertex Y position with several scrolling sine waves,
-	// copy the rest of the source data unmodified
-	for (int i = 0; i < vertexCount; ++i)
-	{
-		const MeshVertex& src = g_VertexSource[i];
-		MeshVertex& dst = *(MeshVertex*)bufferPtr;
-		dst.pos[0] = src.pos[0];
-		dst.pos[1] = src.pos[1] + sinf(src.pos[0] * 1.1f + t) * 0.4f + sinf(src.pos[2] * 0.9f - t) * 0.3f;
-		dst.pos[2] = src.pos[2];
-		dst.normal[0] = src.normal[0];
-		dst.normal[1] = src.normal[1];
-		dst.normal[2] = src.normal[2];
-		dst.uv[0] = src.uv[0];
-		dst.uv[1] = src.uv[1];
-		bufferPtr += vertexStride;
-	}
-
-	s_CurrentAPI->EndModifyVertexBuffer(bufferHandle);
-}
-
 static void drawToPluginTexture()
 {
 	s_CurrentAPI->drawToPluginTexture();
@@ -303,6 +367,7 @@ static void drawToPluginTexture()
 
 static void drawToRenderTexture()
 {
+	PLUGIN_STAGE_TIMER(kPluginStage_DrawToRenderTexture);
 	s_CurrentAPI->drawToRenderTexture();
 }
 
@@ -314,10 +379,77 @@ static void UNITY_INTERFACE_API OnRenderEvent(int eventID)
 
 	if (eventID == 1)
 	{
-        drawToRenderTexture();
-        DrawColoredTriangle();
-        ModifyTexturePixels();
-        ModifyVertexBuffer();
+		// Render thread copies, so that the script can change them while the update runs
+		static std::vector<PluginTextureRect> dirtyRects;
+		{
+			std::lock_guard<std::mutex> lock(g_TextureDirtyRectsMutex);
+			dirtyRects = g_TextureDirtyRects;
+		}
+		static std::vector<PluginTextureUpdate> textureUpdates;
+		textureUpdates.clear();
+		PluginTextures_AppendUpdates(textureUpdates);
+		{
+			std::lock_guard<std::mutex> lock(g_TextureTileSettingsMutex);
+			s_TextureTileScheduler.SetSettings(g_TextureTileSettings);
+		}
+
+		PLUGIN_TRACE_NEXT_FRAME();
+		PLUGIN_STATS_BEGIN_FRAME();
+		{
+			PLUGIN_STAGE_TIMER(kPluginStage_RenderEvent);
+			const PipelineFrame* frame = NULL;
+			if (PluginPipeline_IsEnabled())
+			{
+				PLUGIN_STAGE_TIMER(kPluginStage_WaitForPipelineFrame);
+				frame = PluginPipeline_AcquireFrame();
+			}
+
+			drawToRenderTexture();
+			DrawColoredTriangle(s_CurrentAPI, g_Time);
+			if (frame && !frame->pixels.empty() && frame->desc.textureWidth == g_TextureWidth && frame->desc.textureHeight == g_TextureHeight &&
+				frame->desc.textureFormat == g_TextureFormat)
+				UploadTexturePixels(s_CurrentAPI, g_TextureHandle, g_TextureWidth, g_TextureHeight, g_TextureFormat, &frame->pixels[0], frame->rowPitch);
+			else if (s_TextureTileScheduler.IsEnabled())
+				ModifyTextureTiles(s_CurrentAPI, g_TextureHandle, g_TextureWidth, g_TextureHeight, g_TextureFormat, g_Time, s_TextureTileScheduler);
+			else if (g_TextureHandle)
+			{
+				// Otherwise the texture joins the registered ones' batch, as a whole or as its dirty rects
+				PluginTextureUpdate update = { g_TextureHandle, g_TextureWidth, g_TextureHeight, g_TextureFormat, { 0, 0, g_TextureWidth, g_TextureHeight } };
+				if (dirtyRects.empty())
+					textureUpdates.push_back(update);
+				for (size_t i = 0; i < dirtyRects.size(); ++i)
+				{
+					update.rect = dirtyRects[i];
+					textureUpdates.push_back(update);
+				}
+			}
+			ModifyTextureBatch(s_CurrentAPI, textureUpdates.data(), int(textureUpdates.size()), g_Time);
+			{
+				// The registered meshes, and the mesh above unless it was generated ahead, as one batch
+				static std::vector<MeshBufferUpdate> meshUpdates;
+				meshUpdates.clear();
+				PluginMeshes_AcquireUpdates(g_Time, meshUpdates);
+				{
+					std::lock_guard<std::mutex> lock(g_VertexSourceMutex);
+					// Only vertices of the current source: another mesh of the same size may have replaced it
+					// since the frame was generated
+					if (frame && frame->vertexSource && frame->vertexSource == g_VertexSource &&
+						int(frame->vertices.size()) == g_VertexBufferVertexCount)
+						UploadVertexBuffer(s_CurrentAPI, g_VertexBufferHandle, g_VertexBufferVertexCount, frame->vertices.data());
+					else if (g_VertexSource)
+					{
+						const MeshBufferUpdate update = { g_VertexBufferHandle, g_VertexSource.get(), g_Time };
+						meshUpdates.push_back(update);
+					}
+					ModifyVertexBufferBatch(s_CurrentAPI, meshUpdates.data(), int(meshUpdates.size()));
+				}
+				PluginMeshes_ReleaseUpdates();
+			}
+
+			if (frame)
+				PluginPipeline_ReleaseFrame();
+		}
+		PLUGIN_STATS_END_FRAME();
 	}
 
 	if (eventID == 2)
@@ -343,10 +475,122 @@ extern "C" UNITY_INTERFACE_EXPORT void* UNITY_INTERFACE_API GetNativeTexture()
 
 extern "C" UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API CreateTextures(const char* image1, const char* image2)
 {
+	PLUGIN_TRACE_SCOPE("createTextures");
 	return s_CurrentAPI->createTextures(image1, image2);
 }
 
 
+// --------------------------------------------------------------------------
+// GetPluginFrameStats, polled by scripts to see where the render event spends its time.
+// Fills up to maxStages entries (indexed by PluginStage, see PluginStats.h) and returns
+// the number of frames they cover; 0 when built with PLUGIN_FRAME_STATS=0.
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API GetPluginFrameStats(PluginStageStats* outStats, int maxStages)
+{
+#if PLUGIN_FRAME_STATS
+	if (outStats && maxStages > 0)
+		return PluginStats_Summarize(outStats, maxStages);
+#endif
+	return 0;
+}
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API GetPluginStageCount()
+{
+	return kPluginStageCount;
+}
+
+extern "C" UNITY_INTERFACE_EXPORT const char* UNITY_INTERFACE_API GetPluginStageName(int stage)
+{
+	return PluginStats_GetStageName(stage);
+}
+
+
+// --------------------------------------------------------------------------
+// GetPluginMemoryStats, polled by scripts to watch the device memory the plugin allocates.
+// Fills up to maxCategories entries (indexed by PluginMemoryCategory, see PluginMemory.h)
+// and returns how many were filled. Only the Vulkan backend reports allocations.
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API GetPluginMemoryStats(PluginMemoryStats* outStats, int maxCategories)
+{
+	if (!outStats || maxCategories <= 0)
+		return 0;
+	return PluginMemory_GetStats(outStats, maxCategories);
+}
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API GetPluginMemoryCategoryCount()
+{
+	return kPluginMemoryCategoryCount;
+}
+
+extern "C" UNITY_INTERFACE_EXPORT const char* UNITY_INTERFACE_API GetPluginMemoryCategoryName(int category)
+{
+	return PluginMemory_GetCategoryName(category);
+}
+
+
+// --------------------------------------------------------------------------
+// StartPluginTrace / StopPluginTrace: record a Chrome trace (chrome://tracing, ui.perfetto.dev)
+// of the plugin's work into 'path', see PluginTrace.h. Start returns false if a trace is already
+// running, the file can't be created, or the plugin was built with PLUGIN_TRACE=0.
+
+extern "C" UNITY_INTERFACE_EXPORT bool UNITY_INTERFACE_API StartPluginTrace(const char* path)
+{
+#if PLUGIN_TRACE
+	return PluginTrace_Start(path);
+#else
+	return false;
+#endif
+}
+
+extern "C" UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API StopPluginTrace()
+{
+#if PLUGIN_TRACE
+	PluginTrace_Stop();
+#endif
+}
+
+
+// --------------------------------------------------------------------------
+// SetPluginWorkerThreadCount: how many threads the texture fill and the vertex deformation
+// are spread over, including the render thread; 1 keeps it all on the render thread, 0
+// restores the default (one per hardware thread, at most 8). See PluginWorkers.h.
+
+extern "C" UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API SetPluginWorkerThreadCount(int count)
+{
+	PluginWorkers_SetThreadCount(count);
+}
+
+extern "C" UNITY_INTERFACE_EXPORT int UNITY_INTERFACE_API GetPluginWorkerThreadCount()
+{
+	return PluginWorkers_GetThreadCount();
+}
+
+
+// --------------------------------------------------------------------------
+// SetPluginVertexParallelThreshold: meshes with at least this many vertices are deformed in
+// chunks on the worker threads, smaller ones on the render thread alone; 0 restores the
+// default (32k vertices, a provisional value). See DeformMeshVertices in PluginKernels.h.
+
+extern "C" UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API SetPluginVertexParallelThreshold(int vertexCount)
+{
+	SetVertexParallelThreshold(vertexCount);
+}
+
+
+// --------------------------------------------------------------------------
+// SetPluginMathPrecision: 0 evaluates the sines of the texture and vertex kernels exactly
+// (the default), 1 with a shorter polynomial that is within 7.5e-5 of them. Only the scalar,
+// SSE2 and AVX2 kernels evaluate sines per pixel or vertex and honour it, the SIMD plasma ones
+// gaining the most. The default table kernels take them from precomputed tables and ignore
+// it, so it only shows with a kernel forced, or for textures too large for the table kernel's
+// cache (see PluginKernels.h). See PluginMath.h.
+
+extern "C" UNITY_INTERFACE_EXPORT void UNITY_INTERFACE_API SetPluginMathPrecision(int precision)
+{
+	SetKernelMathPrecision(PluginMathPrecision(precision));
+}
+
+
 // --------------------------------------------------------------------------
 // DX12 plugin specific
 // --------------------------------------------------------------------------
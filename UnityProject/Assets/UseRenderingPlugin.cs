@@ -2,6 +2,7 @@ using UnityEngine;
 using System;
 using System.IO;
 using System.Collections;
+using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using UnityEngine.Rendering;
 using UnityEngine.Networking;
@@ -32,6 +33,65 @@ public class UseRenderingPlugin : MonoBehaviour
 #endif
     private static extern void SetTextureFromUnity(System.IntPtr texture, int w, int h);
 
+    // Pixel formats the plugin can fill; values match PluginTextureFormat in RenderAPI.h
+    public enum PluginTextureFormat
+    {
+        RGBA8 = 0,
+        BGRA8 = 1,
+        R8 = 2,
+        RG8 = 3,
+    }
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetTextureFromUnityWithFormat(System.IntPtr texture, int w, int h, int format);
+
+    // Dirty rects of the texture as x, y, width, height ints; the plugin then only regenerates
+    // and uploads those parts of the texture, until the next call (0 rects: the whole texture)
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetTextureDirtyRectsFromUnity(int[] rects, int rectCount);
+
+    // Spreads the texture update over several frames: each frame updates the next tileSize x tileSize
+    // tiles that fit into the byte and time budgets (0: no limit); a tileSize of 0 turns it off
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetTextureTileUpdateFromUnity(int tileSize, int maxBytesPerFrame, float maxMillisecondsPerFrame);
+
+    // More textures for the plugin to fill, updated in the same batch as the one above; returns
+    // the texture's id, or 0 if the plugin can't use it
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int AddTextureFromUnity(System.IntPtr texture, int w, int h, int format);
+
+    // Points an id at another texture, e.g. after recreating it; false if the id is unknown
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    [return: MarshalAs(UnmanagedType.I1)]
+    private static extern bool UpdateTextureFromUnity(int id, System.IntPtr texture, int w, int h, int format);
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void RemoveTextureFromUnity(int id);
+
     // We'll pass native pointer to the mesh vertex buffer.
     // Also passing source unmodified mesh data.
     // The plugin will fill vertex data from native code.
@@ -42,6 +102,57 @@ public class UseRenderingPlugin : MonoBehaviour
 #endif
     private static extern void SetMeshBuffersFromUnity(IntPtr vertexBuffer, int vertexCount, IntPtr sourceVertices, IntPtr sourceNormals, IntPtr sourceUVs);
 
+    // Or one interleaved array of SourceVertex, which the plugin keeps a pointer to instead of
+    // copying it: it has to stay alive and unchanged until another source (or none) is set.
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetMeshVertexArrayFromUnity(IntPtr vertexBuffer, int vertexCount, IntPtr sourceVertices);
+
+    // More meshes for the plugin to deform, in the same batch as the one above; return the mesh's
+    // id, or 0 if the plugin can't use it. The vertex array form keeps a pointer like the one above.
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int AddMeshFromUnity(IntPtr vertexBuffer, int vertexCount, IntPtr sourceVertices, IntPtr sourceNormals, IntPtr sourceUVs);
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int AddMeshVertexArrayFromUnity(IntPtr vertexBuffer, int vertexCount, IntPtr sourceVertices);
+
+    // Each mesh's waves run at time * speed + timeOffset; false if the id is unknown
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    [return: MarshalAs(UnmanagedType.I1)]
+    private static extern bool SetMeshDeformationFromUnity(int id, float speed, float timeOffset);
+
+    // Returns once the plugin no longer reads the mesh's source
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void RemoveMeshFromUnity(int id);
+
+    // This is equivalent to MeshSourceVertex in PluginKernels.h
+    [StructLayout(LayoutKind.Sequential)]
+    private struct SourceVertex
+    {
+        public Vector3 position;
+        public Vector3 normal;
+        public Vector2 uv;
+    }
+
 #if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
     [DllImport("__Internal")]
 #else
@@ -60,6 +171,164 @@ public class UseRenderingPlugin : MonoBehaviour
     [DllImport("RenderingPlugin")]
     private static extern void CreateTextures(string image1, string image2);
 
+    // Per-stage timings of the plugin's render event over its last frames, see PluginStats.h.
+    [StructLayout(LayoutKind.Sequential)]
+    private struct PluginStageStats
+    {
+        public float minMicroseconds;
+        public float avgMicroseconds;
+        public float p99Microseconds;
+        public float maxMicroseconds;
+        public int frameCount;
+    }
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int GetPluginFrameStats([Out] PluginStageStats[] outStats, int maxStages);
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int GetPluginStageCount();
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern IntPtr GetPluginStageName(int stage);
+
+    // Device memory the plugin allocated itself, per category, see PluginMemory.h.
+    [StructLayout(LayoutKind.Sequential)]
+    private struct PluginMemoryStats
+    {
+        public ulong liveBytes;
+        public ulong peakBytes;
+        public ulong pendingDeletionBytes;
+        public ulong allocationCount;
+        public ulong liveAllocationCount;
+    }
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int GetPluginMemoryStats([Out] PluginMemoryStats[] outStats, int maxCategories);
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern int GetPluginMemoryCategoryCount();
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern IntPtr GetPluginMemoryCategoryName(int category);
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    [return: MarshalAs(UnmanagedType.I1)]
+    private static extern bool StartPluginTrace(string path);
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void StopPluginTrace();
+
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetPluginWorkerThreadCount(int count);
+
+    // Meshes with at least this many vertices are deformed on the plugin's worker threads; 0 uses its default
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetPluginVertexParallelThreshold(int vertexCount);
+
+    // Non-zero: SetTimeFromUnity starts generating the frame's texture and vertices on a background
+    // thread, and the render event only copies them into the texture and vertex buffer
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetPluginPipelinedGeneration(int enabled);
+
+    // 0: exact sines in the texture and vertex kernels, 1: fast ones, within 7.5e-5
+#if (PLATFORM_IOS || PLATFORM_TVOS || PLATFORM_BRATWURST || PLATFORM_SWITCH) && !UNITY_EDITOR
+    [DllImport("__Internal")]
+#else
+    [DllImport("RenderingPlugin")]
+#endif
+    private static extern void SetPluginMathPrecision(int precision);
+
+    // If set, the plugin records a Chrome trace (chrome://tracing, ui.perfetto.dev) of its work
+    // into this file while the script is enabled; relative paths are under persistentDataPath
+    public string traceFile = "";
+
+    // Threads the plugin fills the texture and deforms the mesh with, including the render thread; 0 uses its default
+    public int workerThreads = 0;
+
+    // Smallest mesh the plugin deforms on several threads; 0 uses its default
+    public int parallelVertexThreshold = 0;
+
+    // Pass the source mesh as one array the plugin only references, so large meshes load without a copy
+    public bool meshVertexArray = false;
+    private GCHandle gcSourceVertices;
+
+    // Generate each frame's texture and vertices ahead of the render event, off the render thread
+    public bool pipelinedGeneration = false;
+
+    // Evaluate the kernels' sines with a cheaper polynomial; the difference doesn't show. Only the
+    // scalar and SIMD kernels use it, not the default table ones (see SetPluginMathPrecision)
+    public bool fastMath = false;
+
+    // Format of the texture the plugin fills; the plasma is grayscale, so R8 shows the same
+    // pattern (in red) for a quarter of the upload bandwidth
+    public PluginTextureFormat textureFormat = PluginTextureFormat.RGBA8;
+
+    // Parts of the texture the plugin updates each frame; empty updates all of it
+    public RectInt[] textureDirtyRects = new RectInt[0];
+
+    // Update the texture a few tiles per frame instead of all at once (0: off), within these budgets
+    public int textureTileSize = 0;
+    public int textureTileBytesPerFrame = 0;
+    public float textureTileMillisecondsPerFrame = 0.0f;
+
+    // Renderers that get a plugin texture each, filled in the same upload as this object's
+    public Renderer[] extraTextureTargets = new Renderer[0];
+    private int[] extraTextureIds = new int[0];
+
+    // Meshes deformed together with this object's, each offset in time by extraMeshTimeOffset more
+    public MeshFilter[] extraMeshes = new MeshFilter[0];
+    public float extraMeshTimeOffset = 0.25f;
+    private int[] extraMeshIds = new int[0];
+    private List<GCHandle> gcExtraMeshVertices = new List<GCHandle>();
+
+    // Log the plugin's stage timings and memory counters every statsLogInterval frames
+    public bool logPluginFrameStats = false;
+    public int statsLogInterval = 300;
+
 
     public string image1;
     public string image2;
@@ -118,6 +387,18 @@ public class UseRenderingPlugin : MonoBehaviour
             CreateRenderTexture();
         }
 
+        if (!string.IsNullOrEmpty(traceFile))
+        {
+            string tracePath = Path.Combine(Application.persistentDataPath, traceFile);
+            if (StartPluginTrace(tracePath))
+                Debug.Log("Recording plugin trace to " + tracePath);
+        }
+
+        SetPluginWorkerThreadCount(workerThreads);
+        SetPluginVertexParallelThreshold(parallelVertexThreshold);
+        SetPluginPipelinedGeneration(pipelinedGeneration ? 1 : 0);
+        SetPluginMathPrecision(fastMath ? 1 : 0);
+
         CreateTextures("", "");
 
         // Debug Texture
@@ -128,12 +409,37 @@ public class UseRenderingPlugin : MonoBehaviour
         sphere.GetComponent<Renderer>().material.mainTexture = renderTex;
 
         CreateTextureAndPassToPlugin();
+        SetTextureDirtyRects(textureDirtyRects);
+        SetTextureTileUpdateFromUnity(textureTileSize, textureTileBytesPerFrame, textureTileMillisecondsPerFrame);
+        AddExtraTexturesToPlugin();
         SendMeshBuffersToPlugin();
+        AddExtraMeshesToPlugin();
         yield return StartCoroutine("CallPluginAtEndOfFrames");
     }
 
     void OnDisable()
     {
+        if (!string.IsNullOrEmpty(traceFile))
+            StopPluginTrace();
+
+        foreach (int id in extraTextureIds)
+            RemoveTextureFromUnity(id);
+        extraTextureIds = new int[0];
+
+        foreach (int id in extraMeshIds)
+            RemoveMeshFromUnity(id);
+        extraMeshIds = new int[0];
+        foreach (GCHandle handle in gcExtraMeshVertices)
+            handle.Free();
+        gcExtraMeshVertices.Clear();
+
+        if (gcSourceVertices.IsAllocated)
+        {
+            // Returns once the plugin no longer reads the array
+            SetMeshVertexArrayFromUnity(IntPtr.Zero, 0, IntPtr.Zero);
+            gcSourceVertices.Free();
+        }
+
         if (SystemInfo.graphicsDeviceType == GraphicsDeviceType.Direct3D12)
         {
             // Signals the plugin that renderTex will be destroyed
@@ -141,27 +447,63 @@ public class UseRenderingPlugin : MonoBehaviour
         }
     }
 
-    private void CreateTextureAndPassToPlugin()
+    // Limits the plugin's texture updates to the given rects, from the next frame on
+    public void SetTextureDirtyRects(RectInt[] rects)
+    {
+        int[] values = new int[rects.Length * 4];
+        for (int i = 0; i < rects.Length; ++i)
+        {
+            values[i * 4 + 0] = rects[i].x;
+            values[i * 4 + 1] = rects[i].y;
+            values[i * 4 + 2] = rects[i].width;
+            values[i * 4 + 3] = rects[i].height;
+        }
+        SetTextureDirtyRectsFromUnity(values, rects.Length);
+    }
+
+    private Texture2D CreatePluginTexture()
     {
-        // Create a texture
-        Texture2D tex = new Texture2D(256, 256, TextureFormat.ARGB32, false);
+        TextureFormat format = TextureFormat.ARGB32;
+        if (textureFormat == PluginTextureFormat.BGRA8)
+            format = TextureFormat.BGRA32;
+        else if (textureFormat == PluginTextureFormat.R8)
+            format = TextureFormat.R8;
+        else if (textureFormat == PluginTextureFormat.RG8)
+            format = TextureFormat.RG16;
+        Texture2D tex = new Texture2D(256, 256, format, false);
         // Set point filtering just so we can see the pixels clearly
         tex.filterMode = FilterMode.Point;
         // Call Apply() so it's actually uploaded to the GPU
         tex.Apply();
+        return tex;
+    }
+
+    private void CreateTextureAndPassToPlugin()
+    {
+        Texture2D tex = CreatePluginTexture();
 
         // Set texture onto our material
         GetComponent<Renderer>().material.mainTexture = tex;
 
         // Pass texture pointer to the plugin
-        SetTextureFromUnity(tex.GetNativeTexturePtr(), tex.width, tex.height);
+        SetTextureFromUnityWithFormat(tex.GetNativeTexturePtr(), tex.width, tex.height, (int)textureFormat);
     }
 
-    private void SendMeshBuffersToPlugin()
+    private void AddExtraTexturesToPlugin()
     {
-        var filter = GetComponent<MeshFilter>();
-        var mesh = filter.mesh;
+        extraTextureIds = new int[extraTextureTargets.Length];
+        for (int i = 0; i < extraTextureTargets.Length; ++i)
+        {
+            if (extraTextureTargets[i] == null)
+                continue;
+            Texture2D tex = CreatePluginTexture();
+            extraTextureTargets[i].material.mainTexture = tex;
+            extraTextureIds[i] = AddTextureFromUnity(tex.GetNativeTexturePtr(), tex.width, tex.height, (int)textureFormat);
+        }
+    }
 
+    private static void PrepareMeshForPlugin(Mesh mesh)
+    {
         // This is equivalent to MeshVertex in RenderingPlugin.cpp
         var desiredVertexLayout = new[]
         {
@@ -178,12 +520,48 @@ public class UseRenderingPlugin : MonoBehaviour
         // for that to work we have to mark mesh as "dynamic" (which makes the buffers CPU writable --
         // by default they are immutable and only GPU-readable).
         mesh.MarkDynamic();
+    }
+
+    // Interleaves the source mesh for the vertex array form and pins it; the plugin keeps pointing
+    // into it, so it stays pinned until OnDisable.
+    private static GCHandle PinSourceVertices(Mesh mesh)
+    {
+        var vertices = mesh.vertices;
+        var normals = mesh.normals;
+        var uvs = mesh.uv;
+        var sourceVertices = new SourceVertex[mesh.vertexCount];
+        for (int i = 0; i < sourceVertices.Length; ++i)
+        {
+            sourceVertices[i].position = vertices[i];
+            sourceVertices[i].normal = normals[i];
+            sourceVertices[i].uv = uvs[i];
+        }
+        return GCHandle.Alloc(sourceVertices, GCHandleType.Pinned);
+    }
+
+    private void SendMeshBuffersToPlugin()
+    {
+        var filter = GetComponent<MeshFilter>();
+        var mesh = filter.mesh;
+        PrepareMeshForPlugin(mesh);
 
         // However, mesh being dynamic also means that the CPU on most platforms can not
         // read from the vertex buffer. Our plugin also wants original mesh data,
         // so let's pass it as pointers to regular C# arrays.
         // This bit shows how to pass array pointers to native plugins without doing an expensive
         // copy: you have to get a GCHandle, and get raw address of that.
+        if (meshVertexArray)
+        {
+            // Interleaved vertex data that is already in a NativeArray (e.g. from a loader or a
+            // job) can be passed the same way, with NativeArrayUnsafeUtility.GetUnsafeReadOnlyPtr.
+            // The previous array stays pinned until the plugin has switched to the new one.
+            GCHandle previousSourceVertices = gcSourceVertices;
+            gcSourceVertices = PinSourceVertices(mesh);
+            SetMeshVertexArrayFromUnity(mesh.GetNativeVertexBufferPtr(0), mesh.vertexCount, gcSourceVertices.AddrOfPinnedObject());
+            if (previousSourceVertices.IsAllocated)
+                previousSourceVertices.Free();
+            return;
+        }
         var vertices = mesh.vertices;
         var normals = mesh.normals;
         var uvs = mesh.uv;
@@ -198,8 +576,75 @@ public class UseRenderingPlugin : MonoBehaviour
         gcUV.Free();
     }
 
+    private void AddExtraMeshesToPlugin()
+    {
+        extraMeshIds = new int[extraMeshes.Length];
+        for (int i = 0; i < extraMeshes.Length; ++i)
+        {
+            if (extraMeshes[i] == null)
+                continue;
+            var mesh = extraMeshes[i].mesh;
+            PrepareMeshForPlugin(mesh);
+            if (meshVertexArray)
+            {
+                GCHandle gcVertices = PinSourceVertices(mesh);
+                gcExtraMeshVertices.Add(gcVertices);
+                extraMeshIds[i] = AddMeshVertexArrayFromUnity(mesh.GetNativeVertexBufferPtr(0), mesh.vertexCount, gcVertices.AddrOfPinnedObject());
+            }
+            else
+            {
+                GCHandle gcVertices = GCHandle.Alloc(mesh.vertices, GCHandleType.Pinned);
+                GCHandle gcNormals = GCHandle.Alloc(mesh.normals, GCHandleType.Pinned);
+                GCHandle gcUV = GCHandle.Alloc(mesh.uv, GCHandleType.Pinned);
+                extraMeshIds[i] = AddMeshFromUnity(mesh.GetNativeVertexBufferPtr(0), mesh.vertexCount, gcVertices.AddrOfPinnedObject(), gcNormals.AddrOfPinnedObject(), gcUV.AddrOfPinnedObject());
+                gcVertices.Free();
+                gcNormals.Free();
+                gcUV.Free();
+            }
+            if (extraMeshIds[i] != 0)
+                SetMeshDeformationFromUnity(extraMeshIds[i], 1.0f, extraMeshTimeOffset * (i + 1));
+        }
+    }
+
+    private void LogPluginFrameStats()
+    {
+        var stats = new PluginStageStats[GetPluginStageCount()];
+        int frameCount = GetPluginFrameStats(stats, stats.Length);
+        if (frameCount == 0)
+            return;
+
+        var text = new System.Text.StringBuilder();
+        text.AppendFormat("Plugin stage timings over the last {0} frames (us):\n", frameCount);
+        for (int i = 0; i < stats.Length; ++i)
+        {
+            if (stats[i].frameCount == 0)
+                continue;
+            text.AppendFormat("{0}: min {1:F1} avg {2:F1} p99 {3:F1} max {4:F1}\n", Marshal.PtrToStringAnsi(GetPluginStageName(i)),
+                stats[i].minMicroseconds, stats[i].avgMicroseconds, stats[i].p99Microseconds, stats[i].maxMicroseconds);
+        }
+        Debug.Log(text.ToString());
+    }
+
+    private void LogPluginMemoryStats()
+    {
+        var stats = new PluginMemoryStats[GetPluginMemoryCategoryCount()];
+        int categoryCount = GetPluginMemoryStats(stats, stats.Length);
+
+        var text = new System.Text.StringBuilder();
+        text.Append("Plugin device memory (bytes):\n");
+        for (int i = 0; i < categoryCount; ++i)
+        {
+            if (stats[i].allocationCount == 0)
+                continue;
+            text.AppendFormat("{0}: live {1} in {2} allocations, peak {3}, pending deletion {4}, {5} allocations total\n", Marshal.PtrToStringAnsi(GetPluginMemoryCategoryName(i)),
+                stats[i].liveBytes, stats[i].liveAllocationCount, stats[i].peakBytes, stats[i].pendingDeletionBytes, stats[i].allocationCount);
+        }
+        Debug.Log(text.ToString());
+    }
+
     // custom "time" for deterministic results
     int updateTimeCounter = 0;
+    int statsFrameCounter = 0;
 
     private IEnumerator CallPluginAtEndOfFrames()
     {
@@ -229,6 +674,13 @@ public class UseRenderingPlugin : MonoBehaviour
             {
                 GL.IssuePluginEvent(GetRenderEventFunc(), 2);
             }
+
+            if (logPluginFrameStats && ++statsFrameCounter >= statsLogInterval)
+            {
+                statsFrameCounter = 0;
+                LogPluginFrameStats();
+                LogPluginMemoryStats();
+            }
         }
     }
 }